@@ -27,129 +27,507 @@
 
 #include "Chronos.h"
 
+#include <cstdio>
+#include <map>
 
+#include <pthread.h>
 
-Chronos* Chronos::m_instance = nullptr;
+
+
+std::atomic<Chronos*> Chronos::m_instance(nullptr);
+std::mutex Chronos::m_instance_mutex;
+std::atomic<unsigned long> Chronos::m_generations(0);
 
 Chronos::Chronos() {
-    // Do nothing for now
-    this->m_processes.clear();
+    // Every instance gets a new generation, so thread caches pointing at a deleted instance are refreshed
+    m_generation = ++m_generations;
+    // Measure the clock frequency once, before anything is recorded
+    ChronosClock::calibrate();
+    m_trace_records = 0;
+    m_trace_written = 0;
+    m_trace_dropped = 0;
+    m_windows = 0;
+    m_counting.store(false);
+    m_text_reports.store(true);
+    m_binary_reports.store(false);
+    // Then measure what recording a call costs, to take it out of the reports and to size the sample periods
+    m_overhead.calibrate(*this);
+    m_compensate.store(true);
+    m_adaptive_functions.store(false);
+    m_sampler.set_timed_call_cost(m_overhead.get_timed_cost() * ChronosClock::get_seconds_per_tick());
+    // Forget the calibration's sites and buffer; a new generation makes the calling thread's cache let go of the buffer
+    m_threads.clear();
+    m_site_names.clear();
+    m_sites.clear();
+    m_generation = ++m_generations;
 }
 
 Chronos::~Chronos() {
-    // Do nothing for now
+    // The hooks would otherwise create a new instance on the next instrumented call
+    ChronosInstrument::set_enabled(false);
+    stop_monitor();
+    stop_trace();
+    stop_sharing();
+    // Allow a new instance to be created after this one is deleted
+    Chronos* self = this;
+    m_instance.compare_exchange_strong(self, nullptr);
 }
 
 Chronos* Chronos::get_instance() {
-    if (m_instance == nullptr){
-        m_instance = new Chronos();
+    Chronos* instance = m_instance.load(std::memory_order_acquire);
+    if (instance == nullptr){
+        std::lock_guard<std::mutex> lock(m_instance_mutex);
+        instance = m_instance.load(std::memory_order_relaxed);
+        if (instance == nullptr){
+            instance = new Chronos();
+            m_instance.store(instance, std::memory_order_release);
+        }// end of if
     } 
-    return m_instance;   
-}
-
-long Chronos::find_process(std::string func_name, std::string id) {
-    long counter = -1;
-    for (unsigned long i = 0; i < m_processes.size(); i++){
-        if(m_processes.at(i).get_name().compare(func_name) == 0){
-            if(m_processes.at(i).get_unique_id().compare(id) == 0){
-                counter = i;
-                break;
-            }// End of if
-        }// End of if
-    }// End of for loop
-    return counter;
-}
-
-
-void Chronos::aggregate_data() {
-    // This function will look through the list of processes, and create another list
-    // containing single instances of all the processes. i.e. It will add up all the individual information
-    // and create a single entry for every process it finds.
-    std::vector<ChronosProcess> aggregate;
-    std::list<std::string> functions;
-    std::vector<std::string> unique_functions;
-
-    // Create a unique vector storing only the names of the functions being called
-    // Convert to a list
-    for (ChronosProcess cp: m_processes){
-        functions.push_back(cp.get_name());
-    }// End of for
-
-    // Ensure there is only one of each function in the list
-    functions.sort();
-    functions.unique();
-
-    //Convert back to a vector
-    for (std::string func_name: functions){
-        unique_functions.push_back(func_name);
-    }// End of for
-
-    // Aggregate the times based on the number of occurrences of each function
-    // NOTE: These for loops take a bit more time
-    for(std::string func_name: unique_functions){
-        ChronosProcess new_cp = ChronosProcess(func_name);
-        bool has_id = false;
-        // Cycle through the list of functions found
-        for(ChronosProcess cp: m_processes){
-            // Only add the time if the processes are the same
-            if(cp.get_name().compare(new_cp.get_name()) == 0){  // Are the same
-                // Get the ID to use
-                if(!has_id){
-                    new_cp.set_unique_id(cp.get_unique_id());
-                }// end of if
-
-                // Add the functions total time to the ChronosProcess
-                new_cp.add_time(cp.get_total_time());
-            }
+    return instance;   
+}
+
+long Chronos::find_process(const std::string& func_name) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto found = m_sites.find(func_name);
+    if (found == m_sites.end()){
+        return -1;
+    }// End of if
+    return found->second;
+}
+
+
+long Chronos::register_site(std::string func_name, std::string id) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto found = m_sites.find(func_name);
+    if (found != m_sites.end()){
+        return found->second;
+    }// End of if
+    long location = static_cast<long>(m_site_names.size());
+    ChronosSiteName site = {m_names.store(func_name), m_names.store(id)};
+    m_site_names.push_back(site);
+    m_sites.emplace(site.name, location);
+    m_shared.add_site(location, site.name, site.id);
+    return location;
+}
+
+
+long Chronos::lookup_site(const std::string& func_name, const std::string& id, bool create) {
+    ChronosThread* thread = get_thread();
+    long location = thread->find_cached_site(func_name);
+    if (location < 0){
+        location = create ? register_site(func_name, id) : find_process(func_name);
+        if (location >= 0){
+            thread->cache_site(func_name, location);
+        }// end of if
+    }// end of if
+    return location;
+}
+
+
+ChronosThread* Chronos::register_thread() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_threads.push_back(std::make_unique<ChronosThread>(static_cast<long>(m_threads.size()), &m_sampler));
+    if (m_trace_records > 0){
+        m_trace.add_buffer(m_threads.back()->enable_trace(m_trace_records));
+    }// end of if
+    m_threads.back()->enable_counters(m_counting.load());
+    m_threads.back()->enable_shared(m_shared.is_open() ? &m_shared : nullptr);
+    return m_threads.back().get();
+}
+
+
+std::vector<ChronosProcess> Chronos::collect(long thread_id) {
+    std::vector<ChronosSiteName> sites;
+    std::vector<ChronosThread*> threads = list_threads(thread_id, sites);
+    std::vector<ChronosProcess> processes;
+    for (unsigned long site = 0; site < sites.size(); site++){
+        ChronosProcess merged;
+        merged.set_thread_id(thread_id);
+        for (ChronosThread* thread: threads){
+            ChronosProcess single;
+            if (thread->read_site(static_cast<long>(site), single)){
+                merged.merge(single);
+            }// end of if
         }// end of for
+        if (merged.get_total_calls() > 0){
+            // The names are only copied out of the arena for the sites that were called
+            merged.set_name(std::string(sites[site].name));
+            merged.set_unique_id(std::string(sites[site].id));
+            processes.push_back(std::move(merged));
+        }// end of if
+    }// end of for
+
+    // Keep the reports ordered by function name
+    std::sort(processes.begin(), processes.end(), [](ChronosProcess& a, ChronosProcess& b){
+        return a.get_name() < b.get_name();
+    });
+    return processes;
+}
 
-        // Add the new ChronosProcess to the aggregate
-        aggregate.push_back(new_cp);
-    }//end of for loop
 
-    // Clean the original processes add the aggregate to the end of the m_processes
-    functions.clear();
-    unique_functions.clear();
-    m_processes.clear();
-    for(unsigned long i = 0; i < aggregate.size(); i++){
-        m_processes.push_back(aggregate.at(i));
-    }//end of for
+std::vector<ChronosThread*> Chronos::list_threads(long thread_id, std::vector<ChronosSiteName>& sites) {
+    resolve_function_names();
+    // Only the lists are copied under the lock; the buffers and the names are read after it is released, as they live as long as the instance
+    std::lock_guard<std::mutex> lock(m_mutex);
+    sites = m_site_names;
+    std::vector<ChronosThread*> threads;
+    for (std::unique_ptr<ChronosThread>& thread: m_threads){
+        if (thread_id < 0 || thread->get_thread_id() == thread_id){
+            threads.push_back(thread.get());
+        }// end of if
+    }// end of for
+    return threads;
 }
 
 
 void Chronos::start(std::string func_name, std::string id, bool log) {
     // Only continue should the programmer wish to log the data
     if (log){
-        long location = find_process(func_name, id);
-        
-        if(location >= 0){
-            std::chrono::time_point<std::chrono::high_resolution_clock> time = std::chrono::high_resolution_clock::now();
-            m_processes.at(location).set_start_time(time);
-        }else{
-            ChronosProcess cp = ChronosProcess(func_name, id);
-            std::chrono::time_point<std::chrono::high_resolution_clock> time = std::chrono::high_resolution_clock::now();
-            cp.set_start_time(time);
-            m_processes.push_back(cp);
-        }
+        start(lookup_site(func_name, id, true));
     }// end of if
 }
 
 void Chronos::stop(std::string func_name, std::string id, bool log) {
     // Only continue should the programmer wish to log the data
     if (log){
-        // Create a new index if it's not found
-        long location = find_process(func_name, id);
+        // Do nothing should the process never have been started
+        long location = lookup_site(func_name, id, false);
         if(location >= 0){
-            std::chrono::time_point<std::chrono::high_resolution_clock> time = std::chrono::high_resolution_clock::now();
-            m_processes.at(location).set_stop_time(time);
+            stop(location);
+        }// end of if
+    }// end of if
+}
+
+
+void Chronos::set_sample_period(long period) {
+    m_sampler.set_default_period(period);
+}
+
+
+void Chronos::set_sample_period(long site, long period) {
+    m_sampler.set_period(site, period);
+}
+
+
+void Chronos::set_adaptive_sampling(bool enabled, double overhead_budget) {
+    m_sampler.set_adaptive(enabled, overhead_budget);
+}
+
+
+void Chronos::set_overhead_compensation(bool enabled) {
+    m_compensate.store(enabled);
+}
+
+
+void Chronos::set_report_formats(bool text, bool binary) {
+    m_text_reports.store(text);
+    m_binary_reports.store(binary);
+}
+
+
+ChronosOverhead& Chronos::get_overhead() {
+    return m_overhead;
+}
+
+
+bool Chronos::enable_counters(bool enabled) {
+    std::string state;
+    if (enabled){
+        // Try the counters on this thread first, so the feature is turned off cleanly where they are not available
+        ChronosCounters counters;
+        if (!counters.open()){
+            enabled = false;
+            state = "unavailable";
+        }else{
+            state = counters.uses_rdpmc() ? "read with rdpmc" : "read with a system call";
+        }// end of if else
+    }// end of if
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_counter_state = enabled ? state : (state.empty() && !m_counter_state.empty() ? "turned off" : state);
+    m_counting.store(enabled);
+    for (std::unique_ptr<ChronosThread>& thread: m_threads){
+        thread->enable_counters(enabled);
+    }// end of for
+    return enabled || state.empty();
+}
+
+
+void Chronos::enable_cpu_time(long site, bool enabled) {
+    m_sampler.set_cpu_timed(site, enabled);
+}
+
+
+bool Chronos::enable_allocations(bool enabled) {
+    return ChronosAllocations::set_enabled(enabled);
+}
+
+
+bool Chronos::enable_instrumentation(bool enabled, double overhead_budget) {
+    // Only the functions the hooks find adapt their period, the sites registered by hand keep theirs
+    if (enabled && overhead_budget > 0){
+        m_sampler.set_overhead_budget(overhead_budget);
+    }// end of if
+    m_adaptive_functions.store(enabled && overhead_budget > 0);
+    return ChronosInstrument::set_enabled(enabled);
+}
+
+
+void Chronos::instrument_include(std::string pattern) {
+    ChronosInstrument::include(pattern);
+}
+
+
+void Chronos::instrument_exclude(std::string pattern) {
+    ChronosInstrument::exclude(pattern);
+}
+
+
+long Chronos::register_function(const void* function) {
+    char address[32];
+    std::snprintf(address, sizeof(address), "%p", function);
+    long location = register_site(address);
+    if (m_adaptive_functions.load()){
+        m_sampler.set_adaptive(location, true);
+    }// end of if
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_unnamed_functions.push_back({location, function});
+    return location;
+}
+
+
+void Chronos::resolve_function_names() {
+    std::vector<std::pair<long, const void*>> functions;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        functions.swap(m_unnamed_functions);
+    }
+    if (functions.empty()){
+        return;
+    }// end of if
+    // dladdr and the demangler are slow and allocate, so they run without the lock
+    std::vector<std::string> names;
+    for (std::pair<long, const void*>& function: functions){
+        names.push_back(ChronosInstrument::get_name(function.second));
+    }// end of for
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (unsigned long i = 0; i < functions.size(); i++){
+        long location = functions[i].first;
+        std::string name = names[i];
+        if (name == m_site_names[location].name){
+            continue;
+        }// end of if
+        // Overloads are told apart by their signature, but two copies of a constructor or an inline function share a name
+        if (m_sites.find(name) != m_sites.end()){
+            char address[32];
+            std::snprintf(address, sizeof(address), " [%p]", functions[i].second);
+            name += address;
+        }// end of if
+        m_sites.erase(m_site_names[location].name);
+        m_site_names[location].name = m_names.store(name);
+        m_sites.emplace(m_site_names[location].name, location);
+        m_shared.add_site(location, m_site_names[location].name, m_site_names[location].id);
+    }// end of for
+}
+
+
+void Chronos::record_span(const ChronosSpanRecord& record) {
+    m_spans.add(record);
+}
+
+
+void Chronos::add_benchmark(ChronosBenchmarkResult& result) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_benchmarks.push_back(result);
+}
+
+
+bool Chronos::share(std::string name, long max_processes, long max_sites) {
+    // Forked children need a slot of their own, which the fork handlers see to
+    static std::once_flag fork_handlers;
+    std::call_once(fork_handlers, [](){
+        pthread_atfork(&Chronos::prepare_fork, &Chronos::after_fork_parent, &Chronos::after_fork_child);
+    });
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_shared.open(name, max_processes, max_sites)){
+        return false;
+    }// end of if
+    for (unsigned long site = 0; site < m_site_names.size(); site++){
+        m_shared.add_site(static_cast<long>(site), m_site_names[site].name, m_site_names[site].id);
+    }// end of for
+    for (std::unique_ptr<ChronosThread>& thread: m_threads){
+        thread->enable_shared(&m_shared);
+    }// end of for
+    return true;
+}
+
+
+void Chronos::stop_sharing() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_shared.is_open()){
+        return;
+    }// end of if
+    for (std::unique_ptr<ChronosThread>& thread: m_threads){
+        thread->enable_shared(nullptr);
+    }// end of for
+    m_shared.close();
+}
+
+
+bool Chronos::write_shared_profile(std::string name, std::string csv_path, std::string txt_path) {
+    std::vector<ChronosSharedProfile> profiles;
+    if (!ChronosShared::read(name, profiles)){
+        return false;
+    }// end of if
+
+    // Merge the processes by function name
+    std::map<std::string, ChronosProcess> merged;
+    long running = 0;
+    long crashed = 0;
+    for (ChronosSharedProfile& profile: profiles){
+        running += profile.state == "running" ? 1 : 0;
+        crashed += profile.state == "crashed" ? 1 : 0;
+        for (ChronosProcess& process: profile.processes){
+            auto found = merged.find(process.get_name());
+            if (found == merged.end()){
+                found = merged.emplace(process.get_name(), ChronosProcess(process.get_name(), process.get_unique_id())).first;
+                found->second.set_thread_id(-1);
+            }// end of if
+            found->second.merge(process);
+        }// end of for
+    }// end of for
+
+    ChronosProcess cp;
+    namespace fs = std::filesystem;
+    for (std::string path: {csv_path, txt_path}){
+        fs::path parent = fs::path(path).parent_path();
+        if (!parent.empty()){
+            fs::create_directories(parent);
+        }// end of if
+    }// end of for
+
+    // The merged rows come first, marked All in the PID column, followed by the rows of every process
+    std::ofstream csv_file(csv_path.c_str(), std::ios::out);
+    if(csv_file.is_open()){
+        csv_file << "PID,State," << cp.get_header_csv() << '\n';
+        for(auto& entry: merged){
+            csv_file << "All,," << entry.second.to_csv() << '\n';
+        }// end of for
+        for(ChronosSharedProfile& profile: profiles){
+            for(ChronosProcess& process: profile.processes){
+                csv_file << profile.pid << ',' << profile.state << ',' << process.to_csv() << '\n';
+            }// end of for
+        }// end of for
+    }else{
+        std::string error_string = "Error writing file to: \"" + csv_path+"\"";
+        perror(error_string.c_str()); 
+    }// end of if else
+    csv_file.close();
+
+    std::ofstream txt_file(txt_path.c_str(), std::ios::out);
+    if(txt_file.is_open()){
+        std::string to_write = "Shared: " + name + ", " + std::to_string(profiles.size()) + " processes, " + std::to_string(running)
+                               + " running, " + std::to_string(crashed) + " crashed\n";
+        to_write += "The percentiles are read from power of two buckets, and are within a factor of 1.42; the call trees are not shared, so there are no inclusive and self times\n";
+        to_write += '\n' + cp.get_header() + '\n';
+        for(auto& entry: merged){
+            to_write += entry.second.to_string() + '\n';
+        }// end of for
+        txt_file << (to_write);
+        // Followed by a section for every process
+        for(ChronosSharedProfile& profile: profiles){
+            to_write = "\nProcess " + std::to_string(profile.pid) + " (" + profile.state + ")\n" + cp.get_header() + '\n';
+            for(ChronosProcess& process: profile.processes){
+                to_write += process.to_string() + '\n';
+            }// end of for
+            txt_file << (to_write);
+        }// end of for
+    }else{
+        std::string error_string = "Error writing file to: \"" + txt_path+"\"";
+        perror(error_string.c_str()); 
+    }// end of if else
+    txt_file.close();
+    return true;
+}
+
+
+bool Chronos::remove_shared(std::string name) {
+    return ChronosShared::remove(name);
+}
+
+
+void Chronos::prepare_fork() {
+    Chronos* instance = m_instance.load(std::memory_order_acquire);
+    if (instance != nullptr){
+        instance->m_mutex.lock();
+    }// end of if
+}
+
+
+void Chronos::after_fork_parent() {
+    Chronos* instance = m_instance.load(std::memory_order_acquire);
+    if (instance != nullptr){
+        instance->m_mutex.unlock();
+    }// end of if
+}
+
+
+void Chronos::after_fork_child() {
+    Chronos* instance = m_instance.load(std::memory_order_acquire);
+    if (instance != nullptr){
+        instance->m_mutex.unlock();
+        instance->m_shared.reattach();
+    }// end of if
+}
+
+
+bool Chronos::start_trace(std::string path, unsigned long buffer_records) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_trace.is_open() || buffer_records == 0){
+        return false;
+    }// end of if
+    namespace fs = std::filesystem;
+    fs::path parent = fs::path(path).parent_path();
+    if (!parent.empty()){
+        fs::create_directories(parent);
+    }// end of if
+    if (!m_trace.open(path)){
+        return false;
+    }// end of if
+    m_trace_records = buffer_records;
+    for (std::unique_ptr<ChronosThread>& thread: m_threads){
+        m_trace.add_buffer(thread->enable_trace(buffer_records));
+    }// end of for
+    return true;
+}
 
-            //Calculate the required time
-            std::chrono::duration<double> elapsed_time = std::chrono::duration_cast<std::chrono::duration<double>>
-                                                         (m_processes.at(location).get_stop_time() - m_processes.at(location).get_start_time());
-            m_processes.at(location).add_time(elapsed_time.count());
-            
-        }// Do nothing otherwise
+
+void Chronos::stop_trace() {
+    resolve_function_names();
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_trace.is_open()){
+        return;
     }// end of if
+    m_trace_records = 0;
+    for (std::unique_ptr<ChronosThread>& thread: m_threads){
+        thread->disable_trace();
+    }// end of for
+    m_trace_dropped = m_trace.get_dropped();
+    m_trace.close(m_site_names);
+    m_trace_written = m_trace.get_record_count();
+}
+
+
+bool Chronos::export_chrome_trace(std::string trace_path, std::string json_path) {
+    ChronosTraceReader reader;
+    if (!reader.open(trace_path)){
+        return false;
+    }// end of if
+    return reader.write_chrome_trace(json_path);
+}
+
+
+bool Chronos::export_flame_graph(std::string folded_path, long thread_id, bool collapse_recursion) {
+    return call_graph(thread_id, collapse_recursion).write_folded(folded_path);
 }
 
 
@@ -169,9 +547,116 @@ std::string Chronos::get_id() {
 }
 
 
+std::vector<ChronosProcess> Chronos::summarise(long thread_id) {
+    std::vector<ChronosProcess> processes = collect(thread_id);
+    ChronosCallGraph graph = call_graph(thread_id);
+    for (ChronosProcess& process: processes){
+        graph.fill(process);
+    }// end of for
+    return processes;
+}
+
+
+std::vector<ChronosProcess> Chronos::snapshot() {
+    return summarise(-1);
+}
+
+
+ChronosCallGraph Chronos::call_graph(long thread_id, bool collapse_recursion) {
+    std::vector<ChronosSiteName> sites;
+    std::vector<ChronosThread*> threads = list_threads(thread_id, sites);
+    ChronosCallGraph graph(sites);
+    if (m_compensate.load()){
+        graph.compensate(m_overhead);
+    }// end of if
+    graph.collapse_recursion(collapse_recursion);
+    for (ChronosThread* thread: threads){
+        graph.add_thread(*thread);
+    }// end of for
+    return graph;
+}
+
+
+bool Chronos::start_monitor(double interval, ChronosMonitor::Callback callback) {
+    if (!callback){
+        // Start a new file of windows
+        m_windows = 0;
+        callback = [this](std::vector<ChronosProcess>& window, double seconds){ write_window(window, seconds); };
+    }// end of if
+    return m_monitor.start(interval, [this]{ return snapshot(); }, std::move(callback));
+}
+
+
+void Chronos::stop_monitor() {
+    m_monitor.stop();
+}
+
+
+void Chronos::write_window(std::vector<ChronosProcess>& window, double seconds) {
+    // Every window is appended to the same file, numbered from the start of the monitor
+    namespace fs = std::filesystem;
+    std::string window_path = "profiler/ChronosWindows.csv";
+    fs::create_directory("profiler");
+    bool exists = m_windows > 0 && fs::exists(window_path);
+    std::ofstream window_file(window_path.c_str(), exists ? std::ios::app : std::ios::out);
+    if(window_file.is_open()){
+        ChronosProcess cp;
+        if (!exists){
+            window_file << "Window,Window Time," << cp.get_header_csv() << '\n';
+        }// end of if
+        for(ChronosProcess& window_cp: window){
+            window_file << m_windows << ',' << std::to_string(seconds) << ',' << window_cp.to_csv() << '\n';
+        }// end of for
+        m_windows++;
+    }else{
+        std::string error_string = "Error writing file to: \"" + window_path+"\"";
+        perror(error_string.c_str()); 
+    }// end of if else
+    window_file.close();
+}
+
+
 void Chronos::friendly_stop() {
+    // Report the last window, and close the event trace, if there are any
+    stop_monitor();
+    stop_trace();
+    // Mark the process finished in the shared segment, and write the profile merged over all its processes so far
+    if (m_shared.is_open()){
+        std::string shared_name = m_shared.get_name();
+        stop_sharing();
+        write_shared_profile(shared_name);
+    }// end of if
+
     // Aggregate the found data        
-    aggregate_data();
+    std::vector<ChronosProcess> aggregate = snapshot();
+
+    // Break the data down per thread
+    long thread_count = 0;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        thread_count = static_cast<long>(m_threads.size());
+    }
+    std::vector<std::vector<ChronosProcess>> per_thread;
+    for (long thread_id = 0; thread_id < thread_count; thread_id++){
+        per_thread.push_back(summarise(thread_id));
+    }// end of for
+
+    // The benchmarks are written after the profiled functions
+    std::vector<ChronosBenchmarkResult> benchmarks;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        benchmarks = m_benchmarks;
+    }
+
+    // The spans, which need the names of the sites
+    std::vector<ChronosSpanData> spans = m_spans.snapshot();
+    std::vector<ChronosSiteName> site_names;
+    if (!spans.empty()){
+        list_threads(-1, site_names);
+    }// end of if
+
+    // The locks, the longest total wait first
+    std::vector<ChronosLockData> locks = ChronosLockTable::get_instance().snapshot();
 
     // Allow for header finding
     ChronosProcess cp;
@@ -182,38 +667,204 @@ void Chronos::friendly_stop() {
     fs::create_directory(profiler_path.c_str());
 
 
-    // Write a CSV File with the data for later use
-    std::ofstream csv_file;
-    std::string csv_path = "profiler/ChronosProfile.csv";
-    csv_file.open(csv_path.c_str(), std::ios::out);
-    if(csv_file.is_open()){
-        std::string to_write = cp.get_header_csv() + '\n';
-        csv_file << (to_write);
-        for(ChronosProcess agg_cp: m_processes){
-            to_write = agg_cp.to_csv() + '\n';
-            csv_file << (to_write);
+    // The lines above the table of the txt report, and the sections below it, which the binary profile keeps as well
+    std::string preamble = "Clock: " + ChronosClock::get_name() + '\n';
+    preamble += "Overhead: " + m_overhead.to_string() + (m_compensate.load() ? ", subtracted" : ", not subtracted")
+                + " from the inclusive and self times; the total, mean and percentiles are as timed, overhead included\n";
+    std::string counter_state;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        counter_state = m_counter_state;
+    }
+    bool cpu_timed = false;
+    for(ChronosProcess& agg_cp: aggregate){
+        cpu_timed = cpu_timed || agg_cp.get_cpu_calls() > 0;
+    }// end of for
+    if (cpu_timed){
+        preamble += "CPU Time: read with CLOCK_THREAD_CPUTIME_ID and getrusage for the functions which asked for it\n";
+    }// end of if
+    if (ChronosAllocations::is_enabled()){
+        preamble += "Allocations: counted by the allocation hooks\n";
+    }// end of if
+    if (!counter_state.empty()){
+        preamble += "Counters: cycles, instructions, L1 misses, LLC misses and branch misses, " + counter_state + '\n';
+    }// end of if
+    if (m_trace_written > 0 || m_trace_dropped > 0){
+        preamble += "Trace: " + std::to_string(m_trace_written) + " events written, " + std::to_string(m_trace_dropped) + " dropped\n";
+    }// end of if
+    // The confidence intervals and throughput of the benchmarks, below their table
+    std::string notes;
+    for(ChronosBenchmarkResult& benchmark: benchmarks){
+        notes += ChronosBenchmark::to_string(benchmark) + '\n';
+    }// end of for
+    // The contention of the locks, and the spans as the tree of the operations they belong to
+    std::string trailer;
+    if (!locks.empty()){
+        trailer += "\nLock Contention\n" + ChronosLockTable::get_header() + '\n' + ChronosLockTable::to_string(locks);
+    }// end of if
+    if (!spans.empty()){
+        trailer += "\nSpans\n" + ChronosSpanTable::to_string(spans, site_names);
+    }// end of if
+
+    // Write the compact binary profile, which holds what the three text reports below do
+    if (m_binary_reports.load()){
+        ChronosProfileWriter writer;
+        writer.set_preamble(preamble);
+        writer.set_notes(notes);
+        writer.set_trailer(trailer);
+        writer.set_thread_count(static_cast<long>(per_thread.size()));
+        writer.add(aggregate);
+        for(std::vector<ChronosProcess>& thread_processes: per_thread){
+            writer.add(thread_processes);
         }// end of for
-    }else{
-        std::string error_string = "Error writing file to: \"" + csv_path+"\"";
-        perror(error_string.c_str()); 
-    }// end of if else
-    csv_file.close();
+        for(ChronosBenchmarkResult& benchmark: benchmarks){
+            writer.add(benchmark.process);
+        }// end of for
+        writer.write("profiler/ChronosProfile.bin");
+    }// end of if
 
-    // Write a txt File with the data for later use
-    std::ofstream txt_file;
-    std::string txt_path = "profiler/ChronosProfile.txt";
-    txt_file.open(txt_path.c_str(), std::ios::out);
-    if(txt_file.is_open()){
-        std::string to_write = cp.get_header() + '\n';
-        txt_file << (to_write);
-        for(ChronosProcess agg_cp: m_processes){
-            to_write = agg_cp.to_string() + '\n';
+    // Write the text reports
+    if (m_text_reports.load()){
+        // Write a CSV File with the data for later use
+        std::ofstream csv_file;
+        std::string csv_path = "profiler/ChronosProfile.csv";
+        csv_file.open(csv_path.c_str(), std::ios::out);
+        if(csv_file.is_open()){
+            std::string to_write = cp.get_header_csv() + '\n';
+            csv_file << (to_write);
+            for(ChronosProcess& agg_cp: aggregate){
+                to_write = agg_cp.to_csv() + '\n';
+                csv_file << (to_write);
+            }// end of for
+            // Followed by the rows of every thread, which can be told apart by the thread column
+            for(std::vector<ChronosProcess>& thread_processes: per_thread){
+                for(ChronosProcess& agg_cp: thread_processes){
+                    to_write = agg_cp.to_csv() + '\n';
+                    csv_file << (to_write);
+                }// end of for
+            }// end of for
+            // And by the benchmarks, marked in the thread column as well
+            for(ChronosBenchmarkResult& benchmark: benchmarks){
+                to_write = benchmark.process.to_csv() + '\n';
+                csv_file << (to_write);
+            }// end of for
+        }else{
+            std::string error_string = "Error writing file to: \"" + csv_path+"\"";
+            perror(error_string.c_str()); 
+        }// end of if else
+        csv_file.close();
+
+        // Write a txt File with the data for later use
+        std::ofstream txt_file;
+        std::string txt_path = "profiler/ChronosProfile.txt";
+        txt_file.open(txt_path.c_str(), std::ios::out);
+        if(txt_file.is_open()){
+            std::string to_write = preamble;
+            to_write += '\n' + cp.get_header() + '\n';
             txt_file << (to_write);
-        }// end of for
+            for(ChronosProcess& agg_cp: aggregate){
+                to_write = agg_cp.to_string() + '\n';
+                txt_file << (to_write);
+            }// end of for
+            // Followed by a section for every thread
+            for(unsigned long thread_id = 0; thread_id < per_thread.size(); thread_id++){
+                to_write = "\nThread " + std::to_string(thread_id) + '\n' + cp.get_header() + '\n';
+                txt_file << (to_write);
+                for(ChronosProcess& agg_cp: per_thread.at(thread_id)){
+                    to_write = agg_cp.to_string() + '\n';
+                    txt_file << (to_write);
+                }// end of for
+            }// end of for
+            // Followed by the benchmarks, with their confidence intervals and throughput below the table
+            if (!benchmarks.empty()){
+                to_write = "\nBenchmarks\n" + cp.get_header() + '\n';
+                for(ChronosBenchmarkResult& benchmark: benchmarks){
+                    to_write += benchmark.process.to_string() + '\n';
+                }// end of for
+                to_write += '\n' + notes;
+                txt_file << (to_write);
+            }// end of if
+            // Followed by the contention of the locks and the spans
+            txt_file << trailer;
+        }else{
+            std::string error_string = "Error writing file to: \"" + txt_path+"\"";
+            perror(error_string.c_str()); 
+        }// end of if else
+        txt_file.close();
+
+        // Write the histograms, in nanoseconds, so they can be merged with those of other runs through ChronosHistogram::deserialize
+        std::ofstream histogram_file;
+        std::string histogram_path = "profiler/ChronosHistograms.csv";
+        histogram_file.open(histogram_path.c_str(), std::ios::out);
+        if(histogram_file.is_open()){
+            histogram_file << "Total Calls,Buckets,Calling Function\n";
+            for(ChronosProcess& agg_cp: aggregate){
+                histogram_file << agg_cp.get_total_calls() << ',' << agg_cp.get_histogram().serialize() << ',' << agg_cp.get_name() << '\n';
+            }// end of for
+        }else{
+            std::string error_string = "Error writing file to: \"" + histogram_path+"\"";
+            perror(error_string.c_str()); 
+        }// end of if else
+        histogram_file.close();
+    }// end of if
+
+    // Write the full statistics of the benchmarks
+    if (!benchmarks.empty()){
+        std::ofstream benchmark_file;
+        std::string benchmark_path = "profiler/ChronosBenchmarks.csv";
+        benchmark_file.open(benchmark_path.c_str(), std::ios::out);
+        if(benchmark_file.is_open()){
+            benchmark_file << ChronosBenchmark::get_header_csv() << '\n';
+            for(ChronosBenchmarkResult& benchmark: benchmarks){
+                benchmark_file << ChronosBenchmark::to_csv(benchmark) << '\n';
+            }// end of for
+        }else{
+            std::string error_string = "Error writing file to: \"" + benchmark_path+"\"";
+            perror(error_string.c_str()); 
+        }// end of if else
+        benchmark_file.close();
+    }// end of if
+
+    // Write the contention of the locks
+    if (!locks.empty()){
+        std::ofstream lock_file;
+        std::string lock_path = "profiler/ChronosLocks.csv";
+        lock_file.open(lock_path.c_str(), std::ios::out);
+        if(lock_file.is_open()){
+            lock_file << ChronosLockTable::get_header_csv() << '\n' << ChronosLockTable::to_csv(locks);
+        }else{
+            std::string error_string = "Error writing file to: \"" + lock_path+"\"";
+            perror(error_string.c_str()); 
+        }// end of if else
+        lock_file.close();
+    }// end of if
+
+    // Write the spans, with the site of every parent so the tree can be rebuilt
+    if (!spans.empty()){
+        std::ofstream span_file;
+        std::string span_path = "profiler/ChronosSpans.csv";
+        span_file.open(span_path.c_str(), std::ios::out);
+        if(span_file.is_open()){
+            span_file << ChronosSpanTable::get_header_csv() << '\n' << ChronosSpanTable::to_csv(spans, site_names);
+        }else{
+            std::string error_string = "Error writing file to: \"" + span_path+"\"";
+            perror(error_string.c_str()); 
+        }// end of if else
+        span_file.close();
+    }// end of if
+
+    // Write the call graph over all the threads, and its stacks for a flame graph
+    ChronosCallGraph graph = call_graph(-1);
+    std::ofstream graph_file;
+    std::string graph_path = "profiler/ChronosCallGraph.txt";
+    graph_file.open(graph_path.c_str(), std::ios::out);
+    if(graph_file.is_open()){
+        graph_file << graph.to_string();
     }else{
-        std::string error_string = "Error writing file to: \"" + txt_path+"\"";
+        std::string error_string = "Error writing file to: \"" + graph_path+"\"";
         perror(error_string.c_str()); 
     }// end of if else
-    csv_file.close();
+    graph_file.close();
+    graph.write_folded("profiler/ChronosStacks.folded");
 
 }
@@ -28,19 +28,45 @@
 #pragma once
 
 #include <vector>
-#include <list>
+#include <algorithm>
 #include <chrono>
 #include <iostream>
 #include <fstream>
 #include <ctime>
 #include <functional>
 #include <filesystem>
+#include <unordered_map>
+#include <atomic>
+#include <mutex>
+#include <memory>
 
 
 #include "ChronosProcess.h"
+#include "ChronosThread.h"
+#include "ChronosCallGraph.h"
+#include "ChronosTrace.h"
+#include "ChronosTraceReader.h"
+#include "ChronosSampler.h"
+#include "ChronosMonitor.h"
+#include "ChronosOverhead.h"
+#include "ChronosBenchmark.h"
+#include "ChronosAllocations.h"
+#include "ChronosInstrument.h"
+#include "ChronosArena.h"
+#include "ChronosShared.h"
+#include "ChronosSpanTable.h"
+#include "ChronosMutex.h"
+#include "ChronosProfileWriter.h"
+#include "ChronosProfileReader.h"
 
 class Chronos{
    public:
+    // Drop-in replacements for the standard locks, which record how long the threads waited for them and held them
+    using mutex = ChronosMutex;
+    using shared_mutex = ChronosSharedMutex;
+    template <typename Mutex>
+    using lock_guard = std::lock_guard<Mutex>;
+
     // Dtor and Initaliser
       /**
        * @brief Destroy the Chronos object
@@ -48,7 +74,7 @@ class Chronos{
        */
        ~Chronos();
        /**
-        * @brief Get the instance object to instantiate the singleton Chronos class
+        * @brief Get the instance object to instantiate the singleton Chronos class. Safe to call from any thread.
         * 
         * @return Chronos* 
         */
@@ -72,6 +98,273 @@ class Chronos{
      */
     void stop(std::string func_name, std::string id, bool log = false);
 
+    // Used for the interned call-site handles
+    /**
+     * @brief Interns the function name once, and returns a small integer handle which identifies the call site from then on.
+     *          Every call with the same name shares the handle; the id of the first registration is kept for the reports.
+     *          The intended use is through a static local at the call site, so the strings are only hashed on the first call:
+     *          static const long site = profiler->register_site(__PRETTY_FUNCTION__);
+     * 
+     * @param func_name obtains the functions' name: required use: __PRETTY_FUNCTION__, but any name will do as long as it's consistent
+     * @param id a unique string representing something of a primary key to identify the process by
+     * @return long the handle to pass to start(long) and stop(long)
+     */
+    long register_site(std::string func_name, std::string id = "0000");
+    /**
+     * @brief This function starts the profiling for a call site registered with register_site. It is a plain array index,
+     *          with no hashing or string comparisons.
+     * 
+     * @param site the handle returned by register_site
+     * @param log used to determine whether the logging should take place or not.
+     */
+    inline void start(long site, bool log = true) {
+        // Only continue should the programmer wish to log the data
+        if (log && site >= 0){
+            get_thread()->start(site);
+        }// end of if
+    }
+    /**
+     * @brief This function stops the profiling for a call site registered with register_site. It is a plain array index,
+     *          with no hashing or string comparisons.
+     * 
+     * @param site the handle returned by register_site
+     * @param log used to determine whether the logging should take place or not.
+     */
+    inline void stop(long site, bool log = true) {
+        // Only continue should the programmer wish to log the data
+        if (log && site >= 0){
+            get_thread()->stop(site);
+        }// end of if
+    }
+
+    // Used for sampling
+    /**
+     * @brief Times only one in every period calls of every site, to cap the profiler's cost on functions which are called very
+     *          often. Every call is still counted, and the reports extrapolate the timed calls to all of them.
+     * 
+     * @param period 1 times every call, which is the default
+     */
+    void set_sample_period(long period);
+    /**
+     * @brief Sets the sample period of one site, overriding the period set for all sites
+     * 
+     * @param site the handle returned by register_site
+     * @param period time one in every period calls, 0 goes back to the period of all sites
+     */
+    void set_sample_period(long site, long period);
+    /**
+     * @brief Lets every thread raise the sample period of a site while the site is called so often that timing it would cost
+     *          more than the budget, and lower it again once the site calms down. The sample periods set above act as the floor.
+     * 
+     * @param enabled 
+     * @param overhead_budget the share of a site's time its timed calls may cost, such as 0.01 for 1%
+     */
+    void set_adaptive_sampling(bool enabled, double overhead_budget = 0.01);
+
+    // Used for the overhead compensation
+    /**
+     * @brief Sets whether the profiler's own cost, measured when the profiler was created, is taken out of the inclusive and
+     *          self times: the cost of timing each call, and the cost of timing every call made below it. On by default.
+     *          The reports state the measured cost either way.
+     * 
+     * @param enabled 
+     */
+    void set_overhead_compensation(bool enabled);
+    /**
+     * @brief Get the overhead object
+     * 
+     * @return ChronosOverhead& the profiler's own cost, as measured when the profiler was created
+     */
+    ChronosOverhead& get_overhead();
+
+    // Used for the hardware counters
+    /**
+     * @brief Sets whether the timed calls read the hardware performance counters: cycles, instructions, L1 and last level
+     *          cache misses, and branch misses, for the IPC and misses per call columns of the reports. The counters need Linux
+     *          and access to perf_event_open; without them the columns are left blank.
+     * 
+     * @param enabled 
+     * @return true if the counters could be opened, or were turned off
+     */
+    bool enable_counters(bool enabled = true);
+
+    // Used for the CPU time
+    /**
+     * @brief Sets whether the timed calls of a site read the thread's CPU time and context switches as well, so the reports
+     *          can tell the time it spent on the CPU from the time it spent waiting on I/O, on locks or for the scheduler: the
+     *          On-CPU Time, Off-CPU Time and switches per call columns. The reads are system calls, so only the sites asked
+     *          for pay for them. Needs Linux; elsewhere the columns are left blank.
+     * 
+     * @param site the handle returned by register_site
+     * @param enabled 
+     */
+    void enable_cpu_time(long site, bool enabled = true);
+
+    // Used for the allocation hooks
+    /**
+     * @brief Sets whether every allocation is added to the function running on the thread: the allocations it makes itself,
+     *          the bytes it asks for, and the most bytes in use during one of its calls. The hooks replace operator new and
+     *          delete and interpose malloc and free, so they are only compiled in with the CHRONOS_ALLOCATIONS CMake option.
+     * 
+     * @param enabled 
+     * @return true if the hooks are compiled in, or were turned off
+     */
+    bool enable_allocations(bool enabled = true);
+
+    // Used for the function instrumentation
+    /**
+     * @brief Sets whether the functions of the modules compiled with -finstrument-functions are profiled, without a call to
+     *          the profiler in their source. Turning it on also turns on the adaptive sampling of those functions, so the short
+     *          ones called most often are timed only now and then and the profiler costs about the budget of their time; the
+     *          sites registered by hand keep their periods. The hooks are only compiled in with the CHRONOS_INSTRUMENT CMake
+     *          option, and should be turned on before the profiled threads start.
+     * 
+     * @param enabled 
+     * @param overhead_budget the budget of the adaptive sampling, or 0 to leave the sampling as it is and time every call
+     * @return true if the hooks are compiled in, or were turned off
+     */
+    bool enable_instrumentation(bool enabled = true, double overhead_budget = 0.01);
+    /**
+     * @brief Profiles only the instrumented functions whose demangled name or module path contains one of the patterns given
+     *          this way, when any are given. The CHRONOS_INCLUDE environment variable adds to them, as a list separated by commas.
+     * 
+     * @param pattern 
+     */
+    void instrument_include(std::string pattern);
+    /**
+     * @brief Leaves out the instrumented functions whose demangled name or module path contains the pattern. The
+     *          CHRONOS_EXCLUDE environment variable adds to them, as a list separated by commas.
+     * 
+     * @param pattern 
+     */
+    void instrument_exclude(std::string pattern);
+    /**
+     * @brief Registers a site for a function known only by its address, as the instrumentation hooks see it. The site is
+     *          named after the address until the reports are read, when it is given the function's demangled name.
+     * 
+     * @param function 
+     * @return long the handle to pass to start(long) and stop(long)
+     */
+    long register_function(const void* function);
+    /**
+     * @brief Get the buffer of the calling thread, without creating one. Allocates nothing and takes no lock, so it is safe to
+     *          call from the allocation hooks.
+     * 
+     * @return ChronosThread* nullptr if there is no profiler, or the thread has not recorded anything yet
+     */
+    static inline ChronosThread* find_current_thread() {
+        Chronos* instance = m_instance.load(std::memory_order_acquire);
+        if (instance == nullptr){
+            return nullptr;
+        }// end of if
+        ThreadCache& cache = thread_cache();
+        return cache.generation == instance->m_generation ? cache.thread : nullptr;
+    }
+
+    // Used for micro-benchmarks
+    /**
+     * @brief Benchmarks a callable which takes no arguments: it is warmed up, its iterations are scaled until a sample is
+     *          long enough to time, and samples are taken until the mean is known well enough. Whatever the callable returns is
+     *          kept from being optimised away; ChronosBenchmark::do_not_optimize does the same for values inside it.
+     *          The result is also written to the reports of friendly_stop.
+     * 
+     * @param name the name in the reports
+     * @param callable 
+     * @param options the warmup, sample and confidence settings, and the items one call processes for the throughput
+     * @return ChronosBenchmarkResult the mean, median, standard deviation, confidence interval and throughput
+     */
+    template <typename Callable>
+    ChronosBenchmarkResult benchmark(std::string name, Callable&& callable, ChronosBenchmarkOptions options = ChronosBenchmarkOptions()) {
+        ChronosBenchmarkResult result = ChronosBenchmark::run(name, callable, options);
+        add_benchmark(result);
+        return result;
+    }
+
+    // Used for the spans of asynchronous operations
+    /**
+     * @brief Adds a finished span to the spans of friendly_stop, which writes them to profiler/ChronosSpans.csv and below
+     *          the functions in profiler/ChronosProfile.txt. Called by ChronosSpan, from whichever thread finished it.
+     * 
+     * @param record the sites of the span and its parent, with its active time and latency in clock ticks
+     */
+    void record_span(const ChronosSpanRecord& record);
+
+    // Used to merge the profiles of several processes
+    /**
+     * @brief Adds every call of this process to a named shared memory segment as well, which every process opening the same
+     *          name records into, so one profile can be read over all of them. The calls are added as they stop, so those of a
+     *          process that crashes are kept. Processes forked afterwards take a slot of their own. friendly_stop marks the
+     *          process finished and writes the merged profile through write_shared_profile.
+     * 
+     * @param name the name of the segment, starting with a slash
+     * @param max_processes the processes a new segment has room for
+     * @param max_sites the distinct function names a new segment has room for
+     * @return true if the process got a slot in the segment
+     */
+    bool share(std::string name = "/chronos", long max_processes = 64, long max_sites = 4096);
+    /**
+     * @brief Stops adding the calls to the shared memory segment, and marks the process finished
+     * 
+     */
+    void stop_sharing();
+    /**
+     * @brief Writes the profile merged over all the processes of a shared memory segment, followed by a breakdown per process
+     *          with its state: running, finished, or crashed if it is gone without finishing. Any process may call it, whether
+     *          it records into the segment or not.
+     * 
+     * @param name the name of the segment
+     * @param csv_path 
+     * @param txt_path 
+     * @return true if the segment could be read
+     */
+    bool write_shared_profile(std::string name = "/chronos", std::string csv_path = "profiler/ChronosShared.csv",
+                              std::string txt_path = "profiler/ChronosShared.txt");
+    /**
+     * @brief Removes a shared memory segment, so the next process to share starts a new one
+     * 
+     * @param name 
+     * @return true if the segment existed
+     */
+    static bool remove_shared(std::string name = "/chronos");
+
+    // Used for the event trace
+    /**
+     * @brief Starts writing every start and stop to a binary trace file, as fixed-size events with the site handle, thread and
+     *          clock ticks. Each thread appends to its own ring buffer, which a background thread drains into the memory-mapped
+     *          file. Events are dropped, and counted, when a ring is full. The calls which sampling leaves untimed are traced
+     *          as well, and read the clock for the trace alone while it is on.
+     * 
+     * @param path the trace file to create
+     * @param buffer_records the number of events every thread's ring buffer holds
+     * @return true if the trace file could be created
+     */
+    bool start_trace(std::string path = "profiler/ChronosTrace.bin", unsigned long buffer_records = 1ul << 16);
+    /**
+     * @brief Stops the event trace, and closes the trace file with the names of the sites. Called by friendly_stop.
+     * 
+     */
+    void stop_trace();
+    /**
+     * @brief Converts a trace file into the Chrome Trace Event JSON format, for chrome://tracing or Perfetto. The conversion is
+     *          streamed, so it needs little memory however long the trace is.
+     * 
+     * @param trace_path a trace file written through start_trace
+     * @param json_path the JSON file to write
+     * @return true if the JSON file was written
+     */
+    bool export_chrome_trace(std::string trace_path = "profiler/ChronosTrace.bin", std::string json_path = "profiler/ChronosTrace.json");
+    /**
+     * @brief Writes the call trees of the threads as folded stacks, a line of "main;parse;read 1200" for every path of calls
+     *          with its self time in nanoseconds, from which flamegraph.pl, inferno or speedscope draw a flame graph.
+     *          friendly_stop writes profiler/ChronosStacks.folded as well.
+     * 
+     * @param folded_path the file to write
+     * @param thread_id the thread to read, or -1 to merge all the threads
+     * @param collapse_recursion whether a function calling itself gives one frame rather than one per level
+     * @return true if the file was written
+     */
+    bool export_flame_graph(std::string folded_path = "profiler/ChronosStacks.folded", long thread_id = -1, bool collapse_recursion = false);
+
     // Used to get an ID
     /**
      * @brief Get the id object which uniquely identifies each process
@@ -82,12 +375,57 @@ class Chronos{
 
     // Used to display
     /**
-     * @brief used to output the function information in .csv and .txt format. Additionally, creates a graph if the script is available.
+     * @brief used to output the function information in .csv and .txt format. Additionally, writes the folded stacks for a flame graph.
+     *          The results of all the threads are merged, and followed by a breakdown per thread. The call graph, with the
+     *          inclusive and self time of every caller and callee, is written to a separate .txt file.
      * 
      */
     void friendly_stop();
+    /**
+     * @brief Sets which formats friendly_stop writes the profile in: the text reports, ChronosProfile.csv, ChronosProfile.txt
+     *          and ChronosHistograms.csv, and the compact binary profile, ChronosProfile.bin, which is written in one go and
+     *          can be converted to the text reports later by ChronosProfileReader or Chronos_Convert. Only the text reports
+     *          are written by default.
+     * 
+     * @param text 
+     * @param binary 
+     */
+    void set_report_formats(bool text, bool binary);
+    /**
+     * @brief Merges the buffers of all the threads into one process per function. The threads may keep recording while this runs;
+     *          calls still in flight are simply left out.
+     * 
+     * @return std::vector<ChronosProcess> one entry per function name
+     */
+    std::vector<ChronosProcess> snapshot();
+    /**
+     * @brief Starts a timer thread which reports the calls of every interval: their count, total time and percentiles, as the
+     *          difference between two snapshots. Recording carries on untouched, and the recording threads never wait for it.
+     *          By default every window is appended to profiler/ChronosWindows.csv; friendly_stop stops the timer.
+     * 
+     * @param interval the seconds between two reports
+     * @param callback receives the processes called during every window and the window's length in seconds, on the timer thread
+     * @return true if the timer was not running yet
+     */
+    bool start_monitor(double interval, ChronosMonitor::Callback callback = nullptr);
+    /**
+     * @brief Stops the timer thread started by start_monitor, after reporting the last, shorter, window
+     * 
+     */
+    void stop_monitor();
+    /**
+     * @brief Builds the call graph from the call trees of the threads
+     * 
+     * @param thread_id the thread to read, or -1 to merge all the threads
+     * @param collapse_recursion whether the stacks of a function calling itself are folded into one frame
+     * @return ChronosCallGraph 
+     */
+    ChronosCallGraph call_graph(long thread_id = -1, bool collapse_recursion = false);
 
    private:
+    // The calibration drives start and stop on the profiler's own sites and thread buffer, before the instance is published
+    friend class ChronosOverhead;
+
     // Private Functions not used in singleton
        /**
         * @brief Construct a new Chronos object
@@ -115,21 +453,143 @@ class Chronos{
         * @brief This function will determine whether a particular function has been recorded previously or not
         * 
         * @param func_name 
+        * @return long the site handle, or -1 if the function has not been registered
+        */
+       long find_process(const std::string& func_name);
+
+       // Used to aggregate the information of the thread buffers
+       /**
+        * @brief Reads the recorded sites out of the thread buffers. Every call was already folded into its site's statistics
+        *          when it stopped, so this is one merge per site and thread, however many calls were made.
+        * 
+        * @param thread_id the thread to read, or -1 to merge all the threads
+        * @return std::vector<ChronosProcess> one entry per function name that was called
+        */
+       std::vector<ChronosProcess> collect(long thread_id);
+       /**
+        * @brief Collects the sites of one or all threads, and fills in their times from the call graph
+        * 
+        * @param thread_id the thread to read, or -1 to merge all the threads
+        * @return std::vector<ChronosProcess> one entry per function name
+        */
+       std::vector<ChronosProcess> summarise(long thread_id);
+       /**
+        * @brief Copies the registered sites and the buffers of one or all threads, so they can be read without holding the lock
+        * 
+        * @param thread_id the thread to list, or -1 for all the threads
+        * @param sites receives the name and id of every site, indexed by the site handle
+        * @return std::vector<ChronosThread*> 
+        */
+       std::vector<ChronosThread*> list_threads(long thread_id, std::vector<ChronosSiteName>& sites);
+       /**
+        * @brief Gives the sites registered by register_function the names of their functions. The symbols are read without
+        *          the lock, so it is called before the lock of a report is taken
+        * 
+        */
+       void resolve_function_names();
+       /**
+        * @brief Appends a window of start_monitor to profiler/ChronosWindows.csv
+        * 
+        * @param window the processes called during the window
+        * @param seconds the length of the window
+        */
+       void write_window(std::vector<ChronosProcess>& window, double seconds);
+       /**
+        * @brief Keeps the result of a benchmark for the reports
+        * 
+        * @param result 
+        */
+       void add_benchmark(ChronosBenchmarkResult& result);
+
+       /**
+        * @brief Get the buffer of the calling thread. The lookup is a thread_local cache; the shared list is only locked the
+        *          first time a thread records.
+        * 
+        * @return ChronosThread* 
+        */
+       inline ChronosThread* get_thread() {
+           ThreadCache& cache = thread_cache();
+           if (cache.generation != m_generation){
+               cache.thread = register_thread();
+               cache.generation = m_generation;
+           }// end of if
+           return cache.thread;
+       }
+       /**
+        * @brief Creates the buffer for the calling thread and adds it to the list of threads
+        * 
+        * @return ChronosThread* 
+        */
+       ChronosThread* register_thread();
+       /**
+        * @brief Looks up the site handle for the string overloads, first in the thread's cache, then in the shared registry.
+        *          The id only matters for a new site, whatever get_id() returned for the call.
+        * 
+        * @param func_name 
         * @param id 
-        * @return long 
+        * @param create whether the site should be registered if it is not found
+        * @return long the site handle, or -1 if not found
+        */
+       long lookup_site(const std::string& func_name, const std::string& id, bool create);
+
+       /**
+        * @brief Takes the lock before a fork, so the child does not inherit it locked by a thread which is not copied
+        * 
+        */
+       static void prepare_fork();
+       /**
+        * @brief Releases the lock in the parent after a fork
+        * 
+        */
+       static void after_fork_parent();
+       /**
+        * @brief Releases the lock in the child after a fork, and gives it a slot of its own in the shared memory segment
+        * 
         */
-       long find_process(std::string func_name, std::string id);
+       static void after_fork_child();
 
-       // Used to aggregate the individual information from the processes vector
+       // Thread local record of which instance the cached buffer belongs to
+       struct ThreadCache {
+           unsigned long generation;
+           ChronosThread* thread;
+       };
        /**
-        * @brief Aggregates all the single processes into a form similar to that found in gprof
+        * @brief Get the calling thread's cache of its buffer
         * 
+        * @return ThreadCache& 
         */
-       void aggregate_data(); 
+       static inline ThreadCache& thread_cache() {
+           thread_local ThreadCache cache = {0, nullptr};
+           return cache;
+       }
 
-      
-       static Chronos* m_instance;
+       static std::atomic<Chronos*> m_instance;
+       static std::mutex m_instance_mutex;
+       static std::atomic<unsigned long> m_generations;
 
     // Variables for Use
-        std::vector<ChronosProcess> m_processes;
+        unsigned long m_generation;                                     // Distinguishes this instance from deleted ones in the thread caches
+        std::mutex m_mutex;                                             // Guards the registry and the thread list, never taken on the hot path
+        ChronosArena m_names;                                           // Holds the text of every name and id, never moved
+        std::vector<ChronosSiteName> m_site_names;                      // Name and id of every site, indexed by the site handle
+        std::unordered_map<std::string_view, long> m_sites;             // Maps the name in the arena to the site handle
+        std::vector<std::pair<long, const void*>> m_unnamed_functions;  // Sites of register_function still named after their address
+        ChronosOverhead m_overhead;                                     // The profiler's own cost, measured on creation
+        std::atomic<bool> m_compensate;                                 // Whether the overhead is taken out of the call graph
+        std::atomic<bool> m_adaptive_functions;                         // Whether the instrumented functions adapt their periods
+        ChronosSampler m_sampler;                                       // Sampling settings, read by the threads
+        std::vector<std::unique_ptr<ChronosThread>> m_threads;          // One recording buffer per thread
+        ChronosShared m_shared;                                         // Segment shared with other processes
+        ChronosTrace m_trace;                                           // Writer of the event trace
+        unsigned long m_trace_records;                                  // Ring size for threads which start while tracing
+        long m_trace_written;                                           // Events in the last closed trace
+        long m_trace_dropped;                                           // Events dropped from the last closed trace
+        ChronosMonitor m_monitor;                                       // Timer of the windowed reports
+        long m_windows;                                                 // Windows written to profiler/ChronosWindows.csv
+        std::atomic<bool> m_counting;                                   // Whether the threads read the hardware counters
+        std::string m_counter_state;                                    // How the counters are read, for the report; empty if never asked
+        std::vector<ChronosBenchmarkResult> m_benchmarks;               // Results of benchmark, guarded by m_mutex
+        ChronosSpanTable m_spans;                                       // Finished spans of asynchronous operations
+        std::atomic<bool> m_text_reports;                               // Whether friendly_stop writes the .csv and .txt reports
+        std::atomic<bool> m_binary_reports;                             // Whether friendly_stop writes ChronosProfile.bin
 };
@@ -0,0 +1,224 @@
+/**   Copyright 2020 Benrick Smit
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ * 
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+*/
+
+/**
+ * @author: Benrick Smit
+ * @email: metatronicprogramming@hotmail.com
+ * @date: 13 June 2020
+ * @modified: 13 June 2020
+ * 
+ * @brief: This class switches the allocation hooks of the profiler on and off, and holds the hooks when they are compiled in.
+ * 
+ */ 
+
+
+#include "ChronosAllocations.h"
+
+#include "Chronos.h"
+
+#if CHRONOS_ALLOCATIONS
+#include <cerrno>
+#include <cstdlib>
+#include <malloc.h>
+#include <new>
+
+// glibc's own allocator, which the hooks forward to
+extern "C" {
+    void* __libc_malloc(size_t size);
+    void* __libc_calloc(size_t count, size_t size);
+    void* __libc_realloc(void* pointer, size_t size);
+    void* __libc_memalign(size_t alignment, size_t size);
+    void* __libc_valloc(size_t size);
+    void* __libc_pvalloc(size_t size);
+    void __libc_free(void* pointer);
+}
+#endif
+
+
+std::atomic<bool> ChronosAllocations::s_enabled(false);
+
+//Basic Functionality
+bool ChronosAllocations::set_enabled(bool enabled) {
+    if (enabled && !is_compiled()){
+        return false;
+    }// end of if
+    s_enabled.store(enabled);
+    return true;
+}
+
+bool ChronosAllocations::is_compiled() {
+    return CHRONOS_ALLOCATIONS != 0;
+}
+
+
+#if CHRONOS_ALLOCATIONS
+namespace {
+    // Set while a hook is counting, so the allocations it makes itself are passed straight through
+    thread_local bool t_in_hook = false;
+
+    void count_allocation(void* pointer, size_t requested) {
+        if (pointer == nullptr || !ChronosAllocations::is_enabled() || t_in_hook){
+            return;
+        }// end of if
+        t_in_hook = true;
+        ChronosThread* thread = Chronos::find_current_thread();
+        if (thread != nullptr && !thread->is_internal()){
+            thread->record_allocation(static_cast<long long>(requested), static_cast<long long>(malloc_usable_size(pointer)));
+        }// end of if
+        t_in_hook = false;
+    }
+
+    void count_free(void* pointer, size_t usable) {
+        if (pointer == nullptr || !ChronosAllocations::is_enabled() || t_in_hook){
+            return;
+        }// end of if
+        t_in_hook = true;
+        ChronosThread* thread = Chronos::find_current_thread();
+        if (thread != nullptr && !thread->is_internal()){
+            thread->record_free(static_cast<long long>(usable));
+        }// end of if
+        t_in_hook = false;
+    }
+
+    void count_free(void* pointer) {
+        if (pointer != nullptr && ChronosAllocations::is_enabled()){
+            count_free(pointer, malloc_usable_size(pointer));
+        }// end of if
+    }
+
+    void* allocate(size_t size) {
+        void* pointer = __libc_malloc(size);
+        count_allocation(pointer, size);
+        return pointer;
+    }
+
+    void* allocate_or_throw(size_t size) {
+        void* pointer = allocate(size == 0 ? 1 : size);
+        if (pointer == nullptr){
+            throw std::bad_alloc();
+        }// end of if
+        return pointer;
+    }
+
+    void release(void* pointer) {
+        count_free(pointer);
+        __libc_free(pointer);
+    }
+}
+
+// The C allocator
+extern "C" {
+    void* malloc(size_t size) {
+        return allocate(size);
+    }
+
+    void* calloc(size_t count, size_t size) {
+        void* pointer = __libc_calloc(count, size);
+        count_allocation(pointer, count * size);
+        return pointer;
+    }
+
+    void* realloc(void* pointer, size_t size) {
+        // Counted as a free of the old block and an allocation of the new one. The old block is only gone when the call
+        // succeeded, or freed it with a size of 0, and its size must be read before then
+        size_t old_size = (pointer != nullptr && ChronosAllocations::is_enabled()) ? malloc_usable_size(pointer) : 0;
+        void* moved = __libc_realloc(pointer, size);
+        if (moved != nullptr || size == 0){
+            count_free(pointer, old_size);
+        }// end of if
+        count_allocation(moved, size);
+        return moved;
+    }
+
+    void free(void* pointer) {
+        release(pointer);
+    }
+
+    void* memalign(size_t alignment, size_t size) {
+        void* pointer = __libc_memalign(alignment, size);
+        count_allocation(pointer, size);
+        return pointer;
+    }
+
+    void* aligned_alloc(size_t alignment, size_t size) {
+        return memalign(alignment, size);
+    }
+
+    void* valloc(size_t size) {
+        void* pointer = __libc_valloc(size);
+        count_allocation(pointer, size);
+        return pointer;
+    }
+
+    void* pvalloc(size_t size) {
+        void* pointer = __libc_pvalloc(size);
+        count_allocation(pointer, size);
+        return pointer;
+    }
+
+    int posix_memalign(void** result, size_t alignment, size_t size) {
+        if (alignment < sizeof(void*) || (alignment & (alignment - 1)) != 0){
+            return EINVAL;
+        }// end of if
+        void* pointer = memalign(alignment, size);
+        if (pointer == nullptr){
+            return ENOMEM;
+        }// end of if
+        *result = pointer;
+        return 0;
+    }
+}
+
+// The C++ allocator, which goes to glibc directly rather than through the malloc above
+void* operator new(size_t size) {
+    return allocate_or_throw(size);
+}
+
+void* operator new[](size_t size) {
+    return allocate_or_throw(size);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+    return allocate(size == 0 ? 1 : size);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept {
+    return allocate(size == 0 ? 1 : size);
+}
+
+void operator delete(void* pointer) noexcept {
+    release(pointer);
+}
+
+void operator delete[](void* pointer) noexcept {
+    release(pointer);
+}
+
+void operator delete(void* pointer, size_t) noexcept {
+    release(pointer);
+}
+
+void operator delete[](void* pointer, size_t) noexcept {
+    release(pointer);
+}
+
+void operator delete(void* pointer, const std::nothrow_t&) noexcept {
+    release(pointer);
+}
+
+void operator delete[](void* pointer, const std::nothrow_t&) noexcept {
+    release(pointer);
+}
+#endif
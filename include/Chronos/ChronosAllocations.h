@@ -0,0 +1,69 @@
+/**   Copyright 2020 Benrick Smit
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ * 
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+*/
+
+/**
+ * @author: Benrick Smit
+ * @email: metatronicprogramming@hotmail.com
+ * @date: 13 June 2020
+ * @modified: 13 June 2020
+ * 
+ * @brief: This class switches the allocation hooks of the profiler on and off. The hooks replace the global operator new and
+ *          delete, and interpose malloc, calloc, realloc, free and the aligned allocations, forwarding them to glibc. While
+ *          they are switched on, every allocation is added to the site of the call running on the thread: the number of
+ *          allocations and the bytes asked for, while the bytes in use are followed to find the peak of every call.
+ * 
+ *          The hooks are only compiled in with the CHRONOS_ALLOCATIONS option of the CMake project, as replacing the
+ *          allocator is not something a program should get by accident. Allocations made by the hooks, or by the profiler
+ *          while it records, are never counted, so the hooks can not recurse.
+ * 
+ */ 
+
+#pragma once
+
+#include <atomic>
+
+#ifndef CHRONOS_ALLOCATIONS
+#define CHRONOS_ALLOCATIONS 0
+#endif
+
+class ChronosAllocations {
+	public:
+		/**
+		 * @brief Switches the hooks on or off
+		 * 
+		 * @param enabled 
+		 * @return true if the hooks are compiled in, or were switched off
+		 */
+		static bool set_enabled(bool enabled);
+		/**
+		 * @brief Whether the hooks are switched on
+		 * 
+		 * @return true 
+		 * @return false 
+		 */
+		static inline bool is_enabled() {
+			return s_enabled.load(std::memory_order_relaxed);
+		}
+		/**
+		 * @brief Whether the hooks are compiled in
+		 * 
+		 * @return true 
+		 * @return false 
+		 */
+		static bool is_compiled();
+
+	private:
+		static std::atomic<bool> s_enabled;										// Whether the hooks count the allocations
+};
@@ -0,0 +1,78 @@
+/**   Copyright 2020 Benrick Smit
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ * 
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+*/
+
+/**
+ * @author: Benrick Smit
+ * @email: metatronicprogramming@hotmail.com
+ * @date: 13 June 2020
+ * @modified: 13 June 2020
+ * 
+ * @brief: This class keeps the names of the call sites packed in large chunks.
+ * 
+ */ 
+
+
+#include "ChronosArena.h"
+
+#include <cstring>
+
+
+//Ctors and Dtors
+ChronosArena::ChronosArena(unsigned long chunk_size) {
+    m_next = nullptr;
+    m_left = 0;
+    m_chunk_size = chunk_size > 0 ? chunk_size : 1;
+    m_used = 0;
+    m_reserved = 0;
+}
+
+ChronosArena::~ChronosArena() {
+    // Do Nothing, the chunks free themselves
+}
+
+//Basic Functionality
+std::string_view ChronosArena::store(std::string_view text) {
+    if (text.empty()){
+        return std::string_view();
+    }// end of if
+    if (text.size() > m_left){
+        unsigned long size = text.size() > m_chunk_size ? text.size() : m_chunk_size;
+        m_chunks.push_back(std::make_unique<char[]>(size));
+        m_reserved += size;
+        if (text.size() > m_chunk_size){
+            // An oversized text fills a chunk of its own, and the last chunk carries on being filled
+            std::memcpy(m_chunks.back().get(), text.data(), text.size());
+            m_used += text.size();
+            return std::string_view(m_chunks.back().get(), text.size());
+        }// end of if
+        m_next = m_chunks.back().get();
+        m_left = size;
+    }// end of if
+    std::memcpy(m_next, text.data(), text.size());
+    std::string_view copy(m_next, text.size());
+    m_next += text.size();
+    m_left -= text.size();
+    m_used += text.size();
+    return copy;
+}
+
+//Getters
+unsigned long ChronosArena::get_used() {
+    return m_used;
+}
+
+unsigned long ChronosArena::get_reserved() {
+    return m_reserved;
+}
@@ -0,0 +1,93 @@
+/**   Copyright 2020 Benrick Smit
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ * 
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+*/
+
+/**
+ * @author: Benrick Smit
+ * @email: metatronicprogramming@hotmail.com
+ * @date: 13 June 2020
+ * @modified: 13 June 2020
+ * 
+ * @brief: This class keeps the names of the call sites, and any other text that lives as long as the profiler, packed one
+ *          after another in large chunks. A chunk is never moved or freed before the arena is, so the views handed out stay
+ *          valid without a lock, and the registry holds two views per site rather than two strings of its own. The names are
+ *          only read when a report is written, so they are kept well away from the statistics the threads update.
+ * 
+ */ 
+
+#pragma once
+
+#include <memory>
+#include <string_view>
+#include <vector>
+
+/**
+ * @brief The name and id of a call site, as stored in the arena
+ * 
+ */
+struct ChronosSiteName {
+    std::string_view name;
+    std::string_view id;
+};
+
+class ChronosArena {
+	public:
+		//ctors and dtors
+		/**
+		 * @brief Construct a new Chronos Arena object, which allocates nothing until the first text is stored
+		 * 
+		 * @param chunk_size bytes per chunk; longer texts get a chunk of their own
+		 */
+		ChronosArena(unsigned long chunk_size = 1ul << 16);
+		/**
+		 * @brief Destroy the Chronos Arena object, and free the chunks with the texts in them
+		 * 
+		 */
+		~ChronosArena();
+
+		ChronosArena(const ChronosArena&) = delete;
+		ChronosArena& operator=(const ChronosArena&) = delete;
+
+		//Basic Operation
+		/**
+		 * @brief Copies a text into the arena. Not thread-safe: the caller should hold the lock of the registry.
+		 * 
+		 * @param text 
+		 * @return std::string_view the copy, valid until the arena is destroyed
+		 */
+		std::string_view store(std::string_view text);
+
+		//Getters
+		/**
+		 * @brief Get the used object
+		 * 
+		 * @return unsigned long bytes taken up by the stored texts
+		 */
+		unsigned long get_used();
+		/**
+		 * @brief Get the reserved object
+		 * 
+		 * @return unsigned long bytes allocated for the chunks
+		 */
+		unsigned long get_reserved();
+
+	private:
+		//Member variables
+		std::vector<std::unique_ptr<char[]>> m_chunks;							// Every chunk allocated so far
+		char* m_next;															// Next free byte of the last chunk
+		unsigned long m_left;													// Free bytes left in the last chunk
+		unsigned long m_chunk_size;												// Bytes per chunk
+		unsigned long m_used;													// Bytes of text stored
+		unsigned long m_reserved;												// Bytes of the chunks
+};
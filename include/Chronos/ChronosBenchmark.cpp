@@ -0,0 +1,146 @@
+/**   Copyright 2020 Benrick Smit
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ * 
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+*/
+
+/**
+ * @author: Benrick Smit
+ * @email: metatronicprogramming@hotmail.com
+ * @date: 13 June 2020
+ * @modified: 13 June 2020
+ * 
+ * @brief: This class benchmarks a single callable, rather than profiling a running program.
+ * 
+ */ 
+
+
+#include "ChronosBenchmark.h"
+
+#include <algorithm>
+#include <cmath>
+
+
+//Basic Functionality
+ChronosBenchmarkResult ChronosBenchmark::summarise(std::string name, std::vector<double>& samples, long iterations, ChronosBenchmarkOptions& options) {
+    ChronosBenchmarkResult result;
+    result.name = name;
+    result.iterations = iterations;
+    result.samples = static_cast<long>(samples.size());
+    result.process = ChronosProcess(name);
+    result.process.set_thread_id(ChronosProcess::k_benchmark_thread);
+    if (samples.empty()){
+        return result;
+    }// end of if
+
+    std::vector<double> sorted = samples;
+    std::sort(sorted.begin(), sorted.end());
+    double sum = 0;
+    for (double sample: samples){
+        sum += sample;
+    }// end of for
+    long count = result.samples;
+    result.mean = sum / count;
+    result.median = count % 2 == 1 ? sorted[count / 2] : (sorted[count / 2 - 1] + sorted[count / 2]) / 2;
+    result.min = sorted.front();
+    result.max = sorted.back();
+    double squares = 0;
+    for (double sample: samples){
+        squares += (sample - result.mean) * (sample - result.mean);
+    }// end of for
+    result.std_dev = count > 1 ? std::sqrt(squares / (count - 1)) : 0;
+    double error = count > 1 ? t_value(count - 1, options.confidence) * result.std_dev / std::sqrt(static_cast<double>(count)) : 0;
+    result.ci_low = result.mean - error;
+    result.ci_high = result.mean + error;
+    result.throughput = result.mean > 0 ? options.items_per_iteration / result.mean : 0;
+
+    // Every sample stands for its iterations, all taking the sample's time per iteration
+    ChronosProcess& process = result.process;
+    ChronosHistogram histogram;
+    double sum_squares = 0;
+    for (double sample: samples){
+        histogram.add(ChronosHistogram::bucket_index(static_cast<unsigned long long>(sample * 1e9)), iterations);
+        sum_squares += sample * sample * iterations;
+    }// end of for
+    process.set_total_calls(static_cast<double>(count) * iterations);
+    process.set_timed_calls(count * iterations);
+    process.set_total_time(sum * iterations);
+    process.set_inclusive_time(sum * iterations);
+    process.set_self_time(sum * iterations);
+    process.set_mean_time(result.mean);
+    process.set_min_time(result.min);
+    process.set_max_time(result.max);
+    process.set_sum_squares(sum_squares);
+    process.set_histogram(histogram);
+    return result;
+}
+
+bool ChronosBenchmark::is_stable(std::vector<double>& samples, ChronosBenchmarkOptions& options) {
+    long count = static_cast<long>(samples.size());
+    if (count < 2){
+        return false;
+    }// end of if
+    double sum = 0;
+    for (double sample: samples){
+        sum += sample;
+    }// end of for
+    double mean = sum / count;
+    double squares = 0;
+    for (double sample: samples){
+        squares += (sample - mean) * (sample - mean);
+    }// end of for
+    double error = t_value(count - 1, options.confidence) * std::sqrt(squares / (count - 1) / count);
+    return error <= options.target_error * mean;
+}
+
+double ChronosBenchmark::t_value(long degrees, double confidence) {
+    // Two-sided critical values for 1 to 30 degrees of freedom, at 90%, 95% and 99%
+    static const double table[3][30] = {
+        {6.314, 2.920, 2.353, 2.132, 2.015, 1.943, 1.895, 1.860, 1.833, 1.812, 1.796, 1.782, 1.771, 1.761, 1.753,
+         1.746, 1.740, 1.734, 1.729, 1.725, 1.721, 1.717, 1.714, 1.711, 1.708, 1.706, 1.703, 1.701, 1.699, 1.697},
+        {12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228, 2.201, 2.179, 2.160, 2.145, 2.131,
+         2.120, 2.110, 2.101, 2.093, 2.086, 2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042},
+        {63.657, 9.925, 5.841, 4.604, 4.032, 3.707, 3.499, 3.355, 3.250, 3.169, 3.106, 3.055, 3.012, 2.977, 2.947,
+         2.921, 2.898, 2.878, 2.861, 2.845, 2.831, 2.819, 2.807, 2.797, 2.787, 2.779, 2.771, 2.763, 2.756, 2.750}
+    };
+    static const double normal[3] = {1.645, 1.960, 2.576};
+    int level = confidence < 0.925 ? 0 : (confidence < 0.97 ? 1 : 2);
+    if (degrees < 1){
+        degrees = 1;
+    }// end of if
+    if (degrees <= 30){
+        return table[level][degrees - 1];
+    }// end of if
+    // Past the table, the first term of the expansion of t around the normal distribution is close enough
+    double z = normal[level];
+    return z + (z * z * z + z) / (4.0 * degrees);
+}
+
+std::string ChronosBenchmark::get_header_csv() {
+    // In nanoseconds, which the seconds of the profile are too coarse for
+    return "Mean (ns),Median (ns),Std Dev (ns),Min (ns),Max (ns),CI Low (ns),CI High (ns),Throughput (items/s),Iterations,Samples,Calling Function";
+}
+
+std::string ChronosBenchmark::to_csv(ChronosBenchmarkResult& result) {
+    return std::to_string(result.mean * 1e9) + "," + std::to_string(result.median * 1e9) + "," + std::to_string(result.std_dev * 1e9)
+           + "," + std::to_string(result.min * 1e9) + "," + std::to_string(result.max * 1e9) + "," + std::to_string(result.ci_low * 1e9)
+           + "," + std::to_string(result.ci_high * 1e9) + "," + std::to_string(result.throughput) + ","
+           + std::to_string(result.iterations) + "," + std::to_string(result.samples) + "," + result.name;
+}
+
+std::string ChronosBenchmark::to_string(ChronosBenchmarkResult& result) {
+    // The times of micro-benchmarks are mostly well below the microseconds the profile shows, so they are given in nanoseconds
+    return result.name + ": " + std::to_string(result.mean * 1e9) + " ns +- " + std::to_string((result.ci_high - result.mean) * 1e9)
+           + " ns, median " + std::to_string(result.median * 1e9) + " ns, std dev " + std::to_string(result.std_dev * 1e9)
+           + " ns, " + std::to_string(result.throughput) + " items/s, " + std::to_string(result.samples) + " samples of "
+           + std::to_string(result.iterations) + " iterations";
+}
@@ -0,0 +1,197 @@
+/**   Copyright 2020 Benrick Smit
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ * 
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+*/
+
+/**
+ * @author: Benrick Smit
+ * @email: metatronicprogramming@hotmail.com
+ * @date: 13 June 2020
+ * @modified: 13 June 2020
+ * 
+ * @brief: This class benchmarks a single callable, rather than profiling a running program. It runs the callable for a
+ *          warmup period, then doubles the iterations per sample until one sample takes long enough to time reliably, and
+ *          takes samples until the confidence interval of the mean is narrow enough, or the time budget is spent. The
+ *          result of the callable, if any, is passed to do_not_optimize, so the compiler can not drop the work.
+ * 
+ *          The samples are kept as the time per iteration of every sample, and summarised in a ChronosProcess, so the
+ *          benchmarks can be written in the same reports as the profiled functions.
+ * 
+ */ 
+
+#pragma once
+
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "ChronosClock.h"
+#include "ChronosProcess.h"
+
+/**
+ * @brief The settings of a benchmark, all in seconds where they are times
+ * 
+ */
+struct ChronosBenchmarkOptions {
+	double warmup_time = 0.1;													// Time the callable is run before sampling
+	double sample_time = 0.01;													// Shortest time one sample may take
+	long min_samples = 10;														// Samples taken in any case
+	long max_samples = 1000;													// Samples taken at most
+	double max_time = 5.0;														// Time budget for the samples
+	double target_error = 0.01;													// Sampling stops once the interval is this share of the mean
+	double confidence = 0.95;													// Confidence of the interval, 0.90, 0.95 or 0.99
+	double items_per_iteration = 1;												// Items one call processes, for the throughput
+};
+
+/**
+ * @brief The statistics of a benchmark, with the times in seconds per iteration
+ * 
+ */
+struct ChronosBenchmarkResult {
+	std::string name;
+	long iterations = 0;														// Iterations per sample
+	long samples = 0;
+	double mean = 0;
+	double median = 0;
+	double std_dev = 0;															// Of the samples' times per iteration
+	double min = 0;
+	double max = 0;
+	double ci_low = 0;															// Confidence interval of the mean
+	double ci_high = 0;
+	double throughput = 0;														// Items per second
+	ChronosProcess process;														// The samples, for the reports
+};
+
+class ChronosBenchmark {
+	public:
+		/**
+		 * @brief Keeps the compiler from optimising away the computation of a value
+		 * 
+		 * @param value 
+		 */
+		template <typename T>
+		static inline void do_not_optimize(T const& value) {
+			asm volatile("" : : "r,m"(value) : "memory");
+		}
+		/**
+		 * @brief Keeps the compiler from optimising away, or moving, writes to memory
+		 * 
+		 */
+		static inline void clobber_memory() {
+			asm volatile("" : : : "memory");
+		}
+
+		/**
+		 * @brief Benchmarks a callable which takes no arguments
+		 * 
+		 * @param name the name in the reports
+		 * @param callable 
+		 * @param options 
+		 * @return ChronosBenchmarkResult 
+		 */
+		template <typename Callable>
+		static ChronosBenchmarkResult run(std::string name, Callable&& callable, ChronosBenchmarkOptions options) {
+			double period = ChronosClock::get_seconds_per_tick();
+
+			// Warm the caches and the branch predictors up, while finding how many iterations one sample needs
+			long iterations = 1;
+			long long warmup_end = ChronosClock::start_ticks() + static_cast<long long>(options.warmup_time / period);
+			do {
+				if (time_batch(callable, iterations) * period < options.sample_time && iterations < k_max_iterations){
+					iterations *= 2;
+				}// end of if
+			} while (ChronosClock::start_ticks() < warmup_end);
+			while (time_batch(callable, iterations) * period < options.sample_time && iterations < k_max_iterations){
+				iterations *= 2;
+			}// end of while
+
+			// Then take samples until the mean is known well enough
+			std::vector<double> samples;
+			long long budget_end = ChronosClock::start_ticks() + static_cast<long long>(options.max_time / period);
+			while (static_cast<long>(samples.size()) < options.max_samples){
+				samples.push_back(time_batch(callable, iterations) * period / iterations);
+				long count = static_cast<long>(samples.size());
+				if (count >= options.min_samples && (is_stable(samples, options) || ChronosClock::start_ticks() > budget_end)){
+					break;
+				}// end of if
+			}// end of while
+			return summarise(name, samples, iterations, options);
+		}
+
+		/**
+		 * @brief Works out the statistics of the samples
+		 * 
+		 * @param name 
+		 * @param samples the seconds per iteration of every sample
+		 * @param iterations the iterations per sample
+		 * @param options 
+		 * @return ChronosBenchmarkResult 
+		 */
+		static ChronosBenchmarkResult summarise(std::string name, std::vector<double>& samples, long iterations, ChronosBenchmarkOptions& options);
+		/**
+		 * @brief Whether the confidence interval of the mean is within the target error
+		 * 
+		 * @param samples 
+		 * @param options 
+		 * @return true 
+		 * @return false 
+		 */
+		static bool is_stable(std::vector<double>& samples, ChronosBenchmarkOptions& options);
+		/**
+		 * @brief Get the two-sided critical value of Student's t distribution
+		 * 
+		 * @param degrees the degrees of freedom
+		 * @param confidence 0.90, 0.95 or 0.99; anything else is taken as 0.95
+		 * @return double 
+		 */
+		static double t_value(long degrees, double confidence);
+		/**
+		 * @brief Get the header data for the benchmark csv file, which gives the times in nanoseconds
+		 * 
+		 * @return std::string 
+		 */
+		static std::string get_header_csv();
+		/**
+		 * @brief Converts a result into a format suitable for csv processing
+		 * 
+		 * @param result 
+		 * @return std::string 
+		 */
+		static std::string to_csv(ChronosBenchmarkResult& result);
+		/**
+		 * @brief Converts a result into a format suitable for human processing
+		 * 
+		 * @param result 
+		 * @return std::string 
+		 */
+		static std::string to_string(ChronosBenchmarkResult& result);
+
+	private:
+		static const long k_max_iterations = 1l << 40;						// Upper limit of the iterations per sample
+
+		// Calls the callable the given number of times, and returns the ticks it took
+		template <typename Callable>
+		static inline long long time_batch(Callable& callable, long iterations) {
+			long long start = ChronosClock::start_ticks();
+			for (long i = 0; i < iterations; i++){
+				if constexpr (std::is_void<decltype(callable())>::value){
+					callable();
+					clobber_memory();
+				}else{
+					do_not_optimize(callable());
+				}// end of if else
+			}// end of for
+			return ChronosClock::stop_ticks() - start;
+		}
+};
@@ -0,0 +1,371 @@
+/**   Copyright 2020 Benrick Smit
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ * 
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+*/
+
+/**
+ * @author: Benrick Smit
+ * @email: metatronicprogramming@hotmail.com
+ * @date: 13 June 2020
+ * @modified: 13 June 2020
+ * 
+ * @brief: This class folds the call trees recorded by the threads into a call graph similar to the one gprof prints, and
+ *          into folded stacks for flame graphs.
+ * 
+ */ 
+
+
+#include "ChronosCallGraph.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+
+//Ctors and Dtors
+ChronosCallGraph::ChronosCallGraph(std::vector<ChronosSiteName>& sites) {
+    for (ChronosSiteName& site: sites){
+        m_names.push_back(std::string(site.name));
+    }// end of for
+    m_inner_cost = 0;
+    m_timed_cost = 0;
+    m_untimed_cost = 0;
+    m_collapse = false;
+    m_stacks.push_back({-1, -1, -1, 0});
+}
+
+ChronosCallGraph::~ChronosCallGraph() {
+    // Do Nothing
+}
+
+//Basic Functionality
+void ChronosCallGraph::compensate(ChronosOverhead& overhead) {
+    m_inner_cost = overhead.get_inner_cost();
+    m_timed_cost = overhead.get_timed_cost();
+    m_untimed_cost = overhead.get_untimed_cost();
+}
+
+void ChronosCallGraph::collapse_recursion(bool enabled) {
+    m_collapse = enabled;
+}
+
+void ChronosCallGraph::add_thread(ChronosThread& thread) {
+    // Copy the tree, the owner may still be adding nodes past the count read here
+    long count = thread.get_node_count();
+    std::vector<ChronosNodeData> nodes(count);
+    std::vector<long long> children(count, 0);
+    std::vector<std::vector<long>> child_lists(count);
+    for (long i = 0; i < count; i++){
+        thread.read_node(i, nodes[i]);
+    }// end of for
+
+    for (long i = 0; i < count; i++){
+        if (nodes[i].timed > 0){
+            // The timed calls are already extrapolated to all of the path's calls, and so are the calls made below them, so
+            // the profiler's cost is taken out of the same calls it was timed in: its own timing, and the calls below
+            double overhead = m_inner_cost * nodes[i].weight + m_timed_cost * nodes[i].timed_below
+                + m_untimed_cost * nodes[i].untimed_below;
+            nodes[i].inclusive = std::max(0ll, static_cast<long long>(nodes[i].inclusive - overhead));
+        }// end of if
+        if (nodes[i].parent >= 0){
+            child_lists[nodes[i].parent].push_back(i);
+        }// end of if
+    }// end of for
+
+    // A path whose calls were all sampled out took the time of the calls below it, and the self time per call of its site.
+    // That comes from the site's timed paths, less the sampled out paths below them, so it is solved in a few rounds: the
+    // paths of the same site below a timed one, as recursion makes, are weighed in its own equation, the rest use the last round
+    long site_count = 0;
+    for (long i = 0; i < count; i++){
+        site_count = std::max(site_count, nodes[i].site + 1);
+    }// end of for
+    std::vector<long> timed_above(count, 0);
+    std::vector<double> site_calls(site_count, 0);
+    std::vector<double> chain_calls(site_count, 0);
+    for (long i = 0; i < count; i++){
+        long parent = nodes[i].parent >= 0 && nodes[i].parent < i ? nodes[i].parent : 0;
+        timed_above[i] = i == 0 ? 0 : (nodes[parent].timed > 0 ? parent : timed_above[parent]);
+        if (nodes[i].site < 0){
+            continue;
+        }// end of if
+        if (nodes[i].timed > 0){
+            site_calls[nodes[i].site] += nodes[i].calls;
+        }else if (nodes[timed_above[i]].site == nodes[i].site){
+            chain_calls[nodes[i].site] += nodes[i].calls;
+        }// end of if else
+    }// end of for
+    std::vector<double> site_self(site_count, 0);
+    std::vector<double> measured(site_count, 0);
+    for (int round = 0; round <= k_self_rounds; round++){
+        std::fill(children.begin(), children.end(), 0);
+        std::fill(measured.begin(), measured.end(), 0);
+        for (long i = count - 1; i >= 0; i--){
+            long site = nodes[i].site;
+            if (nodes[i].timed == 0){
+                nodes[i].inclusive = children[i] + (site >= 0 ? static_cast<long long>(site_self[site] * nodes[i].calls) : 0);
+            }else if (site >= 0){
+                measured[site] += static_cast<double>(nodes[i].inclusive - children[i]);
+            }// end of if else
+            if (nodes[i].parent >= 0 && nodes[i].parent < i){
+                children[nodes[i].parent] += nodes[i].inclusive;
+            }// end of if
+        }// end of for
+        if (round == k_self_rounds){
+            break;
+        }// end of if
+        for (long site = 0; site < site_count; site++){
+            if (site_calls[site] > 0){
+                double own = (measured[site] + site_self[site] * chain_calls[site]) / (site_calls[site] + chain_calls[site]);
+                site_self[site] = std::max(0.0, own);
+            }// end of if
+        }// end of for
+    }// end of for
+
+    // Every path is estimated on its own, so the paths below a timed one can still add up to more than it by chance. The
+    // children are then fitted into their parent, scaling the whole of their subtrees down
+    std::vector<double> fit(count, 1);
+    std::vector<long long> self(count, 0);
+    for (long i = 0; i < count; i++){
+        long parent = nodes[i].parent;
+        if (parent >= 0 && parent < i && children[parent] > nodes[parent].inclusive){
+            fit[i] = fit[parent] * nodes[parent].inclusive / static_cast<double>(children[parent]);
+        }else if (parent >= 0 && parent < i){
+            fit[i] = fit[parent];
+        }// end of if else
+        self[i] = static_cast<long long>(fit[i] * (nodes[i].inclusive - std::min(nodes[i].inclusive, children[i])));
+    }// end of for
+    for (long i = 0; i < count; i++){
+        nodes[i].inclusive = static_cast<long long>(fit[i] * nodes[i].inclusive);
+    }// end of for
+
+    // Merge the paths into the stacks. The self time of a path is its own, so a recursive call's time is never counted
+    // in its caller's as well
+    long name_count = static_cast<long>(m_names.size());
+    std::vector<long> stacks(count, 0);
+    for (long i = 1; i < count; i++){
+        long parent = nodes[i].parent >= 0 && nodes[i].parent < i ? stacks[nodes[i].parent] : 0;
+        long site = nodes[i].site;
+        if (site < 0 || site >= name_count || (m_collapse && m_stacks[parent].site == site)){
+            // An unnamed call, or a recursive one when collapsing, adds its time to the frame it was called from
+            stacks[i] = parent;
+        }else{
+            stacks[i] = find_stack(parent, site);
+        }// end of if else
+        m_stacks[stacks[i]].self += self[i];
+    }// end of for
+
+    // Walk the tree depth first, counting how often every site is already on the path, to spot the recursive calls
+    std::vector<long> on_path(m_names.size(), 0);
+    std::vector<std::pair<long, bool>> pending;                 // Node, and whether its children have been visited
+    pending.push_back({0, false});
+    while (!pending.empty()){
+        long index = pending.back().first;
+        bool visited = pending.back().second;
+        pending.pop_back();
+        ChronosNodeData& node = nodes[index];
+        bool named = node.site >= 0 && node.site < static_cast<long>(m_names.size());
+
+        if (visited){
+            if (named){
+                on_path[node.site]--;
+            }// end of if
+            continue;
+        }// end of if
+
+        if (named && node.calls > 0){
+            bool recursive = on_path[node.site] > 0;
+            const std::string& name = m_names[node.site];
+
+            Times& function = m_functions[name];
+            function.calls += node.calls;
+            function.self += self[index];
+            if (!recursive){
+                function.inclusive += node.inclusive;
+            }// end of if
+
+            std::string caller = "<spontaneous>";
+            if (nodes[node.parent].site >= 0 && nodes[node.parent].site < static_cast<long>(m_names.size())){
+                caller = m_names[nodes[node.parent].site];
+            }// end of if
+            Times& edge = m_edges[{caller, name}];
+            edge.calls += node.calls;
+            edge.inclusive += node.inclusive;
+            edge.self += self[index];
+        }// end of if
+
+        if (named){
+            on_path[node.site]++;
+        }// end of if
+        pending.push_back({index, true});
+        for (long child: child_lists[index]){
+            pending.push_back({child, false});
+        }// end of for
+    }// end of while
+}
+
+void ChronosCallGraph::fill(ChronosProcess& process) {
+    auto found = m_functions.find(process.get_name());
+    if (found == m_functions.end()){
+        return;
+    }// end of if
+    double period = ChronosClock::get_seconds_per_tick();
+    process.set_inclusive_time(found->second.inclusive * period);
+    process.set_self_time(found->second.self * period);
+}
+
+std::string ChronosCallGraph::to_string() {
+    // Order the functions by their inclusive time
+    std::vector<std::pair<long long, std::string>> order;
+    for (auto& function: m_functions){
+        order.push_back({function.second.inclusive, function.first});
+    }// end of for
+    std::sort(order.begin(), order.end(), [](const std::pair<long long, std::string>& a, const std::pair<long long, std::string>& b){
+        return a.first > b.first;
+    });
+    std::map<std::string, unsigned long> index;
+    for (unsigned long i = 0; i < order.size(); i++){
+        index[order[i].second] = i + 1;
+    }// end of for
+
+    // The edges are ordered by caller, so the callers of each function are gathered separately
+    std::map<std::string, std::vector<std::pair<const std::string*, Times*>>> callers;
+    for (auto& edge: m_edges){
+        callers[edge.first.second].push_back({&edge.first.first, &edge.second});
+    }// end of for
+
+    std::string to_return = "Index\t\tInclusive Time\t\tSelf Time\t\tCalls\t\t\tName\n";
+    for (unsigned long i = 0; i < order.size(); i++){
+        const std::string& name = order[i].second;
+        Times& function = m_functions[name];
+
+        // Callers of the function
+        for (auto& edge: callers[name]){
+            std::string caller = *edge.first;
+            if (index.count(caller) > 0){
+                caller += " [" + std::to_string(index[caller]) + "]";
+            }// end of if
+            to_return += "\t\t\t" + seconds(edge.second->inclusive) + "\t\t" + seconds(edge.second->self) + "\t\t"
+                         + std::to_string(edge.second->calls) + "/" + std::to_string(function.calls) + "\t\t\t\t" + caller
+                         + (*edge.first == name ? " (recursive)" : "") + '\n';
+        }// end of for
+
+        // The function itself
+        to_return += "[" + std::to_string(i + 1) + "]\t\t" + seconds(function.inclusive) + "\t\t" + seconds(function.self)
+                    + "\t\t" + std::to_string(function.calls) + "\t\t\t" + name + " [" + std::to_string(i + 1) + "]\n";
+
+        // Callees of the function, which follow each other in the edge map
+        for (auto edge = m_edges.lower_bound({name, ""}); edge != m_edges.end() && edge->first.first == name; ++edge){
+            const std::string& callee = edge->first.second;
+            to_return += "\t\t\t" + seconds(edge->second.inclusive) + "\t\t" + seconds(edge->second.self) + "\t\t"
+                         + std::to_string(edge->second.calls) + "/" + std::to_string(m_functions[callee].calls) + "\t\t\t\t"
+                         + callee + " [" + std::to_string(index[callee]) + "]" + (callee == name ? " (recursive)" : "") + '\n';
+        }// end of for
+        to_return += "-----------------------------------------------\n";
+    }// end of for
+
+    return to_return;
+}
+
+bool ChronosCallGraph::write_folded(std::string folded_path) {
+    FILE* folded_file = fopen(folded_path.c_str(), "w");
+    if (folded_file == nullptr){
+        std::string error_string = "Error writing file to: \"" + folded_path + "\"";
+        perror(error_string.c_str());
+        return false;
+    }// end of if
+
+    // Everything goes through one fixed buffer, flushed whenever it runs low
+    std::vector<char> buffer(1 << 20);
+    unsigned long used = 0;
+    auto flush = [&](){
+        fwrite(buffer.data(), 1, used, folded_file);
+        used = 0;
+    };
+    auto append = [&](const char* data, unsigned long length){
+        if (used + length > buffer.size()){
+            flush();
+        }// end of if
+        if (length > buffer.size()){
+            fwrite(data, 1, length, folded_file);
+            return;
+        }// end of if
+        std::memcpy(buffer.data() + used, data, length);
+        used += length;
+    };
+
+    // The frames can not hold the separators of the format, which are replaced once per site, not once per stack
+    std::vector<std::string> frames(m_names);
+    for (std::string& frame: frames){
+        std::replace(frame.begin(), frame.end(), ';', ':');
+        std::replace(frame.begin(), frame.end(), '\n', ' ');
+        std::replace(frame.begin(), frame.end(), '\r', ' ');
+        if (frame.empty()){
+            frame = "?";
+        }// end of if
+    }// end of for
+    double nanoseconds = ChronosClock::get_seconds_per_tick() * 1e9;
+
+    // Walk the stacks depth first; the path is cut back to the length of the parent's before every stack is added to it
+    std::string path;
+    std::vector<std::pair<long, unsigned long>> pending;        // Stack, and the length of its parent's path
+    for (long child = m_stacks[0].first_child; child >= 0; child = m_stacks[child].next_sibling){
+        pending.push_back({child, 0});
+    }// end of for
+    char number[32];
+    while (!pending.empty()){
+        long index = pending.back().first;
+        unsigned long length = pending.back().second;
+        pending.pop_back();
+        const Stack& stack = m_stacks[index];
+        path.resize(length);
+        if (length > 0){
+            path += ';';
+        }// end of if
+        path += frames[stack.site];
+
+        long long self = std::llround(stack.self * nanoseconds);
+        if (self > 0){
+            append(path.data(), path.size());
+            int written = snprintf(number, sizeof(number), " %lld\n", self);
+            append(number, static_cast<unsigned long>(written));
+        }// end of if
+        for (long child = stack.first_child; child >= 0; child = m_stacks[child].next_sibling){
+            pending.push_back({child, path.size()});
+        }// end of for
+    }// end of while
+    flush();
+
+    bool success = ferror(folded_file) == 0;
+    fclose(folded_file);
+    return success;
+}
+
+//Private Functions
+std::string ChronosCallGraph::seconds(long long ticks) {
+    return std::to_string(ticks * ChronosClock::get_seconds_per_tick());
+}
+
+long ChronosCallGraph::find_stack(long parent, long site) {
+    // The site is below the number of names, so every parent and site give a distinct key
+    unsigned long long key = static_cast<unsigned long long>(parent) * m_names.size() + static_cast<unsigned long long>(site);
+    auto found = m_stack_index.find(key);
+    if (found != m_stack_index.end()){
+        return found->second;
+    }// end of if
+    long index = static_cast<long>(m_stacks.size());
+    m_stacks.push_back({site, -1, m_stacks[parent].first_child, 0});
+    m_stacks[parent].first_child = index;
+    m_stack_index.emplace(key, index);
+    return index;
+}
@@ -0,0 +1,135 @@
+/**   Copyright 2020 Benrick Smit
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ * 
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+*/
+
+/**
+ * @author: Benrick Smit
+ * @email: metatronicprogramming@hotmail.com
+ * @date: 13 June 2020
+ * @modified: 13 June 2020
+ * 
+ * @brief: This class folds the call trees recorded by the threads into a call graph similar to the one gprof prints. Every
+ *          function gets its inclusive time (children included) and its exclusive, or self, time, and every caller to callee
+ *          edge gets its calls and times. Calls of a function from within itself are marked as recursive, and are not counted
+ *          a second time in the function's inclusive time. The paths of the trees are also merged over the threads into
+ *          stacks, each with the self time spent on it, which are written in the folded format flame graph tools read.
+ * 
+ */ 
+
+#pragma once
+
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "ChronosArena.h"
+#include "ChronosOverhead.h"
+#include "ChronosProcess.h"
+#include "ChronosThread.h"
+
+class ChronosCallGraph {
+	public:
+		//ctors and dtors
+		/**
+		 * @brief Construct a new Chronos Call Graph object
+		 * 
+		 * @param sites the names of the registered sites, indexed by site handle
+		 */
+		ChronosCallGraph(std::vector<ChronosSiteName>& sites);
+		/**
+		 * @brief Destroy the Chronos Call Graph object
+		 * 
+		 */
+		~ChronosCallGraph();
+
+		//Basic Operation
+		/**
+		 * @brief Takes the profiler's own cost out of the times of the threads added after this: the cost of timing every call,
+		 *          and the cost of every call made below it
+		 * 
+		 * @param overhead a calibrated overhead
+		 */
+		void compensate(ChronosOverhead& overhead);
+		/**
+		 * @brief Folds the recursive calls of the threads added after this into the call which made them, in the stacks: a
+		 *          function calling itself gives one frame rather than one per level. The call graph is not affected.
+		 * 
+		 * @param enabled 
+		 */
+		void collapse_recursion(bool enabled);
+		/**
+		 * @brief Adds the call tree of a thread to the graph
+		 * 
+		 * @param thread 
+		 */
+		void add_thread(ChronosThread& thread);
+		/**
+		 * @brief Sets the inclusive and self time of the process from the graph, matched by name
+		 * 
+		 * @param process 
+		 */
+		void fill(ChronosProcess& process);
+		/**
+		 * @brief Converts the graph into a format suitable for human processing. The functions are ordered by inclusive time, each
+		 *          with its callers listed above it and its callees below it.
+		 * 
+		 * @return std::string 
+		 */
+		std::string to_string();
+		/**
+		 * @brief Writes the stacks in the folded format of Brendan Gregg's flamegraph.pl, which inferno and speedscope read as
+		 *          well: a line per stack, of its frames from the root separated by ';', a space, and its self time in
+		 *          nanoseconds. Stacks without self time are left out. The lines are streamed through a fixed buffer, the path
+		 *          of the stack being extended and cut back while the stacks are walked, so the cost is that of the output.
+		 * 
+		 * @param folded_path 
+		 * @return true if the file was written
+		 */
+		bool write_folded(std::string folded_path);
+
+	private:
+		// The times of a function, or of one of its edges, in clock ticks
+		struct Times {
+			long calls = 0;
+			long long inclusive = 0;
+			long long self = 0;
+		};
+
+		// A path of sites from the root, merged over the threads
+		struct Stack {
+			long site;
+			long first_child;
+			long next_sibling;
+			long long self = 0;
+		};
+
+		// Converts the ticks to the report's format
+		std::string seconds(long long ticks);
+		// Get the child of a stack for a site, adding it if there is none
+		long find_stack(long parent, long site);
+
+		static const int k_self_rounds = 4;										// Rounds solving the self time of the sampled out paths
+
+		//Member variables
+		double m_inner_cost;													// Ticks taken off every timed call
+		double m_timed_cost;													// Ticks taken off a call for every timed call below it
+		double m_untimed_cost;													// Ticks taken off a call for every untimed call below it
+		std::vector<std::string> m_names;										// Name of every site handle
+		std::map<std::string, Times> m_functions;								// Times per function name
+		std::map<std::pair<std::string, std::string>, Times> m_edges;			// Times per caller and callee name
+		bool m_collapse;														// Whether recursive calls share their caller's stack
+		std::vector<Stack> m_stacks;											// Stacks of all the threads, 0 is the root
+		std::unordered_map<unsigned long long, long> m_stack_index;				// Maps the parent and site of a stack to the stack
+};
@@ -0,0 +1,91 @@
+/**   Copyright 2020 Benrick Smit
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ * 
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+*/
+
+/**
+ * @author: Benrick Smit
+ * @email: metatronicprogramming@hotmail.com
+ * @date: 13 June 2020
+ * @modified: 13 June 2020
+ * 
+ * @brief: These classes are the clock policies of the Chronos profiler.
+ * 
+ */ 
+
+
+#include "ChronosClock.h"
+
+#if CHRONOS_HAS_TSC
+#include <cpuid.h>
+#endif
+
+
+//Steady Clock
+void ChronosSteadyClock::calibrate() {
+    // Nothing to measure, the period is part of the type
+}
+
+double ChronosSteadyClock::get_seconds_per_tick() {
+    return static_cast<double>(std::chrono::steady_clock::period::num) / std::chrono::steady_clock::period::den;
+}
+
+std::string ChronosSteadyClock::get_name() {
+    return "steady_clock";
+}
+
+
+#if CHRONOS_HAS_TSC
+//Time Stamp Counter
+bool ChronosTscClock::m_invariant = false;
+double ChronosTscClock::m_seconds_per_tick = 0;
+
+void ChronosTscClock::calibrate() {
+    // Leaf 0x80000007 reports the invariant counter in bit 8 of edx
+    unsigned int eax = 0, ebx = 0, ecx = 0, edx = 0;
+    bool invariant = false;
+    if (__get_cpuid(0x80000000, &eax, &ebx, &ecx, &edx) && eax >= 0x80000007){
+        __get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx);
+        invariant = (edx & (1u << 8)) != 0;
+    }// end of if
+    if (!invariant){
+        m_invariant = false;
+        m_seconds_per_tick = ChronosSteadyClock::get_seconds_per_tick();
+        return;
+    }// end of if
+
+    // Count the ticks over a short, busy-waited interval of the steady clock
+    auto wall_start = std::chrono::steady_clock::now();
+    unsigned long long tsc_start = __rdtsc();
+    auto wall_stop = wall_start;
+    do {
+        wall_stop = std::chrono::steady_clock::now();
+    } while (wall_stop - wall_start < std::chrono::milliseconds(20));
+    unsigned long long tsc_stop = __rdtsc();
+
+    double seconds = std::chrono::duration_cast<std::chrono::duration<double>>(wall_stop - wall_start).count();
+    m_seconds_per_tick = seconds / static_cast<double>(tsc_stop - tsc_start);
+    m_invariant = true;
+}
+
+double ChronosTscClock::get_seconds_per_tick() {
+    return m_seconds_per_tick;
+}
+
+std::string ChronosTscClock::get_name() {
+    if (!m_invariant){
+        return ChronosSteadyClock::get_name() + " (time stamp counter not invariant)";
+    }// end of if
+    return "invariant TSC @ " + std::to_string(1e-9 / m_seconds_per_tick) + " GHz";
+}
+#endif
@@ -0,0 +1,138 @@
+/**   Copyright 2020 Benrick Smit
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ * 
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+*/
+
+/**
+ * @author: Benrick Smit
+ * @email: metatronicprogramming@hotmail.com
+ * @date: 13 June 2020
+ * @modified: 13 June 2020
+ * 
+ * @brief: These classes are the clock policies of the Chronos profiler. A clock hands out integer ticks on the hot path, and
+ *          only converts them to seconds when the reports are written, using a frequency calibrated at startup.
+ *          ChronosTscClock reads the invariant time stamp counter of x86 processors, which costs a few nanoseconds.
+ *          ChronosSteadyClock wraps std::chrono::steady_clock, and is the fallback on other processors, or when the time stamp
+ *          counter is not invariant. The policy is chosen at compile time through CHRONOS_USE_TSC.
+ * 
+ */ 
+
+#pragma once
+
+#include <chrono>
+#include <string>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define CHRONOS_HAS_TSC 1
+#else
+#define CHRONOS_HAS_TSC 0
+#endif
+
+#ifndef CHRONOS_USE_TSC
+#define CHRONOS_USE_TSC CHRONOS_HAS_TSC
+#endif
+
+class ChronosSteadyClock {
+	public:
+		/**
+		 * @brief Reads the clock at the start of a measurement
+		 * 
+		 * @return long long the current time in ticks
+		 */
+		static inline long long start_ticks() {
+			return std::chrono::steady_clock::now().time_since_epoch().count();
+		}
+		/**
+		 * @brief Reads the clock at the end of a measurement
+		 * 
+		 * @return long long the current time in ticks
+		 */
+		static inline long long stop_ticks() {
+			return std::chrono::steady_clock::now().time_since_epoch().count();
+		}
+		/**
+		 * @brief Determines the length of a tick. For the steady clock it is known at compile time.
+		 * 
+		 */
+		static void calibrate();
+		/**
+		 * @brief Get the seconds per tick object
+		 * 
+		 * @return double 
+		 */
+		static double get_seconds_per_tick();
+		/**
+		 * @brief Get the name object, for the reports
+		 * 
+		 * @return std::string 
+		 */
+		static std::string get_name();
+};
+
+#if CHRONOS_HAS_TSC
+class ChronosTscClock {
+	public:
+		/**
+		 * @brief Reads the time stamp counter at the start of a measurement
+		 * 
+		 * @return long long the current time in ticks
+		 */
+		static inline long long start_ticks() {
+			if (m_invariant){
+				return static_cast<long long>(__rdtsc());
+			}// end of if
+			return ChronosSteadyClock::start_ticks();
+		}
+		/**
+		 * @brief Reads the time stamp counter at the end of a measurement. rdtscp waits for the measured work to complete first.
+		 * 
+		 * @return long long the current time in ticks
+		 */
+		static inline long long stop_ticks() {
+			if (m_invariant){
+				unsigned int aux;
+				return static_cast<long long>(__rdtscp(&aux));
+			}// end of if
+			return ChronosSteadyClock::stop_ticks();
+		}
+		/**
+		 * @brief Checks whether the time stamp counter is invariant, and measures its frequency against the steady clock.
+		 *          Falls back to the steady clock when the counter is not invariant.
+		 * 
+		 */
+		static void calibrate();
+		/**
+		 * @brief Get the seconds per tick object
+		 * 
+		 * @return double 
+		 */
+		static double get_seconds_per_tick();
+		/**
+		 * @brief Get the name object, for the reports
+		 * 
+		 * @return std::string 
+		 */
+		static std::string get_name();
+
+	private:
+		static bool m_invariant;												// Whether the counter can be used at all
+		static double m_seconds_per_tick;										// Calibrated length of a tick
+};
+#endif
+
+#if CHRONOS_USE_TSC && CHRONOS_HAS_TSC
+using ChronosClock = ChronosTscClock;
+#else
+using ChronosClock = ChronosSteadyClock;
+#endif
@@ -0,0 +1,228 @@
+/**   Copyright 2020 Benrick Smit
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ * 
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+*/
+
+/**
+ * @author: Benrick Smit
+ * @email: metatronicprogramming@hotmail.com
+ * @date: 13 June 2020
+ * @modified: 13 June 2020
+ * 
+ * @brief: This class reads the hardware performance counters of the calling thread.
+ * 
+ */ 
+
+
+#include "ChronosCounters.h"
+
+#include <cstdint>
+#include <cstring>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+
+#if defined(__linux__)
+namespace {
+    // The type and config of every counter, in the order of the k_ constants
+    const std::uint32_t k_types[ChronosCounters::k_counter_count] = {
+        PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE, PERF_TYPE_HW_CACHE, PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE
+    };
+    const std::uint64_t k_configs[ChronosCounters::k_counter_count] = {
+        PERF_COUNT_HW_CPU_CYCLES,
+        PERF_COUNT_HW_INSTRUCTIONS,
+        PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16),
+        PERF_COUNT_HW_CACHE_MISSES,
+        PERF_COUNT_HW_BRANCH_MISSES
+    };
+
+    int open_counter(int counter, int group) {
+        perf_event_attr attr;
+        std::memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = k_types[counter];
+        attr.config = k_configs[counter];
+        attr.read_format = PERF_FORMAT_GROUP;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, group, 0));
+    }
+}
+#endif
+
+
+//Ctors and Dtors
+ChronosCounters::ChronosCounters() {
+    for (int i = 0; i < k_counter_count; i++){
+        m_fds[i] = -1;
+        m_pages[i] = nullptr;
+        m_members[i] = -1;
+    }// end of for
+    m_member_count = 0;
+    m_rdpmc = false;
+    m_page_size = 0;
+}
+
+ChronosCounters::~ChronosCounters() {
+    close();
+}
+
+//Basic Functionality
+bool ChronosCounters::open() {
+#if defined(__linux__)
+    if (is_open()){
+        return true;
+    }// end of if
+    m_page_size = static_cast<unsigned long>(sysconf(_SC_PAGESIZE));
+    // The cycles lead the group, the others are optional
+    for (int i = 0; i < k_counter_count; i++){
+        m_fds[i] = open_counter(i, i == k_cycles ? -1 : m_fds[k_cycles]);
+        if (m_fds[i] < 0){
+            if (i == k_cycles){
+                return false;
+            }// end of if
+            continue;
+        }// end of if
+        m_members[m_member_count++] = i;
+    }// end of for
+
+    // Map the pages rdpmc needs, and fall back to reading the group if any counter can not use it
+    m_rdpmc = true;
+    for (int i = 0; i < k_counter_count; i++){
+        if (m_fds[i] < 0){
+            continue;
+        }// end of if
+        void* page = mmap(nullptr, m_page_size, PROT_READ, MAP_SHARED, m_fds[i], 0);
+        if (page == MAP_FAILED){
+            m_rdpmc = false;
+            continue;
+        }// end of if
+        m_pages[i] = page;
+        m_rdpmc = m_rdpmc && static_cast<perf_event_mmap_page*>(page)->cap_user_rdpmc;
+    }// end of for
+#if !(defined(__x86_64__) || defined(__i386__))
+    m_rdpmc = false;
+#endif
+    return true;
+#else
+    return false;
+#endif
+}
+
+void ChronosCounters::close() {
+#if defined(__linux__)
+    for (int i = 0; i < k_counter_count; i++){
+        if (m_pages[i] != nullptr){
+            munmap(m_pages[i], m_page_size);
+            m_pages[i] = nullptr;
+        }// end of if
+    }// end of for
+    // The members before the leader
+    for (int i = k_counter_count - 1; i >= 0; i--){
+        if (m_fds[i] >= 0){
+            ::close(m_fds[i]);
+            m_fds[i] = -1;
+        }// end of if
+    }// end of for
+#endif
+    m_member_count = 0;
+    m_rdpmc = false;
+}
+
+bool ChronosCounters::is_open() {
+    return m_fds[k_cycles] >= 0;
+}
+
+bool ChronosCounters::uses_rdpmc() {
+    return m_rdpmc;
+}
+
+void ChronosCounters::read(unsigned long long* values) {
+    for (int i = 0; i < k_counter_count; i++){
+        values[i] = 0;
+    }// end of for
+#if defined(__linux__)
+    if (!is_open()){
+        return;
+    }// end of if
+    if (m_rdpmc){
+        bool mapped = true;
+        for (int i = 0; i < m_member_count && mapped; i++){
+            mapped = read_mapped(m_members[i], values[m_members[i]]);
+        }// end of for
+        if (mapped){
+            return;
+        }// end of if
+    }// end of if
+
+    // One read returns the whole group: the number of members, then their values in the order they joined
+    std::uint64_t group[1 + k_counter_count];
+    ssize_t size = ::read(m_fds[k_cycles], group, sizeof(std::uint64_t) * (1 + m_member_count));
+    if (size < static_cast<ssize_t>(sizeof(std::uint64_t))){
+        return;
+    }// end of if
+    for (std::uint64_t i = 0; i < group[0] && static_cast<int>(i) < m_member_count; i++){
+        values[m_members[i]] = group[1 + i];
+    }// end of for
+#endif
+}
+
+std::string ChronosCounters::get_name(int counter) {
+    static const char* names[k_counter_count] = {"cycles", "instructions", "L1 misses", "LLC misses", "branch misses"};
+    return counter >= 0 && counter < k_counter_count ? names[counter] : "";
+}
+
+bool ChronosCounters::is_available() {
+    ChronosCounters counters;
+    return counters.open();
+}
+
+//Private Functions
+bool ChronosCounters::read_mapped(int counter, unsigned long long& value) {
+#if defined(__linux__) && (defined(__x86_64__) || defined(__i386__))
+    volatile perf_event_mmap_page* page = static_cast<volatile perf_event_mmap_page*>(m_pages[counter]);
+    std::uint32_t sequence;
+    std::uint64_t count;
+    do {
+        sequence = page->lock;
+        __asm__ __volatile__("" ::: "memory");
+        std::uint32_t index = page->index;
+        // An index of 0 means the counter is not on the processor right now
+        if (!page->cap_user_rdpmc || index == 0){
+            return false;
+        }// end of if
+        count = page->offset;
+        std::int64_t pmc = static_cast<std::int64_t>(__rdpmc(static_cast<int>(index - 1)));
+        // The counter is only pmc_width bits wide, and sign extended
+        unsigned int shift = 64 - page->pmc_width;
+        pmc = static_cast<std::int64_t>(static_cast<std::uint64_t>(pmc) << shift) >> shift;
+        count += pmc;
+        __asm__ __volatile__("" ::: "memory");
+    } while (page->lock != sequence);
+    value = count;
+    return true;
+#else
+    (void)counter;
+    (void)value;
+    return false;
+#endif
+}
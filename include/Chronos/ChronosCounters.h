@@ -0,0 +1,119 @@
+/**   Copyright 2020 Benrick Smit
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ * 
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+*/
+
+/**
+ * @author: Benrick Smit
+ * @email: metatronicprogramming@hotmail.com
+ * @date: 13 June 2020
+ * @modified: 13 June 2020
+ * 
+ * @brief: This class reads the hardware performance counters of the calling thread through Linux's perf_event_open: cycles,
+ *          instructions, L1 data cache misses, last level cache misses and branch misses. The counters are opened as one
+ *          group, so they are always scheduled together, and only count in user space. Where the kernel allows it they are
+ *          read with the rdpmc instruction, from the pages it maps for them, which takes no system call; otherwise the whole
+ *          group is read with a single read.
+ * 
+ *          Counters the processor does not have are left out of the group and read as 0. When the cycles can not be counted,
+ *          which is the case in most containers and virtual machines, the group is not opened at all, and open returns false.
+ * 
+ */ 
+
+#pragma once
+
+#include <string>
+
+class ChronosCounters {
+	public:
+		static const int k_cycles = 0;
+		static const int k_instructions = 1;
+		static const int k_l1_misses = 2;
+		static const int k_llc_misses = 3;
+		static const int k_branch_misses = 4;
+		static const int k_counter_count = 5;
+
+		//ctors and dtors
+		/**
+		 * @brief Construct a new Chronos Counters object, which is closed until opened
+		 * 
+		 */
+		ChronosCounters();
+		/**
+		 * @brief Destroy the Chronos Counters object, closing the counters
+		 * 
+		 */
+		~ChronosCounters();
+
+		ChronosCounters(const ChronosCounters&) = delete;
+		ChronosCounters& operator=(const ChronosCounters&) = delete;
+
+		//Basic Operation
+		/**
+		 * @brief Opens the counters of the calling thread. They only count that thread, so they may only be read by it.
+		 * 
+		 * @return true if at least the cycles are counted
+		 */
+		bool open();
+		/**
+		 * @brief Closes the counters
+		 * 
+		 */
+		void close();
+		/**
+		 * @brief Whether the counters are open
+		 * 
+		 * @return true 
+		 * @return false 
+		 */
+		bool is_open();
+		/**
+		 * @brief Whether the counters are read with rdpmc, rather than with a system call
+		 * 
+		 * @return true 
+		 * @return false 
+		 */
+		bool uses_rdpmc();
+		/**
+		 * @brief Reads the current value of every counter
+		 * 
+		 * @param values k_counter_count values, indexed by the k_ constants
+		 */
+		void read(unsigned long long* values);
+		/**
+		 * @brief Get the name of a counter
+		 * 
+		 * @param counter one of the k_ constants
+		 * @return std::string 
+		 */
+		static std::string get_name(int counter);
+		/**
+		 * @brief Checks whether the counters can be opened, by opening and closing them on the calling thread
+		 * 
+		 * @return true 
+		 * @return false 
+		 */
+		static bool is_available();
+
+	private:
+		// Reads one counter from its mapped page, returns false if it has to be read with a system call
+		bool read_mapped(int counter, unsigned long long& value);
+
+		//Member variables
+		int m_fds[k_counter_count];												// Descriptor of every counter, -1 if not counted
+		void* m_pages[k_counter_count];											// The page the kernel maps for every counter
+		int m_members[k_counter_count];											// The counters in the order they joined the group
+		int m_member_count;
+		bool m_rdpmc;															// Whether every open counter may be read with rdpmc
+		unsigned long m_page_size;
+};
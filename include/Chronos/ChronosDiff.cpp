@@ -0,0 +1,529 @@
+/**   Copyright 2020 Benrick Smit
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ * 
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+*/
+
+/**
+ * @author: Benrick Smit
+ * @email: metatronicprogramming@hotmail.com
+ * @date: 13 June 2020
+ * @modified: 13 June 2020
+ * 
+ * @brief: This class compares two profiles written by Chronos.
+ * 
+ */ 
+
+
+#include "ChronosDiff.h"
+
+#include "ChronosHistogram.h"
+#include "ChronosProfileReader.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <tuple>
+
+
+// The relative change from a to b, NaN when either is not known
+static double relative_change(double a, double b) {
+    if (a < 0 || b < 0 || std::isnan(a) || std::isnan(b)){
+        return std::numeric_limits<double>::quiet_NaN();
+    }// end of if
+    if (a == 0){
+        return b == 0 ? 0 : std::numeric_limits<double>::infinity();
+    }// end of if
+    return (b - a) / a;
+}
+
+// A change in percent, or blank when it is not known
+static std::string percent_string(double change, std::string blank) {
+    if (std::isnan(change)){
+        return blank;
+    }// end of if
+    char buffer[32];
+    std::snprintf(buffer, sizeof(buffer), "%+.2f%%", change * 100);
+    return buffer;
+}
+
+// A time in seconds, down to the nanosecond, or blank when there is no site
+static std::string seconds_string(const ChronosDiffSite* site, double ChronosDiffSite::* time, std::string blank) {
+    if (site == nullptr){
+        return blank;
+    }// end of if
+    char buffer[32];
+    std::snprintf(buffer, sizeof(buffer), "%.9f", site->*time);
+    return buffer;
+}
+
+// Whether a change is over a limit in percent, which is off when negative
+static bool exceeds(double change, double limit) {
+    return limit >= 0 && !std::isnan(change) && change * 100 > limit;
+}
+
+
+//Ctors and Dtors
+ChronosDiff::ChronosDiff() {
+    // Do Nothing
+}
+
+ChronosDiff::~ChronosDiff() {
+    // Do Nothing
+}
+
+//Basic Functionality
+bool ChronosDiff::load(std::string path, bool baseline) {
+    Profile& profile = baseline ? m_baseline : m_candidate;
+    namespace fs = std::filesystem;
+    if (fs::is_directory(path)){
+        // A profiler which wrote only the binary profile
+        fs::path binary = fs::path(path) / "ChronosProfile.bin";
+        if (!fs::exists(fs::path(path) / "ChronosProfile.csv") && fs::exists(binary)){
+            return load_binary(binary.string(), profile);
+        }// end of if
+        fs::path histograms = fs::path(path) / "ChronosHistograms.csv";
+        if (!load_profile((fs::path(path) / "ChronosProfile.csv").string(), profile)){
+            return false;
+        }// end of if
+        return !fs::exists(histograms) || load_histograms(histograms.string(), profile);
+    }// end of if
+
+    // Tell the histograms from the reports by their header
+    std::ifstream file(path.c_str());
+    std::string header;
+    if (!file.is_open() || !std::getline(file, header)){
+        std::string error_string = "Error reading file: \"" + path + "\"";
+        perror(error_string.c_str());
+        return false;
+    }// end of if
+    file.close();
+    if (header.compare(0, 20, "Total Calls,Buckets,") == 0){
+        // The histograms carry no times of their own, so there must be functions to add them to
+        if (profile.sites.empty()){
+            fprintf(stderr, "Error reading file: \"%s\" holds only histograms, give its ChronosProfile.csv or profiler directory\n", path.c_str());
+            return false;
+        }// end of if
+        return load_histograms(path, profile);
+    }// end of if
+    if (ChronosProfileReader::is_profile(path)){
+        return load_binary(path, profile);
+    }// end of if
+    return load_profile(path, profile);
+}
+
+std::vector<ChronosDiffResult> ChronosDiff::compare(const ChronosDiffOptions& options) {
+    std::vector<ChronosDiffResult> results;
+    results.reserve(m_baseline.sites.size() + m_candidate.sites.size());
+    double nan = std::numeric_limits<double>::quiet_NaN();
+    for (ChronosDiffSite& baseline: m_baseline.sites){
+        auto found = m_candidate.index.find(baseline.name);
+        ChronosDiffResult result = {baseline.name, &baseline, nullptr, nan, nan, nan, nan, nan, -1, "none", "removed"};
+        if (found == m_candidate.index.end()){
+            results.push_back(result);
+            continue;
+        }// end of if
+        const ChronosDiffSite& candidate = m_candidate.sites[found->second];
+        result.candidate = &candidate;
+        result.total_change = relative_change(baseline.total, candidate.total);
+        result.mean_change = relative_change(baseline.mean, candidate.mean);
+        result.p50_change = relative_change(baseline.p50, candidate.p50);
+        result.p90_change = relative_change(baseline.p90, candidate.p90);
+        result.p99_change = relative_change(baseline.p99, candidate.p99);
+        if (baseline.calls < options.min_calls || candidate.calls < options.min_calls
+            || (baseline.total < options.min_time && candidate.total < options.min_time)){
+            result.status = "skipped";
+            results.push_back(result);
+            continue;
+        }// end of if
+        test_significance(result);
+
+        // A change only counts when it is unlikely to be noise, or when there is no telling
+        bool significant = result.p_value < 0 || result.p_value < options.alpha;
+        bool exceeded = exceeds(result.total_change, options.max_total_increase) || exceeds(result.mean_change, options.max_mean_increase)
+                        || exceeds(result.p50_change, options.max_p50_increase) || exceeds(result.p90_change, options.max_p90_increase)
+                        || exceeds(result.p99_change, options.max_p99_increase);
+        if (exceeded && significant){
+            result.status = "regressed";
+        }else if (result.p_value >= 0 && significant && result.mean_change < 0){
+            result.status = "improved";
+        }else{
+            result.status = "unchanged";
+        }// end of if else
+        results.push_back(result);
+    }// end of for
+    for (ChronosDiffSite& candidate: m_candidate.sites){
+        if (m_baseline.index.find(candidate.name) == m_baseline.index.end()){
+            results.push_back({candidate.name, nullptr, &candidate, nan, nan, nan, nan, nan, -1, "none", "added"});
+        }// end of if
+    }// end of for
+
+    // The regressions first, then the sites whose total time grew the most; the keys are worked out once, as the names and
+    // statuses are slow to compare
+    std::vector<std::tuple<bool, double, long>> order(results.size());
+    for (unsigned long i = 0; i < results.size(); i++){
+        ChronosDiffResult& result = results[i];
+        double growth = (result.candidate != nullptr ? result.candidate->total : 0) - (result.baseline != nullptr ? result.baseline->total : 0);
+        order[i] = {result.status == "regressed", growth, static_cast<long>(i)};
+    }// end of for
+    std::sort(order.begin(), order.end(), [](const std::tuple<bool, double, long>& a, const std::tuple<bool, double, long>& b){
+        if (std::get<0>(a) != std::get<0>(b)){
+            return std::get<0>(a);
+        }// end of if
+        return std::get<1>(a) != std::get<1>(b) ? std::get<1>(a) > std::get<1>(b) : std::get<2>(a) < std::get<2>(b);
+    });
+    std::vector<ChronosDiffResult> sorted;
+    sorted.reserve(results.size());
+    for (std::tuple<bool, double, long>& entry: order){
+        sorted.push_back(std::move(results[std::get<2>(entry)]));
+    }// end of for
+    return sorted;
+}
+
+//Getters
+long ChronosDiff::get_site_count(bool baseline) {
+    return static_cast<long>((baseline ? m_baseline : m_candidate).sites.size());
+}
+
+std::string ChronosDiff::get_header_csv() {
+    return "Status,Baseline Calls,Candidate Calls,Baseline Total Time,Candidate Total Time,Total Change,Baseline Mean Time,"
+           "Candidate Mean Time,Mean Change,P50 Change,P90 Change,P99 Change,P Value,Test,Calling Function";
+}
+
+std::string ChronosDiff::to_csv(const ChronosDiffResult& result) {
+    std::string to_return = result.status;
+    for (const ChronosDiffSite* site: {result.baseline, result.candidate}){
+        to_return += ',' + (site != nullptr ? std::to_string(static_cast<long long>(site->calls)) : std::string());
+    }// end of for
+    to_return += ',' + seconds_string(result.baseline, &ChronosDiffSite::total, "");
+    to_return += ',' + seconds_string(result.candidate, &ChronosDiffSite::total, "");
+    to_return += ',' + percent_string(result.total_change, "");
+    to_return += ',' + seconds_string(result.baseline, &ChronosDiffSite::mean, "");
+    to_return += ',' + seconds_string(result.candidate, &ChronosDiffSite::mean, "");
+    to_return += ',' + percent_string(result.mean_change, "") + ',' + percent_string(result.p50_change, "") + ','
+                 + percent_string(result.p90_change, "") + ',' + percent_string(result.p99_change, "");
+    to_return += ',' + (result.p_value >= 0 ? std::to_string(result.p_value) : std::string()) + ',' + result.test;
+    to_return += ',' + std::string(result.name);
+    return to_return;
+}
+
+std::string ChronosDiff::get_header() {
+    return "Status\t\tBaseline Total\t\tCandidate Total\t\tTotal Change\t\tMean Change\t\tP50 Change\t\tP90 Change\t\tP99 Change\t\tP Value\t\tTest\t\t\tCalling Function";
+}
+
+std::string ChronosDiff::to_string(const ChronosDiffResult& result) {
+    std::string to_return = result.status;
+    to_return += "\t\t" + seconds_string(result.baseline, &ChronosDiffSite::total, "-");
+    to_return += "\t\t" + seconds_string(result.candidate, &ChronosDiffSite::total, "-");
+    to_return += "\t\t" + percent_string(result.total_change, "-") + "\t\t" + percent_string(result.mean_change, "-");
+    to_return += "\t\t" + percent_string(result.p50_change, "-") + "\t\t" + percent_string(result.p90_change, "-");
+    to_return += "\t\t" + percent_string(result.p99_change, "-");
+    to_return += "\t\t" + (result.p_value >= 0 ? std::to_string(result.p_value) : std::string("-")) + "\t\t" + result.test;
+    to_return += "\t\t" + std::string(result.name);
+    return to_return;
+}
+
+//Private Functions
+bool ChronosDiff::load_profile(const std::string& path, Profile& profile) {
+    std::ifstream file(path.c_str());
+    std::string line;
+    if (!file.is_open() || !std::getline(file, line)){
+        std::string error_string = "Error reading file: \"" + path + "\"";
+        perror(error_string.c_str());
+        return false;
+    }// end of if
+
+    // Find the columns by their names, as every version of the reports has a few more
+    if (!line.empty() && line.back() == '\r'){
+        line.pop_back();
+    }// end of if
+    std::vector<std::string> columns;
+    std::string::size_type begin = 0;
+    while (begin <= line.size()){
+        std::string::size_type end = line.find(',', begin);
+        end = end == std::string::npos ? line.size() : end;
+        columns.push_back(line.substr(begin, end - begin));
+        begin = end + 1;
+    }// end of while
+    auto column = [&columns](const char* name){
+        auto found = std::find(columns.begin(), columns.end(), name);
+        return found == columns.end() ? -1l : static_cast<long>(found - columns.begin());
+    };
+    long calls_column = column("Total Calls");
+    long total_column = column("Total Time");
+    long mean_column = column("Mean Time");
+    long timed_column = column("Timed Calls");
+    long p50_column = column("P50 Time");
+    long p90_column = column("P90 Time");
+    long p99_column = column("P99 Time");
+    long std_dev_column = column("Std Dev");
+    long min_column = column("Min Time");
+    long max_column = column("Max Time");
+    long thread_column = column("Thread");
+    long pid_column = column("PID");
+    long field_count = static_cast<long>(columns.size());
+    if (calls_column < 0 || total_column < 0 || columns.back() != "Calling Function"){
+        fprintf(stderr, "Error reading file: \"%s\" is not a Chronos profile\n", path.c_str());
+        return false;
+    }// end of if
+
+    std::vector<const char*> fields(field_count);
+    while (std::getline(file, line)){
+        if (!line.empty() && line.back() == '\r'){
+            line.pop_back();
+        }// end of if
+        // Every field but the last is split at the commas; the function name is the rest of the line, commas and all
+        const char* position = line.c_str();
+        long field = 0;
+        for (; field < field_count - 1; field++){
+            fields[field] = position;
+            const char* comma = std::strchr(position, ',');
+            if (comma == nullptr){
+                break;
+            }// end of if
+            position = comma + 1;
+        }// end of for
+        if (field < field_count - 1){
+            continue;
+        }// end of if
+        fields[field_count - 1] = position;
+        // Only the rows merged over the threads and processes, and the benchmarks
+        if (thread_column >= 0 && std::strncmp(fields[thread_column], "All,", 4) != 0 && std::strncmp(fields[thread_column], "Benchmark,", 10) != 0){
+            continue;
+        }// end of if
+        if (pid_column >= 0 && std::strncmp(fields[pid_column], "All,", 4) != 0){
+            continue;
+        }// end of if
+
+        auto number = [&fields](long index, double fallback){
+            if (index < 0 || *fields[index] == ',' || *fields[index] == '\0'){
+                return fallback;
+            }// end of if
+#if defined(__cpp_lib_to_chars)
+            // Much quicker than strtod, which consults the locale for every number
+            double value = fallback;
+            std::from_chars(fields[index], fields[index] + std::strcspn(fields[index], ","), value);
+            return value;
+#else
+            return std::strtod(fields[index], nullptr);
+#endif
+        };
+        ChronosDiffSite site;
+        site.calls = number(calls_column, 0);
+        site.total = number(total_column, 0);
+        site.timed = number(timed_column, site.calls);
+        // The total keeps more digits than the mean of a short function, but a sampled one leaves out the calls nested in
+        // a timed call of the same function, so only the mean column gives the mean of those
+        site.mean = site.calls > 0 && site.timed >= site.calls ? site.total / site.calls : number(mean_column, 0);
+        site.p50 = number(p50_column, -1);
+        site.p90 = number(p90_column, -1);
+        site.p99 = number(p99_column, -1);
+        site.std_dev = number(std_dev_column, -1);
+        site.min = number(min_column, -1);
+        site.max = number(max_column, -1);
+        site.buckets_start = 0;
+        site.buckets_count = 0;
+        add_site(profile, site, std::string_view(fields[field_count - 1]));
+    }// end of while
+    return true;
+}
+
+bool ChronosDiff::load_binary(const std::string& path, Profile& profile) {
+    ChronosProfileReader reader;
+    if (!reader.open(path)){
+        fprintf(stderr, "Error reading file: \"%s\" is not a Chronos profile\n", path.c_str());
+        return false;
+    }// end of if
+    for (long i = 0; i < reader.get_record_count(); i++){
+        const ChronosProfileRecord& record = reader.get_record(i);
+        // Only the records merged over the threads, and the benchmarks
+        if (record.thread_id != -1 && record.thread_id != ChronosProcess::k_benchmark_thread){
+            continue;
+        }// end of if
+        ChronosDiffSite site;
+        site.calls = static_cast<double>(record.total_calls);
+        site.total = record.total_time;
+        site.mean = record.mean_time;
+        site.timed = static_cast<double>(record.timed_calls);
+        site.p50 = -1;
+        site.p90 = -1;
+        site.p99 = -1;
+        double variance = site.calls > 0 ? record.sum_squares / site.calls - record.mean_time * record.mean_time : 0;
+        site.std_dev = variance > 0 ? std::sqrt(variance) : 0;
+        site.min = record.min_time;
+        site.max = record.max_time;
+        site.buckets_start = 0;
+        site.buckets_count = 0;
+        ChronosDiffSite& added = add_site(profile, site, reader.get_name(i));
+        if (added.buckets_count > 0 || record.bucket_count == 0){
+            continue;
+        }// end of if
+        // The histogram is stored with the record, so there is no separate file to read
+        added.buckets_start = static_cast<long>(profile.buckets.size());
+        for (long bucket = 0; bucket < ChronosHistogram::k_bucket_count; bucket++){
+            unsigned long long count = reader.get_bucket(i, bucket);
+            if (count != 0){
+                profile.buckets.push_back({bucket, count});
+            }// end of if
+        }// end of for
+        added.buckets_count = static_cast<long>(profile.buckets.size()) - added.buckets_start;
+        find_percentiles(profile, added);
+    }// end of for
+    return true;
+}
+
+ChronosDiffSite& ChronosDiff::add_site(Profile& profile, const ChronosDiffSite& site, std::string_view name) {
+    auto found = profile.index.find(name);
+    if (found == profile.index.end()){
+        profile.sites.push_back(site);
+        profile.sites.back().name = profile.names.store(name);
+        profile.index.emplace(profile.sites.back().name, static_cast<long>(profile.sites.size()) - 1);
+        return profile.sites.back();
+    }// end of if
+    // A name seen twice, such as in the windows of a monitor, adds up
+    ChronosDiffSite& existing = profile.sites[found->second];
+    // The means are weighed by their calls, as ChronosProcess::merge does
+    existing.mean = existing.calls + site.calls > 0
+                    ? (existing.mean * existing.calls + site.mean * site.calls) / (existing.calls + site.calls) : 0;
+    existing.calls += site.calls;
+    existing.timed += site.timed;
+    existing.total += site.total;
+    existing.min = existing.min >= 0 && site.min >= 0 ? std::min(existing.min, site.min) : -1;
+    existing.max = existing.max >= 0 && site.max >= 0 ? std::max(existing.max, site.max) : -1;
+    return existing;
+}
+
+bool ChronosDiff::load_histograms(const std::string& path, Profile& profile) {
+    std::ifstream file(path.c_str());
+    std::string line;
+    if (!file.is_open() || !std::getline(file, line)){
+        std::string error_string = "Error reading file: \"" + path + "\"";
+        perror(error_string.c_str());
+        return false;
+    }// end of if
+    while (std::getline(file, line)){
+        if (!line.empty() && line.back() == '\r'){
+            line.pop_back();
+        }// end of if
+        // Total Calls,Buckets,Calling Function
+        std::string::size_type first = line.find(',');
+        std::string::size_type second = first == std::string::npos ? first : line.find(',', first + 1);
+        if (second == std::string::npos){
+            continue;
+        }// end of if
+        auto found = profile.index.find(std::string_view(line).substr(second + 1));
+        if (found == profile.index.end()){
+            continue;
+        }// end of if
+        ChronosDiffSite& site = profile.sites[found->second];
+        site.buckets_start = static_cast<long>(profile.buckets.size());
+        const char* position = line.c_str() + first + 1;
+        const char* end = line.c_str() + second;
+        while (position < end){
+            char* next = nullptr;
+            long index = std::strtol(position, &next, 10);
+            if (next == position || *next != ':'){
+                break;
+            }// end of if
+            unsigned long long count = std::strtoull(next + 1, &next, 10);
+            profile.buckets.push_back({index, count});
+            position = *next == ';' ? next + 1 : next;
+            if (*next != ';'){
+                break;
+            }// end of if
+        }// end of while
+        site.buckets_count = static_cast<long>(profile.buckets.size()) - site.buckets_start;
+        find_percentiles(profile, site);
+    }// end of while
+    return true;
+}
+
+void ChronosDiff::find_percentiles(Profile& profile, ChronosDiffSite& site) {
+    // The buckets are in nanoseconds, so their percentiles are finer than the microseconds of the report
+    unsigned long long count = 0;
+    for (long i = 0; i < site.buckets_count; i++){
+        count += profile.buckets[site.buckets_start + i].second;
+    }// end of for
+    double* percentiles[3] = {&site.p50, &site.p90, &site.p99};
+    double shares[3] = {0.5, 0.9, 0.99};
+    for (int p = 0; p < 3 && count > 0; p++){
+        // The rank of the value, counted from 1, as in ChronosHistogram::get_percentile
+        unsigned long long rank = static_cast<unsigned long long>(shares[p] * count + 0.5);
+        rank = rank < 1 ? 1 : (rank > count ? count : rank);
+        unsigned long long seen = 0;
+        for (long i = 0; i < site.buckets_count; i++){
+            seen += profile.buckets[site.buckets_start + i].second;
+            if (seen >= rank){
+                *percentiles[p] = ChronosHistogram::bucket_value(profile.buckets[site.buckets_start + i].first) * 1e-9;
+                if (site.min >= 0 && site.max >= site.min){
+                    // The middle of a bucket may lie outside of the exact extremes, as ChronosProcess::get_percentile keeps it
+                    *percentiles[p] = std::min(std::max(*percentiles[p], site.min), site.max);
+                }// end of if
+                break;
+            }// end of if
+        }// end of for
+    }// end of for
+}
+
+void ChronosDiff::test_significance(ChronosDiffResult& result) {
+    const ChronosDiffSite& baseline = *result.baseline;
+    const ChronosDiffSite& candidate = *result.candidate;
+    if (baseline.buckets_count > 0 && candidate.buckets_count > 0){
+        // Mann-Whitney U over the buckets: every candidate call is ranked against the baseline calls below it, and against half
+        // of those in its own bucket, with the variance corrected for the ties within the buckets
+        const std::pair<long, unsigned long long>* a = &m_baseline.buckets[baseline.buckets_start];
+        const std::pair<long, unsigned long long>* a_end = a + baseline.buckets_count;
+        const std::pair<long, unsigned long long>* b = &m_candidate.buckets[candidate.buckets_start];
+        const std::pair<long, unsigned long long>* b_end = b + candidate.buckets_count;
+        double below = 0;
+        double u = 0;
+        double ties = 0;
+        double n1 = 0;
+        double n2 = 0;
+        while (a != a_end || b != b_end){
+            long index = a == a_end ? b->first : (b == b_end ? a->first : std::min(a->first, b->first));
+            double a_count = (a != a_end && a->first == index) ? static_cast<double>((a++)->second) : 0;
+            double b_count = (b != b_end && b->first == index) ? static_cast<double>((b++)->second) : 0;
+            u += b_count * (below + a_count / 2);
+            below += a_count;
+            n1 += a_count;
+            n2 += b_count;
+            double tied = a_count + b_count;
+            ties += tied * tied * tied - tied;
+        }// end of while
+        double total = n1 + n2;
+        double mean = n1 * n2 / 2;
+        double variance = total > 1 ? n1 * n2 / 12 * ((total + 1) - ties / (total * (total - 1))) : 0;
+        result.test = "mann-whitney";
+        if (variance <= 0){
+            result.p_value = u == mean ? 1 : 0;
+        }else{
+            result.p_value = std::erfc(std::fabs(u - mean) / std::sqrt(variance) / std::sqrt(2.0));
+        }// end of if else
+        return;
+    }// end of if
+    if (baseline.std_dev >= 0 && candidate.std_dev >= 0 && baseline.timed > 1 && candidate.timed > 1){
+        // Welch's t-test on the means, which the number of calls makes as good as a z-test
+        double error = std::sqrt(baseline.std_dev * baseline.std_dev / baseline.timed + candidate.std_dev * candidate.std_dev / candidate.timed);
+        if (error > 0){
+            // A deviation of 0 is more likely a short function rounded to the microseconds of the report, so it tells nothing
+            result.test = "welch";
+            result.p_value = std::erfc(std::fabs(candidate.mean - baseline.mean) / error / std::sqrt(2.0));
+        }// end of if
+    }// end of if
+}
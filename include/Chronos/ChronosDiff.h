@@ -0,0 +1,232 @@
+/**   Copyright 2020 Benrick Smit
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ * 
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+*/
+
+/**
+ * @author: Benrick Smit
+ * @email: metatronicprogramming@hotmail.com
+ * @date: 13 June 2020
+ * @modified: 13 June 2020
+ * 
+ * @brief: This class compares two profiles written by Chronos, such as those of a build before and after a change. The sites
+ *          are matched by function name, and every match gets the change in its total, mean and percentile times, with the
+ *          chance that the change in the mean is only noise: from Welch's t-test on the mean and standard deviation, or from
+ *          the Mann-Whitney U test on the whole latency histograms when both profiles come with them. A site regresses when
+ *          one of its changes is over the set limits and the change is significant. The files are read line by line, the
+ *          names kept in an arena and matched through a hash map, so two profiles of 300k sites are compared in about a second.
+ * 
+ */ 
+
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "ChronosArena.h"
+
+/**
+ * @brief One function of a profile, with its times in seconds
+ * 
+ */
+struct ChronosDiffSite {
+    std::string_view name;
+    double calls;
+    double timed;                                                           // Calls that were timed, the calls if not known
+    double total;
+    double mean;
+    double p50;
+    double p90;
+    double p99;
+    double std_dev;                                                         // Negative if the profile does not give it
+    double min;                                                             // Shortest call, negative if not given
+    double max;                                                             // Longest call, negative if not given
+    long buckets_start;                                                     // First histogram bucket in the profile's list
+    long buckets_count;                                                     // Number of buckets, 0 without a histogram
+};
+
+/**
+ * @brief The limits a candidate profile is held to. The increases are in percent, negative when not checked.
+ * 
+ */
+struct ChronosDiffOptions {
+    double max_total_increase = -1;
+    double max_mean_increase = -1;
+    double max_p50_increase = -1;
+    double max_p90_increase = -1;
+    double max_p99_increase = -1;
+    double alpha = 0.05;                                                    // Largest p value of a change that counts
+    double min_calls = 1;                                                   // Sites called less often in either profile are not checked
+    double min_time = 0;                                                    // Sites with less total time in both profiles are not checked
+};
+
+/**
+ * @brief The comparison of one function name
+ * 
+ */
+struct ChronosDiffResult {
+    std::string_view name;
+    const ChronosDiffSite* baseline;                                        // nullptr if the function was added
+    const ChronosDiffSite* candidate;                                       // nullptr if the function was removed
+    double total_change;                                                    // Relative changes, 0.1 for 10% slower
+    double mean_change;
+    double p50_change;
+    double p90_change;
+    double p99_change;
+    double p_value;                                                         // Two-sided, negative if it could not be estimated
+    std::string test;                                                       // "mann-whitney", "welch" or "none"
+    std::string status;                                                     // "regressed", "improved", "unchanged", "added", "removed" or "skipped"
+};
+
+class ChronosDiff {
+	public:
+		//ctors and dtors
+		/**
+		 * @brief Construct a new Chronos Diff object, with two empty profiles
+		 * 
+		 */
+		ChronosDiff();
+		/**
+		 * @brief Destroy the Chronos Diff object
+		 * 
+		 */
+		~ChronosDiff();
+
+		ChronosDiff(const ChronosDiff&) = delete;
+		ChronosDiff& operator=(const ChronosDiff&) = delete;
+
+		//Basic Operation
+		/**
+		 * @brief Loads a profile into the baseline or the candidate. The path may be a .csv report, such as ChronosProfile.csv
+		 *          or ChronosShared.csv of any version, of which the merged rows are read; a ChronosHistograms.csv, which adds the
+		 *          histograms to the functions already loaded and is refused when there are none; a binary ChronosProfile.bin, which holds both; or a profiler
+		 *          directory, from which the .csv reports are read, or the binary profile when there are none.
+		 * 
+		 * @param path 
+		 * @param baseline true for the baseline, false for the candidate
+		 * @return true if the file could be read
+		 */
+		bool load(std::string path, bool baseline);
+		/**
+		 * @brief Compares the candidate with the baseline
+		 * 
+		 * @param options the limits
+		 * @return std::vector<ChronosDiffResult> regressions first, then ordered by the growth of the total time
+		 */
+		std::vector<ChronosDiffResult> compare(const ChronosDiffOptions& options);
+
+		//Getters
+		/**
+		 * @brief Get the site count object
+		 * 
+		 * @param baseline 
+		 * @return long the functions loaded into the profile
+		 */
+		long get_site_count(bool baseline);
+
+		/**
+		 * @brief Get the header csv object
+		 * 
+		 * @return std::string 
+		 */
+		static std::string get_header_csv();
+		/**
+		 * @brief Writes a result as a line of .csv, the changes in percent
+		 * 
+		 * @param result 
+		 * @return std::string 
+		 */
+		static std::string to_csv(const ChronosDiffResult& result);
+		/**
+		 * @brief Get the header object
+		 * 
+		 * @return std::string 
+		 */
+		static std::string get_header();
+		/**
+		 * @brief Writes a result as a tab separated line for the terminal
+		 * 
+		 * @param result 
+		 * @return std::string 
+		 */
+		static std::string to_string(const ChronosDiffResult& result);
+
+	private:
+		/**
+		 * @brief The functions of one profile
+		 * 
+		 */
+		struct Profile {
+			ChronosArena names;
+			std::vector<ChronosDiffSite> sites;
+			std::unordered_map<std::string_view, long> index;
+			std::vector<std::pair<long, unsigned long long>> buckets;			// Histogram buckets of all the sites, in nanoseconds
+		};
+
+		/**
+		 * @brief Reads a .csv report, whichever columns it has
+		 * 
+		 * @param path 
+		 * @param profile 
+		 * @return true 
+		 * @return false 
+		 */
+		bool load_profile(const std::string& path, Profile& profile);
+		/**
+		 * @brief Reads a ChronosHistograms.csv into the functions of the profile
+		 * 
+		 * @param path 
+		 * @param profile 
+		 * @return true 
+		 * @return false 
+		 */
+		bool load_histograms(const std::string& path, Profile& profile);
+		/**
+		 * @brief Reads a binary profile, written by ChronosProfileWriter, histograms and all
+		 * 
+		 * @param path 
+		 * @param profile 
+		 * @return true 
+		 * @return false 
+		 */
+		bool load_binary(const std::string& path, Profile& profile);
+		/**
+		 * @brief Adds a function to a profile, or adds it up with the function of the same name
+		 * 
+		 * @param profile 
+		 * @param site 
+		 * @param name copied into the profile's names
+		 * @return ChronosDiffSite& the function in the profile
+		 */
+		ChronosDiffSite& add_site(Profile& profile, const ChronosDiffSite& site, std::string_view name);
+		/**
+		 * @brief Works out the p50, p90 and p99 of a function from its histogram buckets
+		 * 
+		 * @param profile 
+		 * @param site 
+		 */
+		void find_percentiles(Profile& profile, ChronosDiffSite& site);
+		/**
+		 * @brief Works out the p value of the change in a site's latency
+		 * 
+		 * @param result filled in with the p value and the test used
+		 */
+		void test_significance(ChronosDiffResult& result);
+
+		//Member variables
+		Profile m_baseline;
+		Profile m_candidate;
+};
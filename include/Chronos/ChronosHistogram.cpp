@@ -0,0 +1,152 @@
+/**   Copyright 2020 Benrick Smit
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ * 
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+*/
+
+/**
+ * @author: Benrick Smit
+ * @email: metatronicprogramming@hotmail.com
+ * @date: 13 June 2020
+ * @modified: 13 June 2020
+ * 
+ * @brief: This class is a log-bucketed latency histogram, in the manner of HdrHistogram.
+ * 
+ */ 
+
+
+#include "ChronosHistogram.h"
+
+#include <cstdlib>
+
+
+//Ctors and Dtors
+ChronosHistogram::ChronosHistogram() {
+    m_count = 0;
+}
+
+ChronosHistogram::~ChronosHistogram() {
+    // Do Nothing
+}
+
+//Basic Functionality
+unsigned long long ChronosHistogram::bucket_value(long index) {
+    if (index < 2 * k_sub_buckets){
+        return static_cast<unsigned long long>(index);
+    }// end of if
+    long shift = index / k_sub_buckets - 1;
+    unsigned long long lowest = static_cast<unsigned long long>(k_sub_buckets + index % k_sub_buckets) << shift;
+    return lowest + ((1ull << shift) >> 1);
+}
+
+void ChronosHistogram::add(long index, unsigned long long count) {
+    if (index < 0 || index >= k_bucket_count || count == 0){
+        return;
+    }// end of if
+    if (m_counts.empty()){
+        m_counts.resize(k_bucket_count, 0);
+    }// end of if
+    m_counts[index] += count;
+    m_count += count;
+}
+
+void ChronosHistogram::add_value(unsigned long long value) {
+    add(bucket_index(value));
+}
+
+void ChronosHistogram::merge(const ChronosHistogram& other) {
+    for (long i = 0; i < static_cast<long>(other.m_counts.size()); i++){
+        add(i, other.m_counts[i]);
+    }// end of for
+}
+
+void ChronosHistogram::subtract(const ChronosHistogram& earlier) {
+    for (long i = 0; i < static_cast<long>(earlier.m_counts.size()) && i < static_cast<long>(m_counts.size()); i++){
+        // A count can not drop below zero, whatever the earlier copy held
+        unsigned long long removed = earlier.m_counts[i] < m_counts[i] ? earlier.m_counts[i] : m_counts[i];
+        m_counts[i] -= removed;
+        m_count -= removed;
+    }// end of for
+}
+
+unsigned long long ChronosHistogram::get_percentile(double percentile) const {
+    if (m_count == 0){
+        return 0;
+    }// end of if
+    // The rank of the value, counted from 1
+    unsigned long long rank = static_cast<unsigned long long>(percentile / 100.0 * m_count + 0.5);
+    rank = rank < 1 ? 1 : (rank > m_count ? m_count : rank);
+    unsigned long long seen = 0;
+    for (long i = 0; i < k_bucket_count; i++){
+        seen += m_counts[i];
+        if (seen >= rank){
+            return bucket_value(i);
+        }// end of if
+    }// end of for
+    return bucket_value(k_bucket_count - 1);
+}
+
+unsigned long long ChronosHistogram::get_percentile(double percentile, unsigned long long min, unsigned long long max) const {
+    if (m_count == 0){
+        return 0;
+    }// end of if
+    unsigned long long value = get_percentile(percentile);
+    return value < min ? min : (value > max ? max : value);
+}
+
+unsigned long long ChronosHistogram::get_count() const {
+    return m_count;
+}
+
+unsigned long long ChronosHistogram::get_bucket(long index) const {
+    if (index < 0 || index >= static_cast<long>(m_counts.size())){
+        return 0;
+    }// end of if
+    return m_counts[index];
+}
+
+std::string ChronosHistogram::serialize() const {
+    std::string to_return;
+    for (long i = 0; i < static_cast<long>(m_counts.size()); i++){
+        if (m_counts[i] != 0){
+            if (!to_return.empty()){
+                to_return += ';';
+            }// end of if
+            to_return += std::to_string(i) + ':' + std::to_string(m_counts[i]);
+        }// end of if
+    }// end of for
+    return to_return;
+}
+
+bool ChronosHistogram::deserialize(const std::string& value) {
+    const char* position = value.c_str();
+    while (*position != '\0'){
+        char* end = nullptr;
+        long index = std::strtol(position, &end, 10);
+        if (end == position || *end != ':'){
+            return false;
+        }// end of if
+        position = end + 1;
+        unsigned long long count = std::strtoull(position, &end, 10);
+        if (end == position){
+            return false;
+        }// end of if
+        add(index, count);
+        position = end;
+        if (*position == ';'){
+            position++;
+        }else if (*position != '\0'){
+            return false;
+        }// end of if else
+    }// end of while
+    return true;
+}
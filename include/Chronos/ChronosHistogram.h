@@ -0,0 +1,158 @@
+/**   Copyright 2020 Benrick Smit
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ * 
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+*/
+
+/**
+ * @author: Benrick Smit
+ * @email: metatronicprogramming@hotmail.com
+ * @date: 13 June 2020
+ * @modified: 13 June 2020
+ * 
+ * @brief: This class is a log-bucketed latency histogram, in the manner of HdrHistogram. Values below 32 get a bucket each;
+ *          above that, every power of two is split into 16 buckets, so a value is known to within 1/16th, and the middle of
+ *          its bucket is within about 3% of it. The buckets cover the full range of 64-bit values, so the memory is fixed
+ *          at k_bucket_count (976) counters of 8 bytes: 7.6 KiB. Recording is a bit scan and an increment.
+ * 
+ *          The recording threads count clock ticks, in the same layout, in a block of k_bucket_count atomics allocated the
+ *          first time a thread records a site; that is the 7.6 KiB per site per thread. The histograms of the reports are
+ *          kept in nanoseconds, so that those of different runs, and of machines with different clocks, can be merged.
+ * 
+ */ 
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+class ChronosHistogram {
+	public:
+		//ctors and dtors
+		/**
+		 * @brief Construct a new Chronos Histogram object, which holds no memory until the first value is added
+		 * 
+		 */
+		ChronosHistogram();
+		/**
+		 * @brief Destroy the Chronos Histogram object
+		 * 
+		 */
+		~ChronosHistogram();
+
+		//Basic Operation
+		/**
+		 * @brief Get the bucket a value is counted in
+		 * 
+		 * @param value 
+		 * @return long below k_bucket_count
+		 */
+		static inline long bucket_index(unsigned long long value) {
+			if (value < 2 * k_sub_buckets){
+				return static_cast<long>(value);
+			}// end of if
+			long msb = 63 - __builtin_clzll(value);
+			return k_sub_buckets * (msb - k_sub_bits + 1) + static_cast<long>((value >> (msb - k_sub_bits)) & (k_sub_buckets - 1));
+		}
+		/**
+		 * @brief Get the value in the middle of a bucket, which stands in for all the values counted in it
+		 * 
+		 * @param index 
+		 * @return unsigned long long 
+		 */
+		static unsigned long long bucket_value(long index);
+		/**
+		 * @brief Adds values to a bucket
+		 * 
+		 * @param index 
+		 * @param count 
+		 */
+		void add(long index, unsigned long long count = 1);
+		/**
+		 * @brief Adds a value to its bucket
+		 * 
+		 * @param value 
+		 */
+		void add_value(unsigned long long value);
+		/**
+		 * @brief Adds the counts of another histogram, from another thread or another run
+		 * 
+		 * @param other 
+		 */
+		void merge(const ChronosHistogram& other);
+		/**
+		 * @brief Removes the counts of an earlier copy of this histogram, leaving the values added since
+		 * 
+		 * @param earlier 
+		 */
+		void subtract(const ChronosHistogram& earlier);
+		/**
+		 * @brief Get the value below which the given share of the values lie, as the middle of its bucket
+		 * 
+		 * @param percentile between 0 and 100
+		 * @return unsigned long long 0 when the histogram is empty
+		 */
+		unsigned long long get_percentile(double percentile) const;
+		/**
+		 * @brief Get the value below which the given share of the values lie, kept within the smallest and largest value added,
+		 *          as the middle of a bucket may lie outside of them
+		 * 
+		 * @param percentile between 0 and 100
+		 * @param min the smallest value added
+		 * @param max the largest value added
+		 * @return unsigned long long 0 when the histogram is empty
+		 */
+		unsigned long long get_percentile(double percentile, unsigned long long min, unsigned long long max) const;
+		/**
+		 * @brief Get the count object
+		 * 
+		 * @return unsigned long long the number of values added
+		 */
+		unsigned long long get_count() const;
+		/**
+		 * @brief Get the count of one bucket
+		 * 
+		 * @param index 
+		 * @return unsigned long long 
+		 */
+		unsigned long long get_bucket(long index) const;
+		/**
+		 * @brief Get the counters of all the buckets, for walking them without a call per bucket
+		 * 
+		 * @return const unsigned long long* k_bucket_count counters, or nullptr when nothing was added
+		 */
+		inline const unsigned long long* get_buckets() const {
+			return m_counts.empty() ? nullptr : m_counts.data();
+		}
+		/**
+		 * @brief Writes the non-empty buckets as "index:count" pairs separated by ';'
+		 * 
+		 * @return std::string 
+		 */
+		std::string serialize() const;
+		/**
+		 * @brief Adds the buckets written by serialize to this histogram
+		 * 
+		 * @param value 
+		 * @return true if the whole value could be read
+		 */
+		bool deserialize(const std::string& value);
+
+		static const long k_sub_bits = 4;										// Every power of two is split into 2^k_sub_bits buckets
+		static const long k_sub_buckets = 1 << k_sub_bits;
+		static const long k_bucket_count = k_sub_buckets * (64 - k_sub_bits + 1);
+
+	private:
+		//Member variables
+		std::vector<unsigned long long> m_counts;								// Empty, or k_bucket_count counters
+		unsigned long long m_count;												// Sum of the counters
+};
@@ -0,0 +1,225 @@
+/**   Copyright 2020 Benrick Smit
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ * 
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+*/
+
+/**
+ * @author: Benrick Smit
+ * @email: metatronicprogramming@hotmail.com
+ * @date: 13 June 2020
+ * @modified: 13 June 2020
+ * 
+ * @brief: This class switches the function instrumentation of the profiler on and off, finds the site of every instrumented
+ *          function, and holds the __cyg_profile_func hooks when they are compiled in.
+ * 
+ */ 
+
+
+#include "ChronosInstrument.h"
+
+#include "Chronos.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cxxabi.h>
+#include <initializer_list>
+#include <dlfcn.h>
+
+
+std::atomic<bool> ChronosInstrument::s_enabled(false);
+std::atomic<bool> ChronosInstrument::s_full(false);
+std::atomic<ChronosInstrument::Entry*> ChronosInstrument::s_table(nullptr);
+long ChronosInstrument::s_count = 0;
+std::mutex ChronosInstrument::s_mutex;
+std::vector<std::string> ChronosInstrument::s_includes;
+std::vector<std::string> ChronosInstrument::s_excludes;
+std::vector<std::string> ChronosInstrument::s_env_includes;
+std::vector<std::string> ChronosInstrument::s_env_excludes;
+
+//Basic Functionality
+bool ChronosInstrument::set_enabled(bool enabled) {
+    if (enabled && !is_compiled()){
+        return false;
+    }// end of if
+    if (enabled){
+        std::lock_guard<std::mutex> lock(s_mutex);
+        Entry* table = s_table.load(std::memory_order_relaxed);
+        if (table == nullptr){
+            table = new Entry[k_table_size];
+        }// end of if
+        // The sites belong to the instance which switches the hooks on, so the functions seen before are forgotten
+        for (long slot = 0; slot < k_table_size; slot++){
+            table[slot].function.store(nullptr, std::memory_order_relaxed);
+            table[slot].site.store(-1, std::memory_order_relaxed);
+        }// end of for
+        s_table.store(table, std::memory_order_release);
+        s_count = 0;
+        s_full.store(false);
+        s_env_includes.clear();
+        s_env_excludes.clear();
+        add_patterns(std::getenv("CHRONOS_INCLUDE"), s_env_includes);
+        add_patterns(std::getenv("CHRONOS_EXCLUDE"), s_env_excludes);
+    }// end of if
+    s_enabled.store(enabled);
+    return true;
+}
+
+bool ChronosInstrument::is_compiled() {
+    return CHRONOS_INSTRUMENT != 0;
+}
+
+void ChronosInstrument::include(std::string pattern) {
+    std::lock_guard<std::mutex> lock(s_mutex);
+    s_includes.push_back(pattern);
+}
+
+void ChronosInstrument::exclude(std::string pattern) {
+    std::lock_guard<std::mutex> lock(s_mutex);
+    s_excludes.push_back(pattern);
+}
+
+std::string ChronosInstrument::get_name(const void* function) {
+    Dl_info info;
+    if (dladdr(function, &info) == 0){
+        char address[32];
+        std::snprintf(address, sizeof(address), "%p", function);
+        return address;
+    }// end of if
+    if (info.dli_sname != nullptr){
+        int status = 0;
+        char* demangled = abi::__cxa_demangle(info.dli_sname, nullptr, nullptr, &status);
+        std::string name = (status == 0 && demangled != nullptr) ? demangled : info.dli_sname;
+        std::free(demangled);
+        return name;
+    }// end of if
+    // The symbol is not exported, so the module and the offset into it are the best there is
+    std::string module = info.dli_fname != nullptr ? info.dli_fname : "";
+    module = module.substr(module.find_last_of('/') + 1);
+    char offset[32];
+    std::snprintf(offset, sizeof(offset), "+0x%lx", static_cast<unsigned long>(
+        reinterpret_cast<std::uintptr_t>(function) - reinterpret_cast<std::uintptr_t>(info.dli_fbase)));
+    return module + offset;
+}
+
+
+//Private Functionality
+long ChronosInstrument::add_function(Chronos* profiler, const void* function) {
+    std::lock_guard<std::mutex> lock(s_mutex);
+    Entry* table = s_table.load(std::memory_order_relaxed);
+    unsigned long slot = hash(function);
+    while (true){
+        const void* key = table[slot].function.load(std::memory_order_relaxed);
+        if (key == function){
+            return table[slot].site.load(std::memory_order_relaxed);
+        }// end of if
+        if (key == nullptr){
+            break;
+        }// end of if
+        slot = (slot + 1) & (k_table_size - 1);
+    }// end of while
+    // Half full keeps the probes short; the functions seen after that are not profiled
+    if (s_count >= k_table_size / 2){
+        s_full.store(true);
+        return -1;
+    }// end of if
+    long site = is_profiled(function) ? profiler->register_function(function) : -1;
+    table[slot].site.store(site, std::memory_order_relaxed);
+    table[slot].function.store(function, std::memory_order_release);
+    s_count++;
+    return site;
+}
+
+bool ChronosInstrument::is_profiled(const void* function) {
+    if (s_includes.empty() && s_excludes.empty() && s_env_includes.empty() && s_env_excludes.empty()){
+        return true;
+    }// end of if
+    // The name is only looked up when there are filters, otherwise it waits for the reports
+    std::string name = get_name(function);
+    Dl_info info;
+    std::string module = (dladdr(function, &info) != 0 && info.dli_fname != nullptr) ? info.dli_fname : "";
+    auto matches = [&name, &module](const std::string& pattern){
+        return name.find(pattern) != std::string::npos || module.find(pattern) != std::string::npos;
+    };
+    bool included = s_includes.empty() && s_env_includes.empty();
+    for (const std::vector<std::string>* includes: {&s_includes, &s_env_includes}){
+        included = included || std::any_of(includes->begin(), includes->end(), matches);
+    }// end of for
+    if (!included){
+        return false;
+    }// end of if
+    for (const std::vector<std::string>* excludes: {&s_excludes, &s_env_excludes}){
+        if (std::any_of(excludes->begin(), excludes->end(), matches)){
+            return false;
+        }// end of if
+    }// end of for
+    return true;
+}
+
+void ChronosInstrument::add_patterns(const char* patterns, std::vector<std::string>& filters) {
+    if (patterns == nullptr){
+        return;
+    }// end of if
+    std::string list = patterns;
+    unsigned long begin = 0;
+    while (begin <= list.size()){
+        unsigned long end = list.find(',', begin);
+        if (end == std::string::npos){
+            end = list.size();
+        }// end of if
+        if (end > begin){
+            filters.push_back(list.substr(begin, end - begin));
+        }// end of if
+        begin = end + 1;
+    }// end of while
+}
+
+
+#if CHRONOS_INSTRUMENT
+namespace {
+    // Set while a hook runs, so the instrumented copies of the profiler's own inline functions do not call back into it
+    thread_local bool t_in_hook = false;
+}
+
+// The hooks which -finstrument-functions calls on entry to and exit from every function, never instrumented themselves
+extern "C" {
+    void __cyg_profile_func_enter(void* function, void* caller) __attribute__((no_instrument_function));
+    void __cyg_profile_func_exit(void* function, void* caller) __attribute__((no_instrument_function));
+
+    void __cyg_profile_func_enter(void* function, void*) {
+        if (!ChronosInstrument::is_enabled() || t_in_hook){
+            return;
+        }// end of if
+        t_in_hook = true;
+        Chronos* profiler = Chronos::get_instance();
+        long site = ChronosInstrument::find_site(profiler, function);
+        if (site >= 0){
+            profiler->start(site);
+        }// end of if
+        t_in_hook = false;
+    }
+
+    void __cyg_profile_func_exit(void* function, void*) {
+        if (!ChronosInstrument::is_enabled() || t_in_hook){
+            return;
+        }// end of if
+        t_in_hook = true;
+        Chronos* profiler = Chronos::get_instance();
+        long site = ChronosInstrument::find_site(profiler, function);
+        if (site >= 0){
+            profiler->stop(site);
+        }// end of if
+        t_in_hook = false;
+    }
+}
+#endif
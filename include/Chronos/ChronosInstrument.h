@@ -0,0 +1,158 @@
+/**   Copyright 2020 Benrick Smit
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ * 
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+*/
+
+/**
+ * @author: Benrick Smit
+ * @email: metatronicprogramming@hotmail.com
+ * @date: 13 June 2020
+ * @modified: 13 June 2020
+ * 
+ * @brief: This class switches the function instrumentation of the profiler on and off. A program compiled with
+ *          -finstrument-functions calls __cyg_profile_func_enter and __cyg_profile_func_exit around every function, which the
+ *          hooks turn into a start and stop of the function's site, so whole modules can be profiled without touching their
+ *          source. The site of a function is found by its address in a fixed, lock-free table; only the first call of a
+ *          function takes a lock, to register it. The sites are named by their address until the reports are written, when
+ *          dladdr and abi::__cxa_demangle give their names, so the hot path never reads a symbol table.
+ * 
+ *          Functions can be left out with filters, which are matched against the demangled name of a function and the path
+ *          of the module it is in, the first time it is called. The filters can be set in the program, or through the
+ *          CHRONOS_INCLUDE and CHRONOS_EXCLUDE environment variables, as lists of patterns separated by commas. The table is
+ *          only allocated when the hooks are first switched on.
+ * 
+ *          The hooks are only compiled in with the CHRONOS_INSTRUMENT option of the CMake project, and a program needs
+ *          -rdynamic for dladdr to find the names of its own functions.
+ * 
+ */ 
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#ifndef CHRONOS_INSTRUMENT
+#define CHRONOS_INSTRUMENT 0
+#endif
+
+class Chronos;
+
+class ChronosInstrument {
+	public:
+		/**
+		 * @brief Switches the hooks on or off. Switching them on forgets the functions seen so far, and reads the filters of
+		 *          the environment again in place of the ones read before, so it should be done before the threads which are
+		 *          profiled start.
+		 * 
+		 * @param enabled 
+		 * @return true if the hooks are compiled in, or were switched off
+		 */
+		static bool set_enabled(bool enabled);
+		/**
+		 * @brief Whether the hooks are switched on
+		 * 
+		 * @return true 
+		 * @return false 
+		 */
+		static inline bool is_enabled() {
+			return s_enabled.load(std::memory_order_relaxed);
+		}
+		/**
+		 * @brief Whether the hooks are compiled in
+		 * 
+		 * @return true 
+		 * @return false 
+		 */
+		static bool is_compiled();
+		/**
+		 * @brief Profiles only the functions whose name or module contains one of the patterns given this way, if any are
+		 *          given. Applies to the functions first called after it.
+		 * 
+		 * @param pattern 
+		 */
+		static void include(std::string pattern);
+		/**
+		 * @brief Leaves out the functions whose name or module contains the pattern. Applies to the functions first called
+		 *          after it.
+		 * 
+		 * @param pattern 
+		 */
+		static void exclude(std::string pattern);
+		/**
+		 * @brief Get the site of a function, registering it with the profiler the first time it is seen
+		 * 
+		 * @param profiler 
+		 * @param function the address the hooks are given
+		 * @return long the site handle, or -1 if the function is filtered out or the table is full
+		 */
+		static inline long find_site(Chronos* profiler, const void* function) {
+			Entry* table = s_table.load(std::memory_order_acquire);
+			unsigned long slot = hash(function);
+			for (long probe = 0; table != nullptr && probe < k_table_size; probe++){
+				const void* key = table[slot].function.load(std::memory_order_acquire);
+				if (key == function){
+					return table[slot].site.load(std::memory_order_relaxed);
+				}// end of if
+				if (key == nullptr){
+					return s_full.load(std::memory_order_relaxed) ? -1 : add_function(profiler, function);
+				}// end of if
+				slot = (slot + 1) & (k_table_size - 1);
+			}// end of for
+			return -1;
+		}
+		/**
+		 * @brief Get the demangled name of a function through dladdr, or its module and offset when the symbol is not exported
+		 * 
+		 * @param function 
+		 * @return std::string 
+		 */
+		static std::string get_name(const void* function);
+
+		static const long k_table_size = 1 << 16;								// Slots of the table, of which at most half are used
+
+	private:
+		/**
+		 * @brief A function seen by the hooks. The site is written before the function, which publishes it
+		 * 
+		 */
+		struct Entry {
+			std::atomic<const void*> function;
+			std::atomic<long> site;
+		};
+
+		// Get the first slot of a function
+		static inline unsigned long hash(const void* function) {
+			std::uint64_t value = static_cast<std::uint64_t>(reinterpret_cast<std::uintptr_t>(function));
+			return static_cast<unsigned long>((value * 0x9E3779B97F4A7C15ull) >> 48) & (k_table_size - 1);
+		}
+		// Registers a function, or finds it if another thread just did
+		static long add_function(Chronos* profiler, const void* function);
+		// Whether the filters let a function through
+		static bool is_profiled(const void* function);
+		// Splits a list of patterns separated by commas into the filters
+		static void add_patterns(const char* patterns, std::vector<std::string>& filters);
+
+		static std::atomic<bool> s_enabled;										// Whether the hooks start and stop the sites
+		static std::atomic<bool> s_full;										// Whether the table has no room for more functions
+		static std::atomic<Entry*> s_table;										// Site of every function seen, by address, allocated
+																				// the first time the hooks are switched on
+		static long s_count;													// Functions in the table, guarded by s_mutex
+		static std::mutex s_mutex;												// Guards adding to the table and the filters
+		static std::vector<std::string> s_includes;								// Patterns of the functions profiled, all if empty
+		static std::vector<std::string> s_excludes;								// Patterns of the functions left out
+		static std::vector<std::string> s_env_includes;							// Patterns read from CHRONOS_INCLUDE
+		static std::vector<std::string> s_env_excludes;							// Patterns read from CHRONOS_EXCLUDE
+};
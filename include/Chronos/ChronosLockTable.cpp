@@ -0,0 +1,178 @@
+/**   Copyright 2020 Benrick Smit
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ * 
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+*/
+
+/**
+ * @author: Benrick Smit
+ * @email: metatronicprogramming@hotmail.com
+ * @date: 13 June 2020
+ * @modified: 13 June 2020
+ * 
+ * @brief: This class keeps the statistics of every ChronosMutex and ChronosSharedMutex.
+ * 
+ */ 
+
+
+#include "ChronosLockTable.h"
+
+#include <algorithm>
+
+#include "ChronosClock.h"
+
+
+// Clears a record, before it is handed to a lock
+static void clear(ChronosLockStats* stats) {
+    stats->acquisitions.store(0, std::memory_order_relaxed);
+    stats->contended.store(0, std::memory_order_relaxed);
+    stats->wait.store(0, std::memory_order_relaxed);
+    stats->max_wait.store(0, std::memory_order_relaxed);
+    stats->timed_holds.store(0, std::memory_order_relaxed);
+    stats->hold.store(0, std::memory_order_relaxed);
+    stats->max_hold.store(0, std::memory_order_relaxed);
+    stats->shared_acquisitions.store(0, std::memory_order_relaxed);
+    stats->shared_contended.store(0, std::memory_order_relaxed);
+    stats->shared_wait.store(0, std::memory_order_relaxed);
+}
+
+
+
+//Ctors and Dtors
+ChronosLockTable::ChronosLockTable() {
+}
+
+
+ChronosLockTable& ChronosLockTable::get_instance() {
+    // Never destroyed, so the locks with static storage can give their records back at any point of the exit
+    static ChronosLockTable* instance = new ChronosLockTable();
+    return *instance;
+}
+
+
+
+//Basic Functionality
+ChronosLockStats* ChronosLockTable::acquire(const std::string& name) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto found = m_names.find(name);
+    if (found == m_names.end()){
+        ChronosLockData data = {name, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
+        found = m_names.emplace(name, static_cast<long>(m_retired.size())).first;
+        m_retired.push_back(data);
+    }// end of if
+    ChronosLockStats* stats = nullptr;
+    if (m_free.empty()){
+        stats = new ChronosLockStats();
+    }else{
+        stats = m_free.back();
+        m_free.pop_back();
+    }// end of if else
+    clear(stats);
+    m_live[stats] = found->second;
+    m_retired[found->second].locks++;
+    return stats;
+}
+
+
+void ChronosLockTable::release(ChronosLockStats* stats) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto found = m_live.find(stats);
+    if (found == m_live.end()){
+        return;
+    }// end of if
+    add(stats, m_retired[found->second]);
+    m_live.erase(found);
+    m_free.push_back(stats);
+}
+
+
+std::vector<ChronosLockData> ChronosLockTable::snapshot() {
+    std::vector<ChronosLockData> locks;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        locks = m_retired;
+        for (auto& live: m_live){
+            add(live.first, locks[live.second]);
+        }// end of for
+    }
+    // Names which were never taken say nothing about contention
+    locks.erase(std::remove_if(locks.begin(), locks.end(), [](ChronosLockData& data){
+        return data.acquisitions == 0 && data.shared_acquisitions == 0;
+    }), locks.end());
+    std::sort(locks.begin(), locks.end(), [](const ChronosLockData& a, const ChronosLockData& b){
+        return a.wait + a.shared_wait > b.wait + b.shared_wait;
+    });
+    return locks;
+}
+
+
+
+//Display
+std::string ChronosLockTable::get_header_csv() {
+    return "Locks,Acquisitions,Contended,Contended Share,Wait Time,Mean Wait Time,Max Wait Time,Hold Time,Mean Hold Time,"
+           "Max Hold Time,Shared Acquisitions,Shared Contended,Shared Wait Time,Lock";
+}
+
+
+std::string ChronosLockTable::to_csv(std::vector<ChronosLockData>& locks) {
+    std::string to_return;
+    for (ChronosLockData& lock: locks){
+        to_return += columns(lock, ",") + ',' + lock.name + '\n';
+    }// end of for
+    return to_return;
+}
+
+
+std::string ChronosLockTable::get_header() {
+    return "Locks\t\tAcquisitions\t\tContended\t\tContended Share\t\tWait Time\t\tMean Wait Time\t\tMax Wait Time\t\tHold Time\t\t"
+           "Mean Hold Time\t\tMax Hold Time\t\tShared Acquisitions\t\tShared Contended\t\tShared Wait Time\t\tLock";
+}
+
+
+std::string ChronosLockTable::to_string(std::vector<ChronosLockData>& locks) {
+    std::string to_return;
+    for (ChronosLockData& lock: locks){
+        to_return += columns(lock, "\t\t") + "\t\t" + lock.name + '\n';
+    }// end of for
+    return to_return;
+}
+
+
+
+//Private Functions
+void ChronosLockTable::add(ChronosLockStats* stats, ChronosLockData& data) {
+    double period = ChronosClock::get_seconds_per_tick();
+    data.acquisitions += stats->acquisitions.load(std::memory_order_relaxed);
+    data.contended += stats->contended.load(std::memory_order_relaxed);
+    data.wait += stats->wait.load(std::memory_order_relaxed) * period;
+    data.max_wait = std::max(data.max_wait, stats->max_wait.load(std::memory_order_relaxed) * period);
+    data.timed_holds += stats->timed_holds.load(std::memory_order_relaxed);
+    data.hold += stats->hold.load(std::memory_order_relaxed) * period;
+    data.max_hold = std::max(data.max_hold, stats->max_hold.load(std::memory_order_relaxed) * period);
+    data.shared_acquisitions += stats->shared_acquisitions.load(std::memory_order_relaxed);
+    data.shared_contended += stats->shared_contended.load(std::memory_order_relaxed);
+    data.shared_wait += stats->shared_wait.load(std::memory_order_relaxed) * period;
+}
+
+
+std::string ChronosLockTable::columns(ChronosLockData& lock, const std::string& separator) {
+    double acquisitions = lock.acquisitions > 0 ? static_cast<double>(lock.acquisitions) : 1.0;
+    double contended = lock.contended > 0 ? static_cast<double>(lock.contended) : 1.0;
+    // The timed holds stand in for all of them
+    double hold = lock.timed_holds > 0 ? lock.hold * lock.acquisitions / lock.timed_holds : 0;
+    return std::to_string(lock.locks) + separator + std::to_string(lock.acquisitions) + separator + std::to_string(lock.contended)
+           + separator + std::to_string(lock.contended / acquisitions) + separator + std::to_string(lock.wait)
+           + separator + std::to_string(lock.wait / contended) + separator + std::to_string(lock.max_wait)
+           + separator + std::to_string(hold) + separator + std::to_string(hold / acquisitions)
+           + separator + std::to_string(lock.max_hold) + separator + std::to_string(lock.shared_acquisitions)
+           + separator + std::to_string(lock.shared_contended) + separator + std::to_string(lock.shared_wait);
+}
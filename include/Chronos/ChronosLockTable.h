@@ -0,0 +1,200 @@
+/**   Copyright 2020 Benrick Smit
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ * 
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+*/
+
+/**
+ * @author: Benrick Smit
+ * @email: metatronicprogramming@hotmail.com
+ * @date: 13 June 2020
+ * @modified: 13 June 2020
+ * 
+ * @brief: This class keeps the statistics of every ChronosMutex and ChronosSharedMutex: how often each was taken, how often
+ *          it had to be waited for, and how long the threads waited and held it. Every lock gets a record of its own, which
+ *          it writes while holding itself, so the exclusive statistics need no atomic read-modify-writes. The hold time is
+ *          only timed for one in every k_hold_period acquisitions, contended or not, which keeps an uncontended lock close
+ *          to the cost of a raw one and every hold equally likely to be timed; the reports extrapolate it to all of them. When a lock is
+ *          destroyed its record is folded into the totals of its name and reused. The table belongs to the process rather
+ *          than to the profiler, so locks which outlive the profiler can still give their records back.
+ * 
+ */ 
+
+#pragma once
+
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @brief The statistics of one lock, in clock ticks. The exclusive ones are only written by the thread holding the lock; the
+ *          shared ones, written by the readers at once, are on a cache line of their own.
+ * 
+ */
+struct alignas(64) ChronosLockStats {
+    std::atomic<long> acquisitions;                                         // Times the lock was taken exclusively
+    std::atomic<long> contended;                                            // Times it was held by another thread at the time
+    std::atomic<long long> wait;                                            // Ticks spent waiting for it
+    std::atomic<long long> max_wait;                                        // Longest wait
+    std::atomic<long> timed_holds;                                          // Exclusive holds which were timed
+    std::atomic<long long> hold;                                            // Ticks of those holds
+    std::atomic<long long> max_hold;                                        // Longest hold
+    alignas(64) std::atomic<long> shared_acquisitions;                      // Times it was taken shared
+    std::atomic<long> shared_contended;                                     // Times a reader had to wait
+    std::atomic<long long> shared_wait;                                     // Ticks the readers spent waiting
+};
+
+/**
+ * @brief The statistics of all the locks of one name, with the times in seconds
+ * 
+ */
+struct ChronosLockData {
+    std::string name;
+    long locks;                                                             // Locks of the name, live or destroyed
+    long acquisitions;
+    long contended;
+    double wait;
+    double max_wait;
+    long timed_holds;
+    double hold;
+    double max_hold;
+    long shared_acquisitions;
+    long shared_contended;
+    double shared_wait;
+};
+
+class ChronosLockTable {
+	public:
+		//ctors and dtors
+		/**
+		 * @brief Get the instance object, which is created on first use and never destroyed
+		 * 
+		 * @return ChronosLockTable& 
+		 */
+		static ChronosLockTable& get_instance();
+
+		ChronosLockTable(const ChronosLockTable&) = delete;
+		ChronosLockTable& operator=(const ChronosLockTable&) = delete;
+
+		//Basic Operation
+		/**
+		 * @brief Hands out a zeroed record for a new lock
+		 * 
+		 * @param name the name the lock is reported under, several locks may share it
+		 * @return ChronosLockStats* 
+		 */
+		ChronosLockStats* acquire(const std::string& name);
+		/**
+		 * @brief Folds the record of a lock being destroyed into the totals of its name, and keeps it for the next lock
+		 * 
+		 * @param stats 
+		 */
+		void release(ChronosLockStats* stats);
+		/**
+		 * @brief Adds up the records of every name, live and destroyed, the longest total wait first
+		 * 
+		 * @return std::vector<ChronosLockData> 
+		 */
+		std::vector<ChronosLockData> snapshot();
+		/**
+		 * @brief Adds a contended acquisition to a lock's record, by the thread which now holds the lock
+		 * 
+		 * @param stats 
+		 * @param ticks the time the thread waited
+		 */
+		static inline void add_wait(ChronosLockStats* stats, long long ticks) {
+			stats->contended.store(stats->contended.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+			stats->wait.store(stats->wait.load(std::memory_order_relaxed) + ticks, std::memory_order_relaxed);
+			if (ticks > stats->max_wait.load(std::memory_order_relaxed)){
+				stats->max_wait.store(ticks, std::memory_order_relaxed);
+			}// end of if
+		}
+		/**
+		 * @brief Counts an exclusive acquisition, by the thread which now holds the lock
+		 * 
+		 * @param stats 
+		 * @return true if the hold should be timed
+		 */
+		static inline bool add_acquisition(ChronosLockStats* stats) {
+			long acquisitions = stats->acquisitions.load(std::memory_order_relaxed);
+			stats->acquisitions.store(acquisitions + 1, std::memory_order_relaxed);
+			return acquisitions % k_hold_period == 0;
+		}
+		/**
+		 * @brief Adds a timed exclusive hold to a lock's record, by the thread still holding the lock
+		 * 
+		 * @param stats 
+		 * @param ticks the time the lock was held
+		 */
+		static inline void add_hold(ChronosLockStats* stats, long long ticks) {
+			stats->timed_holds.store(stats->timed_holds.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+			stats->hold.store(stats->hold.load(std::memory_order_relaxed) + ticks, std::memory_order_relaxed);
+			if (ticks > stats->max_hold.load(std::memory_order_relaxed)){
+				stats->max_hold.store(ticks, std::memory_order_relaxed);
+			}// end of if
+		}
+
+		//Display
+		/**
+		 * @brief Get the header of the CSV rows, in which the name of the lock is the last column
+		 * 
+		 * @return std::string 
+		 */
+		static std::string get_header_csv();
+		/**
+		 * @brief Writes the locks as CSV rows
+		 * 
+		 * @param locks 
+		 * @return std::string 
+		 */
+		static std::string to_csv(std::vector<ChronosLockData>& locks);
+		/**
+		 * @brief Get the header of the text rows
+		 * 
+		 * @return std::string 
+		 */
+		static std::string get_header();
+		/**
+		 * @brief Writes the locks as text rows
+		 * 
+		 * @param locks 
+		 * @return std::string 
+		 */
+		static std::string to_string(std::vector<ChronosLockData>& locks);
+
+		static const long k_hold_period = 16;									// One in every k_hold_period holds is timed
+
+	private:
+		/**
+		 * @brief Construct a new Chronos Lock Table object, which is empty
+		 * 
+		 */
+		ChronosLockTable();
+		/**
+		 * @brief Adds the statistics of a record to those of its name
+		 * 
+		 * @param stats 
+		 * @param data 
+		 */
+		static void add(ChronosLockStats* stats, ChronosLockData& data);
+		// Formats the columns both reports share
+		static std::string columns(ChronosLockData& lock, const std::string& separator);
+
+		//Member variables
+		std::mutex m_mutex;														// Guards the table, only taken when locks are made or destroyed
+		std::vector<ChronosLockData> m_retired;									// Totals of the destroyed locks, one entry per name
+		std::unordered_map<std::string, long> m_names;							// Maps a name to its entry
+		std::unordered_map<ChronosLockStats*, long> m_live;						// Maps the record of every live lock to its name's entry
+		std::vector<ChronosLockStats*> m_free;									// Records of destroyed locks, ready for reuse
+};
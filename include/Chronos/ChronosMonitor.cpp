@@ -0,0 +1,120 @@
+/**   Copyright 2020 Benrick Smit
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ * 
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+*/
+
+/**
+ * @author: Benrick Smit
+ * @email: metatronicprogramming@hotmail.com
+ * @date: 13 June 2020
+ * @modified: 13 June 2020
+ * 
+ * @brief: This class reports the statistics of a running program at a fixed interval.
+ * 
+ */ 
+
+
+#include "ChronosMonitor.h"
+
+
+//Ctors and Dtors
+ChronosMonitor::ChronosMonitor() {
+    m_interval = 0;
+    m_running = false;
+}
+
+
+ChronosMonitor::~ChronosMonitor() {
+    stop();
+}
+
+
+
+//Basic Functionality
+bool ChronosMonitor::start(double interval, Source source, Callback callback) {
+    if (m_timer.joinable() || interval <= 0 || !source || !callback){
+        return false;
+    }// end of if
+    m_interval = interval;
+    m_source = std::move(source);
+    m_callback = std::move(callback);
+    m_previous = m_source();
+    m_previous_time = std::chrono::steady_clock::now();
+    m_running = true;
+    m_timer = std::thread(&ChronosMonitor::run, this);
+    return true;
+}
+
+void ChronosMonitor::stop() {
+    if (!m_timer.joinable()){
+        return;
+    }// end of if
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_running = false;
+    }
+    m_wake.notify_all();
+    m_timer.join();
+    // Report the calls made since the last interval ended
+    report();
+    m_previous.clear();
+}
+
+bool ChronosMonitor::is_running() {
+    return m_timer.joinable();
+}
+
+std::vector<ChronosProcess> ChronosMonitor::difference(std::vector<ChronosProcess>& current, std::vector<ChronosProcess>& previous) {
+    std::vector<ChronosProcess> window;
+    // Both lists are sorted by name, so they are walked side by side
+    unsigned long earlier = 0;
+    for (ChronosProcess& process: current){
+        while (earlier < previous.size() && previous[earlier].get_name() < process.get_name()){
+            earlier++;
+        }// end of while
+        ChronosProcess delta = process;
+        if (earlier < previous.size() && previous[earlier].get_name() == process.get_name()){
+            delta.subtract(previous[earlier]);
+        }// end of if
+        if (delta.get_total_calls() > 0){
+            window.push_back(std::move(delta));
+        }// end of if
+    }// end of for
+    return window;
+}
+
+//Private Functions
+void ChronosMonitor::run() {
+    auto interval = std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(m_interval));
+    // Every deadline follows from the first, so the reports do not drift by the time they take
+    auto deadline = m_previous_time + interval;
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (m_running){
+        if (m_wake.wait_until(lock, deadline, [this]{ return !m_running; })){
+            break;
+        }// end of if
+        lock.unlock();
+        report();
+        lock.lock();
+        deadline += interval;
+    }// end of while
+}
+
+void ChronosMonitor::report() {
+    std::vector<ChronosProcess> current = m_source();
+    auto now = std::chrono::steady_clock::now();
+    std::vector<ChronosProcess> window = difference(current, m_previous);
+    m_callback(window, std::chrono::duration<double>(now - m_previous_time).count());
+    m_previous = std::move(current);
+    m_previous_time = now;
+}
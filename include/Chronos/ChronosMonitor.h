@@ -0,0 +1,107 @@
+/**   Copyright 2020 Benrick Smit
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ * 
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+*/
+
+/**
+ * @author: Benrick Smit
+ * @email: metatronicprogramming@hotmail.com
+ * @date: 13 June 2020
+ * @modified: 13 June 2020
+ * 
+ * @brief: This class reports the statistics of a running program at a fixed interval. A timer thread takes a snapshot every
+ *          interval, and hands the difference with the previous snapshot, the calls made during the interval, to a callback.
+ *          Recording is never stopped or reset: the snapshots only read the counters of the recording threads, which keep
+ *          going while they are read.
+ * 
+ */ 
+
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "ChronosProcess.h"
+
+class ChronosMonitor {
+	public:
+		// Takes a snapshot, one process per function name, sorted by name
+		using Source = std::function<std::vector<ChronosProcess>()>;
+		// Receives the calls of one interval, and the length of the interval in seconds
+		using Callback = std::function<void(std::vector<ChronosProcess>& window, double seconds)>;
+
+		//ctors and dtors
+		/**
+		 * @brief Construct a new Chronos Monitor object, which is idle until started
+		 * 
+		 */
+		ChronosMonitor();
+		/**
+		 * @brief Destroy the Chronos Monitor object, stopping the timer thread
+		 * 
+		 */
+		~ChronosMonitor();
+
+		//Basic Operation
+		/**
+		 * @brief Starts the timer thread. The first interval starts with the snapshot taken here.
+		 * 
+		 * @param interval the seconds between two reports
+		 * @param source takes the snapshots
+		 * @param callback receives the calls of every interval, on the timer thread
+		 * @return true if the monitor was not running yet
+		 */
+		bool start(double interval, Source source, Callback callback);
+		/**
+		 * @brief Stops the timer thread, after reporting the calls made since the last report
+		 * 
+		 */
+		void stop();
+		/**
+		 * @brief Whether the timer thread is running
+		 * 
+		 * @return true 
+		 * @return false 
+		 */
+		bool is_running();
+		/**
+		 * @brief Subtracts an earlier snapshot from a later one, leaving the calls made in between. Both must be sorted by name,
+		 *          as Chronos::snapshot returns them. Functions which were not called in between are left out.
+		 * 
+		 * @param current 
+		 * @param previous 
+		 * @return std::vector<ChronosProcess> 
+		 */
+		static std::vector<ChronosProcess> difference(std::vector<ChronosProcess>& current, std::vector<ChronosProcess>& previous);
+
+	private:
+		// Body of the timer thread
+		void run();
+		// Takes a snapshot, and reports its difference with the previous one
+		void report();
+
+		//Member variables
+		double m_interval;														// Seconds between two reports
+		Source m_source;														// Takes the snapshots
+		Callback m_callback;													// Receives the windows
+		std::vector<ChronosProcess> m_previous;									// The snapshot the current window started with
+		std::chrono::steady_clock::time_point m_previous_time;					// When that snapshot was taken
+		bool m_running;															// Keeps the timer going, guarded by m_mutex
+		std::mutex m_mutex;														// Guards m_running, for the condition
+		std::condition_variable m_wake;											// Wakes the timer thread early to stop
+		std::thread m_timer;													// The timer thread
+};
@@ -0,0 +1,64 @@
+/**   Copyright 2020 Benrick Smit
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ * 
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+*/
+
+/**
+ * @author: Benrick Smit
+ * @email: metatronicprogramming@hotmail.com
+ * @date: 13 June 2020
+ * @modified: 13 June 2020
+ * 
+ * @brief: These classes are drop-in replacements for std::mutex and std::shared_mutex, which record their contention.
+ * 
+ */ 
+
+
+#include "ChronosMutex.h"
+
+#include <cstdio>
+
+
+// The name of a lock in the reports, its address if it was not given one
+static std::string lock_name(const std::string& name, const void* address) {
+    if (!name.empty()){
+        return name;
+    }// end of if
+    char buffer[32];
+    std::snprintf(buffer, sizeof(buffer), "lock at %p", address);
+    return buffer;
+}
+
+
+
+//Ctors and Dtors
+ChronosMutex::ChronosMutex(const std::string& name) {
+    m_stats = ChronosLockTable::get_instance().acquire(lock_name(name, this));
+    m_locked_at = -1;
+}
+
+
+ChronosMutex::~ChronosMutex() {
+    ChronosLockTable::get_instance().release(m_stats);
+}
+
+
+ChronosSharedMutex::ChronosSharedMutex(const std::string& name) {
+    m_stats = ChronosLockTable::get_instance().acquire(lock_name(name, this));
+    m_locked_at = -1;
+}
+
+
+ChronosSharedMutex::~ChronosSharedMutex() {
+    ChronosLockTable::get_instance().release(m_stats);
+}
@@ -0,0 +1,199 @@
+/**   Copyright 2020 Benrick Smit
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ * 
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+*/
+
+/**
+ * @author: Benrick Smit
+ * @email: metatronicprogramming@hotmail.com
+ * @date: 13 June 2020
+ * @modified: 13 June 2020
+ * 
+ * @brief: These classes are drop-in replacements for std::mutex and std::shared_mutex, as Chronos::mutex and
+ *          Chronos::shared_mutex, which record how long the threads waited for them and held them. A lock first tries to
+ *          take the mutex; only when that fails is the wait timed, so an uncontended lock costs a raw lock, a counter, and now
+ *          and then the two clock reads of a timed hold. Every lock writes its own record in ChronosLockTable while it holds the mutex, and the
+ *          readers of a shared mutex add to theirs with atomics. They work with std::lock_guard, std::unique_lock,
+ *          std::shared_lock and std::scoped_lock.
+ * 
+ */ 
+
+#pragma once
+
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+
+#include "ChronosClock.h"
+#include "ChronosLockTable.h"
+
+class ChronosMutex {
+	public:
+		//ctors and dtors
+		/**
+		 * @brief Construct a new Chronos Mutex object
+		 * 
+		 * @param name the name in the reports, which several locks may share; an unnamed lock is reported by its address
+		 */
+		explicit ChronosMutex(const std::string& name = std::string());
+		/**
+		 * @brief Destroy the Chronos Mutex object, and give its statistics to the lock table
+		 * 
+		 */
+		~ChronosMutex();
+
+		ChronosMutex(const ChronosMutex&) = delete;
+		ChronosMutex& operator=(const ChronosMutex&) = delete;
+
+		//Basic Operation
+		/**
+		 * @brief Takes the mutex, timing the wait if another thread holds it
+		 * 
+		 */
+		inline void lock() {
+			if (!m_mutex.try_lock()){
+				long long start = ChronosClock::start_ticks();
+				m_mutex.lock();
+				long long locked = ChronosClock::start_ticks();
+				ChronosLockTable::add_wait(m_stats, locked - start);
+				m_locked_at = ChronosLockTable::add_acquisition(m_stats) ? locked : -1;
+				return;
+			}// end of if
+			m_locked_at = ChronosLockTable::add_acquisition(m_stats) ? ChronosClock::start_ticks() : -1;
+		}
+		/**
+		 * @brief Takes the mutex if no other thread holds it
+		 * 
+		 * @return true if the mutex was taken
+		 */
+		inline bool try_lock() {
+			if (!m_mutex.try_lock()){
+				return false;
+			}// end of if
+			m_locked_at = ChronosLockTable::add_acquisition(m_stats) ? ChronosClock::start_ticks() : -1;
+			return true;
+		}
+		/**
+		 * @brief Adds the hold time, and releases the mutex
+		 * 
+		 */
+		inline void unlock() {
+			if (m_locked_at >= 0){
+				ChronosLockTable::add_hold(m_stats, ChronosClock::stop_ticks() - m_locked_at);
+			}// end of if
+			m_mutex.unlock();
+		}
+
+	private:
+		//Member variables
+		std::mutex m_mutex;														// The mutex itself
+		ChronosLockStats* m_stats;												// The lock's record, only written while holding the mutex
+		long long m_locked_at;													// Clock ticks when the mutex was last taken, -1 if the hold is not timed
+};
+
+class ChronosSharedMutex {
+	public:
+		//ctors and dtors
+		/**
+		 * @brief Construct a new Chronos Shared Mutex object
+		 * 
+		 * @param name the name in the reports, which several locks may share; an unnamed lock is reported by its address
+		 */
+		explicit ChronosSharedMutex(const std::string& name = std::string());
+		/**
+		 * @brief Destroy the Chronos Shared Mutex object, and give its statistics to the lock table
+		 * 
+		 */
+		~ChronosSharedMutex();
+
+		ChronosSharedMutex(const ChronosSharedMutex&) = delete;
+		ChronosSharedMutex& operator=(const ChronosSharedMutex&) = delete;
+
+		//Basic Operation
+		/**
+		 * @brief Takes the mutex exclusively, timing the wait if other threads hold it
+		 * 
+		 */
+		inline void lock() {
+			if (!m_mutex.try_lock()){
+				long long start = ChronosClock::start_ticks();
+				m_mutex.lock();
+				long long locked = ChronosClock::start_ticks();
+				ChronosLockTable::add_wait(m_stats, locked - start);
+				m_locked_at = ChronosLockTable::add_acquisition(m_stats) ? locked : -1;
+				return;
+			}// end of if
+			m_locked_at = ChronosLockTable::add_acquisition(m_stats) ? ChronosClock::start_ticks() : -1;
+		}
+		/**
+		 * @brief Takes the mutex exclusively if no other thread holds it
+		 * 
+		 * @return true if the mutex was taken
+		 */
+		inline bool try_lock() {
+			if (!m_mutex.try_lock()){
+				return false;
+			}// end of if
+			m_locked_at = ChronosLockTable::add_acquisition(m_stats) ? ChronosClock::start_ticks() : -1;
+			return true;
+		}
+		/**
+		 * @brief Adds the hold time, and releases the exclusive hold
+		 * 
+		 */
+		inline void unlock() {
+			if (m_locked_at >= 0){
+				ChronosLockTable::add_hold(m_stats, ChronosClock::stop_ticks() - m_locked_at);
+			}// end of if
+			m_mutex.unlock();
+		}
+		/**
+		 * @brief Takes the mutex shared, timing the wait if a writer holds it. The readers hold it at once, so their hold time
+		 *          is not kept.
+		 * 
+		 */
+		inline void lock_shared() {
+			if (!m_mutex.try_lock_shared()){
+				long long start = ChronosClock::start_ticks();
+				m_mutex.lock_shared();
+				m_stats->shared_wait.fetch_add(ChronosClock::start_ticks() - start, std::memory_order_relaxed);
+				m_stats->shared_contended.fetch_add(1, std::memory_order_relaxed);
+			}// end of if
+			m_stats->shared_acquisitions.fetch_add(1, std::memory_order_relaxed);
+		}
+		/**
+		 * @brief Takes the mutex shared if no writer holds it
+		 * 
+		 * @return true if the mutex was taken
+		 */
+		inline bool try_lock_shared() {
+			if (!m_mutex.try_lock_shared()){
+				return false;
+			}// end of if
+			m_stats->shared_acquisitions.fetch_add(1, std::memory_order_relaxed);
+			return true;
+		}
+		/**
+		 * @brief Releases a shared hold
+		 * 
+		 */
+		inline void unlock_shared() {
+			m_mutex.unlock_shared();
+		}
+
+	private:
+		//Member variables
+		std::shared_mutex m_mutex;												// The mutex itself
+		ChronosLockStats* m_stats;												// The lock's record, the exclusive part only written by the writer
+		long long m_locked_at;													// Clock ticks when the mutex was last taken exclusively, -1 if not timed
+};
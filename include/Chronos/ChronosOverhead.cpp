@@ -0,0 +1,112 @@
+/**   Copyright 2020 Benrick Smit
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ * 
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+*/
+
+/**
+ * @author: Benrick Smit
+ * @email: metatronicprogramming@hotmail.com
+ * @date: 13 June 2020
+ * @modified: 13 June 2020
+ * 
+ * @brief: This class measures what the profiler itself costs.
+ * 
+ */ 
+
+
+#include "ChronosOverhead.h"
+
+#include <algorithm>
+#include <vector>
+
+#include "Chronos.h"
+
+
+//Ctors and Dtors
+ChronosOverhead::ChronosOverhead() {
+    m_inner_cost = 0;
+    m_timed_cost = 0;
+    m_untimed_cost = 0;
+}
+
+ChronosOverhead::~ChronosOverhead() {
+    // Do Nothing
+}
+
+//Basic Functionality
+void ChronosOverhead::calibrate(Chronos& profiler) {
+    long parent = profiler.register_site("Chronos calibration");
+    long timed = profiler.register_site("Chronos calibration, timed");
+    long untimed = profiler.register_site("Chronos calibration, sampled out");
+    profiler.m_sampler.set_period(untimed, ChronosSampler::k_max_period);
+
+    // The empty calls run inside a timed call, so they walk the call tree and the shadow stack as a program's calls do
+    double unused = 0;
+    profiler.start(parent);
+    m_timed_cost = measure_pair(profiler, timed, m_inner_cost);
+    m_untimed_cost = measure_pair(profiler, untimed, unused);
+    profiler.stop(parent);
+    profiler.m_sampler.set_period(untimed, 0);
+}
+
+double ChronosOverhead::get_inner_cost() {
+    return m_inner_cost;
+}
+
+double ChronosOverhead::get_timed_cost() {
+    return m_timed_cost;
+}
+
+double ChronosOverhead::get_untimed_cost() {
+    return m_untimed_cost;
+}
+
+std::string ChronosOverhead::to_string() {
+    double nanoseconds = ChronosClock::get_seconds_per_tick() * 1e9;
+    return std::to_string(m_inner_cost * nanoseconds) + " ns per timed call, " + std::to_string(m_timed_cost * nanoseconds)
+           + " ns per timed callee, " + std::to_string(m_untimed_cost * nanoseconds) + " ns per sampled out callee";
+}
+
+//Private Functions
+double ChronosOverhead::measure_pair(Chronos& profiler, long site, double& inner) {
+    // Called once first, so the site's buffers and call tree node are allocated and, when sampling, the countdown is running
+    profiler.start(site);
+    profiler.stop(site);
+
+    std::vector<double> rounds;
+    std::vector<double> inner_rounds;
+    ChronosProcess before;
+    ChronosProcess after;
+    for (long round = 0; round < k_rounds; round++){
+        profiler.get_thread()->read_site(site, before);
+        long long begin = ChronosClock::start_ticks();
+        for (long i = 0; i < k_calls; i++){
+            profiler.start(site);
+            profiler.stop(site);
+        }// end of for
+        long long end = ChronosClock::stop_ticks();
+        rounds.push_back(static_cast<double>(end - begin) / k_calls);
+
+        // The exact time the round's timed calls were timed at, rather than a bucket of the histogram
+        profiler.get_thread()->read_site(site, after);
+        long timed = after.get_timed_calls() - before.get_timed_calls();
+        if (timed > 0){
+            double seconds = after.get_mean_time() * after.get_timed_calls() - before.get_mean_time() * before.get_timed_calls();
+            inner_rounds.push_back(seconds / ChronosClock::get_seconds_per_tick() / timed);
+        }// end of if
+    }// end of for
+    std::sort(rounds.begin(), rounds.end());
+    std::sort(inner_rounds.begin(), inner_rounds.end());
+    inner = inner_rounds.empty() ? 0 : inner_rounds[inner_rounds.size() / 2];
+    return rounds[rounds.size() / 2];
+}
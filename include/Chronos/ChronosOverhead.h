@@ -0,0 +1,97 @@
+/**   Copyright 2020 Benrick Smit
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ * 
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+*/
+
+/**
+ * @author: Benrick Smit
+ * @email: metatronicprogramming@hotmail.com
+ * @date: 13 June 2020
+ * @modified: 13 June 2020
+ * 
+ * @brief: This class measures what the profiler itself costs, so it can be taken out of the reported times. A calibration loop
+ *          profiles empty calls through the profiler's own start and stop, on private sites nested in a timed call as the
+ *          calls of a program are, and measures three costs, in clock ticks:
+ *              - the time an empty call is timed at, which every timed call adds to its own time;
+ *              - the time a timed start and stop take from end to end, which a call adds to the time of every caller;
+ *              - the same for a call which sampling left untimed, which is only counted.
+ *          The medians of several rounds are kept, so an interrupt during the calibration does not skew them.
+ * 
+ */ 
+
+#pragma once
+
+#include <string>
+
+class Chronos;
+
+class ChronosOverhead {
+	public:
+		//ctors and dtors
+		/**
+		 * @brief Construct a new Chronos Overhead object, which reports no cost until calibrated
+		 * 
+		 */
+		ChronosOverhead();
+		/**
+		 * @brief Destroy the Chronos Overhead object
+		 * 
+		 */
+		~ChronosOverhead();
+
+		//Basic Operation
+		/**
+		 * @brief Runs the calibration loop on the calling thread. The clock must be calibrated first, and the profiler should
+		 *          forget the sites and the thread buffer it leaves behind.
+		 * 
+		 * @param profiler 
+		 */
+		void calibrate(Chronos& profiler);
+		/**
+		 * @brief Get the inner cost object
+		 * 
+		 * @return double the ticks an empty timed call is timed at
+		 */
+		double get_inner_cost();
+		/**
+		 * @brief Get the timed cost object
+		 * 
+		 * @return double the ticks a timed call adds to the time of its callers
+		 */
+		double get_timed_cost();
+		/**
+		 * @brief Get the untimed cost object
+		 * 
+		 * @return double the ticks a call left untimed by sampling adds to the time of its callers
+		 */
+		double get_untimed_cost();
+		/**
+		 * @brief Describes the calibrated costs, in nanoseconds, for the report header
+		 * 
+		 * @return std::string 
+		 */
+		std::string to_string();
+
+	private:
+		// Times rounds of empty calls to the site, and returns the median cost of one call. The median time the site's own
+		// timed calls were timed at is set to inner, or 0 if none were timed
+		double measure_pair(Chronos& profiler, long site, double& inner);
+
+		//Member variables
+		double m_inner_cost;													// Ticks an empty timed call is timed at
+		double m_timed_cost;													// Ticks a timed call adds to its callers
+		double m_untimed_cost;													// Ticks an untimed call adds to its callers
+
+		static const long k_calls = 4096;										// Empty calls per round
+		static const long k_rounds = 9;											// Rounds, of which the median is kept
+};
@@ -27,6 +27,10 @@
 
 #include "ChronosProcess.h"  
 
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
 
 //Ctors and Dtors
 ChronosProcess::ChronosProcess(std::string func_name, std::string u_id){
@@ -62,16 +66,65 @@ void ChronosProcess::set_total_calls(double value)
     m_total_calls = value;
 }
 
-void ChronosProcess::set_start_time(std::chrono::time_point<std::chrono::high_resolution_clock> value) {
+void ChronosProcess::set_timed_calls(long value) {
+    m_timed_calls = value;
+}
+
+void ChronosProcess::set_start_time(long long value) {
     m_start = value;
 }
 
-void ChronosProcess::set_stop_time(std::chrono::time_point<std::chrono::high_resolution_clock> value) {
+void ChronosProcess::set_stop_time(long long value) {
     m_stop = value;
 }
 
+void ChronosProcess::set_name(std::string value) {
+    m_calling_function = std::move(value);
+}
+
 void ChronosProcess::set_unique_id(std::string value) {
-    m_unique_id = value;
+    m_unique_id = std::move(value);
+}
+
+void ChronosProcess::set_inclusive_time(double value) {
+    m_inclusive_time = value;
+}
+
+void ChronosProcess::set_self_time(double value) {
+    m_self_time = value;
+}
+
+void ChronosProcess::set_sum_squares(double value) {
+    m_sum_squares = value;
+}
+
+void ChronosProcess::set_histogram(const ChronosHistogram& value) {
+    m_histogram = value;
+}
+
+void ChronosProcess::set_thread_id(long value) {
+    m_thread_id = value;
+}
+
+void ChronosProcess::set_counters(const unsigned long long* values, long counted) {
+    for (int i = 0; i < ChronosCounters::k_counter_count; i++){
+        m_counters[i] = values[i];
+    }// end of for
+    m_counted_calls = counted;
+}
+
+void ChronosProcess::set_allocations(long count, long long bytes, long long peak_live_bytes) {
+    m_allocations = count;
+    m_allocated_bytes = bytes;
+    m_peak_live_bytes = peak_live_bytes;
+}
+
+void ChronosProcess::set_cpu_time(long calls, double cpu_time, double wall_time, long voluntary, long involuntary) {
+    m_cpu_calls = calls;
+    m_cpu_time = cpu_time;
+    m_cpu_wall_time = wall_time;
+    m_voluntary_switches = voluntary;
+    m_involuntary_switches = involuntary;
 }
 
 
@@ -97,22 +150,145 @@ double ChronosProcess::get_total_calls() {
     return m_total_calls;
 }
 
-std::chrono::time_point<std::chrono::high_resolution_clock> ChronosProcess::get_start_time() {
+long ChronosProcess::get_timed_calls() {
+    return m_timed_calls;
+}
+
+bool ChronosProcess::is_sampled() {
+    return m_timed_calls < m_total_calls;
+}
+
+long long ChronosProcess::get_start_time() {
     return m_start;
 }
 
-std::chrono::time_point<std::chrono::high_resolution_clock> ChronosProcess::get_stop_time() {
+long long ChronosProcess::get_stop_time() {
     return m_stop;
 }
 
-std::string ChronosProcess::get_name() {
+double ChronosProcess::get_elapsed_time() {
+    // Ticks are only converted to seconds here, never on the recording path
+    return (m_stop - m_start) * ChronosClock::get_seconds_per_tick();
+}
+
+const std::string& ChronosProcess::get_name() {
     return m_calling_function;
 }
 
-std::string ChronosProcess::get_unique_id() {
+const std::string& ChronosProcess::get_unique_id() {
     return m_unique_id;
 }
 
+double ChronosProcess::get_inclusive_time() {
+    return m_inclusive_time;
+}
+
+double ChronosProcess::get_self_time() {
+    return m_self_time;
+}
+
+double ChronosProcess::get_std_dev() {
+    if (m_total_calls <= 0){
+        return 0;
+    }// end of if
+    double variance = m_sum_squares / m_total_calls - m_mean_time * m_mean_time;
+    return variance > 0 ? std::sqrt(variance) : 0;
+}
+
+double ChronosProcess::get_sum_squares() {
+    return m_sum_squares;
+}
+
+double ChronosProcess::get_percentile(double percentile) {
+    if (m_histogram.get_count() == 0){
+        return 0;
+    }// end of if
+    // The middle of a bucket may lie outside of the exact extremes, so it is kept within them
+    double value = m_histogram.get_percentile(percentile) * 1e-9;
+    if (m_min_time <= m_max_time){
+        value = std::min(std::max(value, m_min_time), m_max_time);
+    }// end of if
+    return value;
+}
+
+ChronosHistogram& ChronosProcess::get_histogram() {
+    return m_histogram;
+}
+
+long ChronosProcess::get_thread_id() {
+    return m_thread_id;
+}
+
+long ChronosProcess::get_allocations() {
+    return m_allocations;
+}
+
+long long ChronosProcess::get_allocated_bytes() {
+    return m_allocated_bytes;
+}
+
+long long ChronosProcess::get_peak_live_bytes() {
+    return m_peak_live_bytes;
+}
+
+long ChronosProcess::get_cpu_calls() {
+    return m_cpu_calls;
+}
+
+double ChronosProcess::get_on_cpu_time() {
+    if (m_cpu_calls <= 0 || m_cpu_wall_time <= 0){
+        return 0;
+    }// end of if
+    // The calls the CPU time was read for stand in for all of them, as the timed calls do for the total time
+    double share = m_cpu_time / m_cpu_wall_time;
+    return m_total_time * (share < 1 ? share : 1);
+}
+
+double ChronosProcess::get_off_cpu_time() {
+    if (m_cpu_calls <= 0){
+        return 0;
+    }// end of if
+    return m_total_time - get_on_cpu_time();
+}
+
+double ChronosProcess::get_cpu_time() {
+    return m_cpu_time;
+}
+
+double ChronosProcess::get_cpu_wall_time() {
+    return m_cpu_wall_time;
+}
+
+long ChronosProcess::get_voluntary_switches() {
+    return m_voluntary_switches;
+}
+
+long ChronosProcess::get_involuntary_switches() {
+    return m_involuntary_switches;
+}
+
+unsigned long long ChronosProcess::get_counter(int counter) {
+    return m_counters[counter];
+}
+
+long ChronosProcess::get_counted_calls() {
+    return m_counted_calls;
+}
+
+double ChronosProcess::get_ipc() {
+    if (m_counters[ChronosCounters::k_cycles] == 0){
+        return 0;
+    }// end of if
+    return static_cast<double>(m_counters[ChronosCounters::k_instructions]) / m_counters[ChronosCounters::k_cycles];
+}
+
+double ChronosProcess::get_counter_per_call(int counter) {
+    if (m_counted_calls <= 0){
+        return 0;
+    }// end of if
+    return static_cast<double>(m_counters[counter]) / m_counted_calls;
+}
+
 
 
 //Basic Functionality
@@ -127,20 +303,97 @@ void ChronosProcess::add_time(double used_time) {
     }// end of if
     // Add time to that total time already executed
     set_total_time(get_total_time() + used_time);
+    set_sum_squares(m_sum_squares + used_time * used_time);
+    m_histogram.add_value(static_cast<unsigned long long>(used_time * 1e9));
     // Increment number of calls to the function
     set_total_calls(get_total_calls() + 1);
+    set_timed_calls(get_timed_calls() + 1);
 
     // Create the dependent variable
     set_mean_time(get_total_time() / get_total_calls());
 }
 
 
+void ChronosProcess::merge(ChronosProcess& other) {
+    // Nothing to add if the other process was never called
+    if (other.get_total_calls() <= 0){
+        return;
+    }// end of if
+    if (other.get_max_time() >= get_max_time()){
+        set_max_time(other.get_max_time());
+    }// end of if
+    if (other.get_min_time() <= get_min_time()){
+        set_min_time(other.get_min_time());
+    }// end of if
+    set_total_time(get_total_time() + other.get_total_time());
+    set_inclusive_time(get_inclusive_time() + other.get_inclusive_time());
+    set_self_time(get_self_time() + other.get_self_time());
+    set_sum_squares(m_sum_squares + other.m_sum_squares);
+    m_histogram.merge(other.get_histogram());
+    // The mean is over the calls, which a sampled total need not cover all of, so the means are weighed by their calls
+    double mean = (get_mean_time() * get_total_calls() + other.get_mean_time() * other.get_total_calls())
+                / (get_total_calls() + other.get_total_calls());
+    set_total_calls(get_total_calls() + other.get_total_calls());
+    set_timed_calls(get_timed_calls() + other.get_timed_calls());
+    for (int i = 0; i < ChronosCounters::k_counter_count; i++){
+        m_counters[i] += other.m_counters[i];
+    }// end of for
+    m_counted_calls += other.m_counted_calls;
+    m_allocations += other.m_allocations;
+    m_allocated_bytes += other.m_allocated_bytes;
+    m_peak_live_bytes = other.m_peak_live_bytes > m_peak_live_bytes ? other.m_peak_live_bytes : m_peak_live_bytes;
+    m_cpu_calls += other.m_cpu_calls;
+    m_cpu_time += other.m_cpu_time;
+    m_cpu_wall_time += other.m_cpu_wall_time;
+    m_voluntary_switches += other.m_voluntary_switches;
+    m_involuntary_switches += other.m_involuntary_switches;
+
+    // Create the dependent variable
+    set_mean_time(mean);
+}
+
+
+void ChronosProcess::subtract(ChronosProcess& earlier) {
+    double weighed = get_mean_time() * get_total_calls() - earlier.get_mean_time() * earlier.get_total_calls();
+    set_total_calls(get_total_calls() - earlier.get_total_calls());
+    set_timed_calls(get_timed_calls() - earlier.get_timed_calls());
+    set_total_time(get_total_time() - earlier.get_total_time());
+    set_inclusive_time(get_inclusive_time() - earlier.get_inclusive_time());
+    set_self_time(get_self_time() - earlier.get_self_time());
+    set_sum_squares(m_sum_squares - earlier.m_sum_squares);
+    m_histogram.subtract(earlier.get_histogram());
+    for (int i = 0; i < ChronosCounters::k_counter_count; i++){
+        m_counters[i] = m_counters[i] >= earlier.m_counters[i] ? m_counters[i] - earlier.m_counters[i] : 0;
+    }// end of for
+    m_counted_calls -= earlier.m_counted_calls;
+    // The peak is kept as it was, as the peak of the later calls alone is not known
+    m_allocations -= earlier.m_allocations;
+    m_allocated_bytes -= earlier.m_allocated_bytes;
+    m_cpu_calls -= earlier.m_cpu_calls;
+    m_cpu_time -= earlier.m_cpu_time;
+    m_cpu_wall_time -= earlier.m_cpu_wall_time;
+    m_voluntary_switches -= earlier.m_voluntary_switches;
+    m_involuntary_switches -= earlier.m_involuntary_switches;
+    if (get_total_calls() <= 0){
+        long thread_id = m_thread_id;
+        init(m_calling_function, m_unique_id);
+        set_thread_id(thread_id);
+        return;
+    }// end of if
+
+    // Create the dependent variables
+    set_mean_time(weighed / get_total_calls());
+    set_min_time(m_histogram.get_percentile(0) * 1e-9);
+    set_max_time(m_histogram.get_percentile(100) * 1e-9);
+}
+
+
 std::string ChronosProcess::to_string() {
     //Create a string to return that has all the information necessary for display
     std::string to_return;
 
     to_return = std::to_string(m_max_time)+"\t\t"+ std::to_string(m_min_time)+"\t\t"+std::to_string(m_mean_time);
-    to_return = to_return + "\t\t"+ std::to_string(m_total_calls*1.0f)+"\t\t"+std::to_string(m_total_time)+"\t\t"+m_unique_id+"\t\t"+m_calling_function;
+    to_return = to_return + "\t\t"+ std::to_string(m_total_calls*1.0f)+"\t\t"+std::to_string(m_total_time)+"\t\t"+std::to_string(m_inclusive_time)+"\t\t"+std::to_string(m_self_time)+"\t\t"+percentile_string("\t\t")+"\t\t"+counter_string("\t\t", "-")+"\t\t"+cpu_string("\t\t", "-")+"\t\t"+std::to_string(m_allocations)+"\t\t"+std::to_string(m_allocated_bytes)+"\t\t"+std::to_string(m_peak_live_bytes)+"\t\t"+std::to_string(m_timed_calls)+(is_sampled() ? " (sampled)" : "")+"\t\t"+thread_string()+"\t\t"+m_unique_id+"\t\t"+m_calling_function;
     
     return to_return;
 }
@@ -149,7 +402,7 @@ std::string ChronosProcess::to_csv() {
     std::string to_return;
     
     to_return = std::to_string(m_max_time)+","+ std::to_string(m_min_time)+","+std::to_string(m_mean_time);
-    to_return = to_return + ","+ std::to_string(m_total_calls)+","+std::to_string(m_total_time)+","+m_unique_id+","+m_calling_function;
+    to_return = to_return + ","+ std::to_string(m_total_calls)+","+std::to_string(m_total_time)+","+std::to_string(m_inclusive_time)+","+std::to_string(m_self_time)+","+percentile_string(",")+","+counter_string(",", "")+","+cpu_string(",", "")+","+std::to_string(m_allocations)+","+std::to_string(m_allocated_bytes)+","+std::to_string(m_peak_live_bytes)+","+std::to_string(m_timed_calls)+","+thread_string()+","+m_unique_id+","+m_calling_function;
 
     return to_return;
 }
@@ -159,7 +412,7 @@ std::string ChronosProcess::get_header() {
     // Create a header String to return
     std::string to_return;
 
-    to_return = "Max Time\t\tMin Time\t\tMean Time\t\tTotal Calls\t\tTotal Time\t\tHash ID\t\t\tCalling Function";
+    to_return = "Max Time\t\tMin Time\t\tMean Time\t\tTotal Calls\t\tTotal Time\t\tInclusive Time\t\tSelf Time\t\tP50 Time\t\tP90 Time\t\tP99 Time\t\tP99.9 Time\t\tStd Dev\t\t\tIPC\t\tCycles Per Call\t\tL1 Misses Per Call\t\tLLC Misses Per Call\t\tBranch Misses Per Call\t\tOn-CPU Time\t\tOff-CPU Time\t\tVoluntary Switches Per Call\t\tInvoluntary Switches Per Call\t\tAllocations\t\tAllocated Bytes\t\tPeak Live Bytes\t\tTimed Calls\t\tThread\t\tHash ID\t\t\tCalling Function";
 
     return to_return;
 }
@@ -168,7 +421,7 @@ std::string ChronosProcess::get_header_csv(){
     // Create a header string in csv to return
     std::string to_return;
 
-    to_return = "Max Time,Min Time,Mean Time,Total Calls,Total Time,Hash ID,Calling Function";
+    to_return = "Max Time,Min Time,Mean Time,Total Calls,Total Time,Inclusive Time,Self Time,P50 Time,P90 Time,P99 Time,P99.9 Time,Std Dev,IPC,Cycles Per Call,L1 Misses Per Call,LLC Misses Per Call,Branch Misses Per Call,On-CPU Time,Off-CPU Time,Voluntary Switches Per Call,Involuntary Switches Per Call,Allocations,Allocated Bytes,Peak Live Bytes,Timed Calls,Thread,Hash ID,Calling Function";
 
     return to_return;
 }
@@ -181,5 +434,60 @@ void ChronosProcess::init(std::string func_name, std::string u_id) {
     m_min_time = __DBL_MAX__;
     m_mean_time = 0;
     m_total_time = 0;
+    m_inclusive_time = 0;
+    m_self_time = 0;
+    m_sum_squares = 0;
+    m_histogram = ChronosHistogram();
     m_total_calls = 0;
+    m_timed_calls = 0;
+    m_thread_id = -1;
+    for (int i = 0; i < ChronosCounters::k_counter_count; i++){
+        m_counters[i] = 0;
+    }// end of for
+    m_counted_calls = 0;
+    m_allocations = 0;
+    m_allocated_bytes = 0;
+    m_peak_live_bytes = 0;
+    m_cpu_calls = 0;
+    m_cpu_time = 0;
+    m_cpu_wall_time = 0;
+    m_voluntary_switches = 0;
+    m_involuntary_switches = 0;
+    m_start = 0;
+    m_stop = 0;
+}
+
+std::string ChronosProcess::percentile_string(std::string separator) {
+    return std::to_string(get_percentile(50)) + separator + std::to_string(get_percentile(90)) + separator
+           + std::to_string(get_percentile(99)) + separator + std::to_string(get_percentile(99.9)) + separator
+           + std::to_string(get_std_dev());
+}
+
+std::string ChronosProcess::counter_string(std::string separator, std::string blank) {
+    if (m_counted_calls <= 0){
+        return blank + separator + blank + separator + blank + separator + blank + separator + blank;
+    }// end of if
+    return std::to_string(get_ipc()) + separator + std::to_string(get_counter_per_call(ChronosCounters::k_cycles)) + separator
+           + std::to_string(get_counter_per_call(ChronosCounters::k_l1_misses)) + separator
+           + std::to_string(get_counter_per_call(ChronosCounters::k_llc_misses)) + separator
+           + std::to_string(get_counter_per_call(ChronosCounters::k_branch_misses));
+}
+
+std::string ChronosProcess::cpu_string(std::string separator, std::string blank) {
+    if (m_cpu_calls <= 0){
+        return blank + separator + blank + separator + blank + separator + blank;
+    }// end of if
+    return std::to_string(get_on_cpu_time()) + separator + std::to_string(get_off_cpu_time()) + separator
+           + std::to_string(static_cast<double>(m_voluntary_switches) / m_cpu_calls) + separator
+           + std::to_string(static_cast<double>(m_involuntary_switches) / m_cpu_calls);
+}
+
+std::string ChronosProcess::thread_string() {
+    if (m_thread_id == k_benchmark_thread){
+        return "Benchmark";
+    }// end of if
+    if (m_thread_id < 0){
+        return "All";
+    }// end of if
+    return std::to_string(m_thread_id);
 }
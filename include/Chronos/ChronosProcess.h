@@ -30,6 +30,10 @@
 #include <string>
 #include <chrono>
 
+#include "ChronosClock.h"
+#include "ChronosHistogram.h"
+#include "ChronosCounters.h"
+
 class ChronosProcess  {
 	public:
 		//ctors and dtors
@@ -78,24 +82,91 @@ class ChronosProcess  {
 		 * @param value 
 		 */
 		void set_total_calls(double value);
+		/**
+		 * @brief Set the timed calls object
+		 * 
+		 * @param value the number of calls that were timed, lower than the total calls for sampled functions
+		 */
+		void set_timed_calls(long value);
 		/**
 		 * @brief Set the start time object
 		 * 
-		 * @param value A value obtained from the std::chrono library
+		 * @param value A value in ticks obtained from ChronosClock
 		 */
-		void set_start_time(std::chrono::time_point<std::chrono::high_resolution_clock> value);
+		void set_start_time(long long value);
 		/**
 		 * @brief Set the stop time object
 		 * 
-		 * @param value A value obtained from the std::chrono library
+		 * @param value A value in ticks obtained from ChronosClock
+		 */
+		void set_stop_time(long long value);
+		/**
+		 * @brief Set the name object
+		 * 
+		 * @param value 
 		 */
-		void set_stop_time(std::chrono::time_point<std::chrono::high_resolution_clock> value);
+		void set_name(std::string value);
 		/**
 		 * @brief Set the unique id object
 		 * 
 		 * @param value 
 		 */
 		void set_unique_id(std::string value);
+		/**
+		 * @brief Set the inclusive time object
+		 * 
+		 * @param value the time spent in the function and its callees, with recursive calls counted once
+		 */
+		void set_inclusive_time(double value);
+		/**
+		 * @brief Set the self time object
+		 * 
+		 * @param value the time spent in the function itself, excluding its callees
+		 */
+		void set_self_time(double value);
+		/**
+		 * @brief Set the sum squares object
+		 * 
+		 * @param value the sum of the squared call durations, in seconds squared
+		 */
+		void set_sum_squares(double value);
+		/**
+		 * @brief Set the histogram object
+		 * 
+		 * @param value the call durations, in nanoseconds
+		 */
+		void set_histogram(const ChronosHistogram& value);
+		/**
+		 * @brief Set the thread id object
+		 * 
+		 * @param value the index of the recording thread, or -1 for data merged over all threads
+		 */
+		void set_thread_id(long value);
+		/**
+		 * @brief Set the hardware counters object
+		 * 
+		 * @param values the totals of the ChronosCounters counters, indexed by its k_ constants
+		 * @param counted the number of calls the counters were read for
+		 */
+		void set_counters(const unsigned long long* values, long counted);
+		/**
+		 * @brief Set the allocations object
+		 * 
+		 * @param count the allocations made by the function itself
+		 * @param bytes the bytes asked for by those allocations
+		 * @param peak_live_bytes the most bytes in use during one call, callees included
+		 */
+		void set_allocations(long count, long long bytes, long long peak_live_bytes);
+		/**
+		 * @brief Set the CPU time object
+		 * 
+		 * @param calls the number of calls the thread's CPU time was read for
+		 * @param cpu_time the CPU time of those calls, in seconds
+		 * @param wall_time the wall time of those calls, in seconds
+		 * @param voluntary the context switches made by those calls while waiting
+		 * @param involuntary the context switches forced on those calls by the scheduler
+		 */
+		void set_cpu_time(long calls, double cpu_time, double wall_time, long voluntary, long involuntary);
 		
 		//Getters
 		/**
@@ -128,30 +199,179 @@ class ChronosProcess  {
 		 * @return double 
 		 */
 		double get_total_calls();
+		/**
+		 * @brief Get the timed calls object
+		 * 
+		 * @return long 
+		 */
+		long get_timed_calls();
+		/**
+		 * @brief Whether only some of the calls were timed, and the times are extrapolated
+		 * 
+		 * @return true 
+		 * @return false 
+		 */
+		bool is_sampled();
 		/**
 		 * @brief Get the start time object
 		 * 
-		 * @return std::chrono::time_point<std::chrono::high_resolution_clock> 
+		 * @return long long the start in ChronosClock ticks
 		 */
-		std::chrono::time_point<std::chrono::high_resolution_clock> get_start_time();
+		long long get_start_time();
 		/**
 		 * @brief Get the stop time object
 		 * 
-		 * @return std::chrono::time_point<std::chrono::high_resolution_clock> 
+		 * @return long long the stop in ChronosClock ticks
 		 */
-		std::chrono::time_point<std::chrono::high_resolution_clock> get_stop_time();
+		long long get_stop_time();
+		/**
+		 * @brief Get the time between the start and the stop, converted to seconds
+		 * 
+		 * @return double 
+		 */
+		double get_elapsed_time();
 		/**
 		 * @brief Get the name object
 		 * 
-		 * @return std::string 
+		 * @return const std::string& 
 		 */
-		std::string get_name();
+		const std::string& get_name();
 		/**
 		 * @brief Get the unique id object
 		 * 
-		 * @return std::string 
+		 * @return const std::string& 
+		 */
+		const std::string& get_unique_id();
+		/**
+		 * @brief Get the inclusive time object
+		 * 
+		 * @return double 
+		 */
+		double get_inclusive_time();
+		/**
+		 * @brief Get the self time object
+		 * 
+		 * @return double 
+		 */
+		double get_self_time();
+		/**
+		 * @brief Get the standard deviation of the call durations
+		 * 
+		 * @return double 
+		 */
+		double get_std_dev();
+		/**
+		 * @brief Get the sum squares object
+		 * 
+		 * @return double the sum of the squared call durations
+		 */
+		double get_sum_squares();
+		/**
+		 * @brief Get a percentile of the call durations, from the histogram
+		 * 
+		 * @param percentile between 0 and 100
+		 * @return double the duration in seconds, within about 3%
+		 */
+		double get_percentile(double percentile);
+		/**
+		 * @brief Get the histogram object
+		 * 
+		 * @return ChronosHistogram& the call durations, in nanoseconds
+		 */
+		ChronosHistogram& get_histogram();
+		/**
+		 * @brief Get the thread id object
+		 * 
+		 * @return long the index of the recording thread, or -1 for data merged over all threads
+		 */
+		long get_thread_id();
+		/**
+		 * @brief Get the total of a hardware counter
+		 * 
+		 * @param counter one of the ChronosCounters k_ constants
+		 * @return unsigned long long 
+		 */
+		unsigned long long get_counter(int counter);
+		/**
+		 * @brief Get the counted calls object
+		 * 
+		 * @return long the number of calls the hardware counters were read for
+		 */
+		long get_counted_calls();
+		/**
+		 * @brief Get the instructions per cycle
+		 * 
+		 * @return double 0 without counters
+		 */
+		double get_ipc();
+		/**
+		 * @brief Get the average of a hardware counter per counted call
+		 * 
+		 * @param counter one of the ChronosCounters k_ constants
+		 * @return double 0 without counters
+		 */
+		double get_counter_per_call(int counter);
+		/**
+		 * @brief Get the allocations object
+		 * 
+		 * @return long the allocations made by the function itself
+		 */
+		long get_allocations();
+		/**
+		 * @brief Get the allocated bytes object
+		 * 
+		 * @return long long the bytes asked for by the function itself
+		 */
+		long long get_allocated_bytes();
+		/**
+		 * @brief Get the peak live bytes object
+		 * 
+		 * @return long long the most bytes in use during one call, callees included
+		 */
+		long long get_peak_live_bytes();
+		/**
+		 * @brief Get the cpu calls object
+		 * 
+		 * @return long the number of calls the thread's CPU time was read for
+		 */
+		long get_cpu_calls();
+		/**
+		 * @brief Get the share of the total time the function spent on the CPU, as measured over the calls the CPU time was
+		 *          read for
+		 * 
+		 * @return double seconds, 0 without CPU times
 		 */
-		std::string get_unique_id();
+		double get_on_cpu_time();
+		/**
+		 * @brief Get the share of the total time the function spent off the CPU: waiting on I/O, on locks or for the scheduler
+		 * 
+		 * @return double seconds, 0 without CPU times
+		 */
+		double get_off_cpu_time();
+		/**
+		 * @brief Get the cpu time object
+		 * 
+		 * @return double seconds on the CPU, over the calls the CPU time was read for
+		 */
+		double get_cpu_time();
+		/**
+		 * @brief Get the cpu wall time object
+		 * 
+		 * @return double wall seconds of the calls the CPU time was read for
+		 */
+		double get_cpu_wall_time();
+		/**
+		 * @brief Get the voluntary switches object
+		 * 
+		 * @return long the context switches made while waiting, over the calls the CPU time was read for
+		 */
+		long get_voluntary_switches();
+		/**
+		 * @brief Get the involuntary switches object
+		 * 
+		 * @return long the context switches forced by the scheduler, over the calls the CPU time was read for
+		 */
+		long get_involuntary_switches();
 		
 		//Basic Operation
 		/**
@@ -160,6 +380,19 @@ class ChronosProcess  {
 		 * @param used_time 
 		 */
 		void add_time(double used_time);
+		/**
+		 * @brief Folds the statistics of another process into this one, as if all its calls had been added through add_time.
+		 * 
+		 * @param other 
+		 */
+		void merge(ChronosProcess& other);
+		/**
+		 * @brief Removes the statistics of an earlier snapshot of the same function, leaving those of the calls made since.
+		 *          The max and min time can not be subtracted, so they are taken from the histogram of the remaining calls.
+		 * 
+		 * @param earlier 
+		 */
+		void subtract(ChronosProcess& earlier);
 		/**
 		 * @brief Converts the function data into a format suitable for human processing
 		 * 
@@ -185,10 +418,19 @@ class ChronosProcess  {
 		 */
 		std::string get_header_csv();
 
+		static const long k_benchmark_thread = -2;								// Thread id of the results of Chronos::benchmark
 
 	private: 
 		// Function that calculates
 		void init(std::string func_name = "None", std::string u_id = "0000");
+		// Formats the percentiles and deviation for the reports
+		std::string percentile_string(std::string separator);
+		// Formats the thread id for the reports
+		std::string thread_string();
+		// Formats the hardware counters for the reports, or leaves the columns blank without them
+		std::string counter_string(std::string separator, std::string blank);
+		// Formats the on and off CPU times for the reports, or leaves the columns blank without them
+		std::string cpu_string(std::string separator, std::string blank);
 		
 		//Member variables useful for aggregation
 		std::string m_calling_function;											// Stores the calling function name
@@ -197,7 +439,23 @@ class ChronosProcess  {
 		double m_min_time;														// Min time the function was called
 		double m_mean_time; 													// Average call duration for the function
 		double m_total_time;													// Total time spent on this function
-		std::chrono::time_point<std::chrono::high_resolution_clock> m_start; 	// Saves the processes' start time
-		std::chrono::time_point<std::chrono::high_resolution_clock> m_stop;  	// Saves the processes' stop time
+		double m_inclusive_time;												// Time spent in the function and its callees, from the call tree
+		double m_self_time;														// Time spent in the function itself, from the call tree
+		double m_sum_squares;													// Sum of the squared call durations, for the deviation
+		ChronosHistogram m_histogram;											// Call durations in nanoseconds
+		long long m_start; 														// Saves the processes' start time in clock ticks
+		long long m_stop;  														// Saves the processes' stop time in clock ticks
 		long m_total_calls;														// Saves the total number of calls to the function
+		long m_timed_calls;														// Number of calls that were timed, the rest are extrapolated
+		long m_thread_id;														// Index of the recording thread, -1 for all threads
+		unsigned long long m_counters[ChronosCounters::k_counter_count];		// Hardware counter totals
+		long m_counted_calls;													// Calls the hardware counters were read for
+		long m_allocations;														// Allocations made by the function itself
+		long long m_allocated_bytes;											// Bytes asked for by those allocations
+		long long m_peak_live_bytes;											// Most bytes in use during one call
+		long m_cpu_calls;														// Calls the thread's CPU time was read for
+		double m_cpu_time;														// CPU time of those calls, in seconds
+		double m_cpu_wall_time;													// Wall time of those calls, in seconds
+		long m_voluntary_switches;												// Context switches made by those calls while waiting
+		long m_involuntary_switches;											// Context switches forced on those calls
 };
\ No newline at end of file
@@ -0,0 +1,306 @@
+/**   Copyright 2020 Benrick Smit
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ * 
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+*/
+
+/**
+ * @author: Benrick Smit
+ * @email: metatronicprogramming@hotmail.com
+ * @date: 13 June 2020
+ * @modified: 13 June 2020
+ * 
+ * @brief: This class reads a profile written by ChronosProfileWriter, and converts it to the text reports.
+ * 
+ */ 
+
+
+#include "ChronosProfileReader.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+
+//Ctors and Dtors
+ChronosProfileReader::ChronosProfileReader() {
+    m_file = -1;
+    m_map = nullptr;
+    m_size = 0;
+    m_header = nullptr;
+    m_records = nullptr;
+    m_extras = nullptr;
+    m_buckets = nullptr;
+    m_strings = nullptr;
+    m_record_count = 0;
+}
+
+ChronosProfileReader::~ChronosProfileReader() {
+    close();
+}
+
+//Basic Functionality
+bool ChronosProfileReader::open(std::string path) {
+    close();
+    m_file = ::open(path.c_str(), O_RDONLY);
+    if (m_file < 0){
+        std::string error_string = "Error reading file from: \"" + path + "\"";
+        perror(error_string.c_str());
+        return false;
+    }// end of if
+    struct stat status;
+    if (fstat(m_file, &status) != 0 || static_cast<unsigned long>(status.st_size) < sizeof(ChronosProfileHeader)){
+        close();
+        return false;
+    }// end of if
+    m_size = static_cast<unsigned long>(status.st_size);
+    void* map = mmap(nullptr, m_size, PROT_READ, MAP_SHARED, m_file, 0);
+    if (map == MAP_FAILED){
+        m_map = nullptr;
+        close();
+        return false;
+    }// end of if
+    m_map = static_cast<const char*>(map);
+    m_header = reinterpret_cast<const ChronosProfileHeader*>(m_map);
+    if (std::memcmp(m_header->magic, "CHRPROFL", 8) != 0 || m_header->version != k_profile_version
+        || m_header->record_size != sizeof(ChronosProfileRecord) || m_header->extra_size != sizeof(ChronosProfileExtra)
+        || m_header->counter_count != static_cast<std::uint32_t>(ChronosCounters::k_counter_count)){
+        close();
+        return false;
+    }// end of if
+
+    // Every part must lie within the file, and every record within the parts, so the getters need no checks
+    auto fits = [this](std::uint64_t offset, std::uint64_t count, std::uint64_t size){
+        return offset <= m_size && count <= (m_size - offset) / size;
+    };
+    const ChronosProfileHeader& header = *m_header;
+    auto in_strings = [&header](std::uint64_t offset, std::uint64_t length){
+        return offset <= header.strings_size && length <= header.strings_size - offset;
+    };
+    bool valid = fits(header.records_offset, header.record_count, sizeof(ChronosProfileRecord))
+        && fits(header.extras_offset, header.extra_count, sizeof(ChronosProfileExtra))
+        && fits(header.buckets_offset, header.bucket_count, sizeof(std::uint64_t))
+        && fits(header.strings_offset, header.strings_size, 1)
+        && header.records_offset % 8 == 0 && header.extras_offset % 8 == 0 && header.buckets_offset % 8 == 0
+        && in_strings(header.preamble_offset, header.preamble_length)
+        && in_strings(header.notes_offset, header.notes_length)
+        && in_strings(header.trailer_offset, header.trailer_length);
+    if (!valid){
+        close();
+        return false;
+    }// end of if
+    m_records = reinterpret_cast<const ChronosProfileRecord*>(m_map + header.records_offset);
+    m_extras = reinterpret_cast<const ChronosProfileExtra*>(m_map + header.extras_offset);
+    m_buckets = reinterpret_cast<const std::uint64_t*>(m_map + header.buckets_offset);
+    m_strings = m_map + header.strings_offset;
+    for (std::uint64_t i = 0; valid && i < header.record_count; i++){
+        const ChronosProfileRecord& record = m_records[i];
+        valid = in_strings(record.name_offset, record.name_length)
+            && in_strings(record.id_offset, record.id_length)
+            && (record.extra == k_profile_no_extra || record.extra < header.extra_count)
+            && record.first_bucket <= header.bucket_count && record.bucket_count <= header.bucket_count - record.first_bucket;
+        for (std::uint64_t bucket = 0; valid && bucket < record.bucket_count; bucket++){
+            valid = (m_buckets[record.first_bucket + bucket] & ((1 << k_profile_bucket_bits) - 1)) < ChronosHistogram::k_bucket_count;
+        }// end of for
+    }// end of for
+    if (!valid){
+        close();
+        return false;
+    }// end of if
+    m_record_count = static_cast<long>(header.record_count);
+    return true;
+}
+
+void ChronosProfileReader::close() {
+    if (m_map != nullptr){
+        munmap(const_cast<char*>(m_map), m_size);
+    }// end of if
+    if (m_file >= 0){
+        ::close(m_file);
+    }// end of if
+    m_file = -1;
+    m_map = nullptr;
+    m_size = 0;
+    m_header = nullptr;
+    m_records = nullptr;
+    m_extras = nullptr;
+    m_buckets = nullptr;
+    m_strings = nullptr;
+    m_record_count = 0;
+}
+
+bool ChronosProfileReader::is_profile(std::string path) {
+    char magic[8];
+    FILE* file = fopen(path.c_str(), "rb");
+    if (file == nullptr){
+        return false;
+    }// end of if
+    bool found = fread(magic, 1, sizeof(magic), file) == sizeof(magic) && std::memcmp(magic, "CHRPROFL", 8) == 0;
+    fclose(file);
+    return found;
+}
+
+//Getters
+long ChronosProfileReader::get_record_count() {
+    return m_record_count;
+}
+
+const ChronosProfileRecord& ChronosProfileReader::get_record(long index) {
+    return m_records[index];
+}
+
+const ChronosProfileExtra* ChronosProfileReader::get_extra(long index) {
+    return m_records[index].extra == k_profile_no_extra ? nullptr : m_extras + m_records[index].extra;
+}
+
+std::string_view ChronosProfileReader::get_name(long index) {
+    return std::string_view(m_strings + m_records[index].name_offset, m_records[index].name_length);
+}
+
+std::string_view ChronosProfileReader::get_unique_id(long index) {
+    return std::string_view(m_strings + m_records[index].id_offset, m_records[index].id_length);
+}
+
+unsigned long long ChronosProfileReader::get_bucket(long index, long bucket) {
+    // The buckets of a record are in the order of their index, which is in their lowest bits
+    const std::uint64_t mask = (1 << k_profile_bucket_bits) - 1;
+    const std::uint64_t* begin = m_buckets + m_records[index].first_bucket;
+    const std::uint64_t* end = begin + m_records[index].bucket_count;
+    while (begin < end){
+        const std::uint64_t* middle = begin + (end - begin) / 2;
+        long middle_index = static_cast<long>(*middle & mask);
+        if (middle_index == bucket){
+            return *middle >> k_profile_bucket_bits;
+        }else if (middle_index < bucket){
+            begin = middle + 1;
+        }else{
+            end = middle;
+        }// end of if else
+    }// end of while
+    return 0;
+}
+
+ChronosProcess ChronosProfileReader::get_process(long index) {
+    const ChronosProfileRecord& record = m_records[index];
+    ChronosProcess process(std::string(get_name(index)), std::string(get_unique_id(index)));
+    process.set_thread_id(record.thread_id);
+    process.set_total_calls(record.total_calls);
+    process.set_timed_calls(record.timed_calls);
+    process.set_max_time(record.max_time);
+    process.set_min_time(record.min_time);
+    process.set_mean_time(record.mean_time);
+    process.set_total_time(record.total_time);
+    process.set_inclusive_time(record.inclusive_time);
+    process.set_self_time(record.self_time);
+    process.set_sum_squares(record.sum_squares);
+    const ChronosProfileExtra* extra = get_extra(index);
+    if (extra != nullptr){
+        unsigned long long counters[ChronosCounters::k_counter_count];
+        for (int counter = 0; counter < ChronosCounters::k_counter_count; counter++){
+            counters[counter] = extra->counters[counter];
+        }// end of for
+        process.set_counters(counters, extra->counted_calls);
+        process.set_allocations(extra->allocations, extra->allocated_bytes, extra->peak_live_bytes);
+        process.set_cpu_time(extra->cpu_calls, extra->cpu_time, extra->cpu_wall_time, extra->voluntary_switches, extra->involuntary_switches);
+    }// end of if
+    ChronosHistogram histogram;
+    for (std::uint64_t bucket = 0; bucket < record.bucket_count; bucket++){
+        std::uint64_t packed = m_buckets[record.first_bucket + bucket];
+        histogram.add(static_cast<long>(packed & ((1 << k_profile_bucket_bits) - 1)), packed >> k_profile_bucket_bits);
+    }// end of for
+    process.set_histogram(histogram);
+    return process;
+}
+
+long ChronosProfileReader::get_thread_count() {
+    return m_header == nullptr ? 0 : static_cast<long>(m_header->thread_count);
+}
+
+std::string_view ChronosProfileReader::get_preamble() {
+    return m_header == nullptr ? std::string_view() : get_text(m_header->preamble_offset, m_header->preamble_length);
+}
+
+std::string_view ChronosProfileReader::get_text(unsigned long long offset, unsigned long long length) {
+    return std::string_view(m_strings + offset, length);
+}
+
+//Exporters
+bool ChronosProfileReader::write_csv(std::string csv_path) {
+    std::ofstream csv_file(csv_path.c_str(), std::ios::out);
+    if (!csv_file.is_open()){
+        std::string error_string = "Error writing file to: \"" + csv_path+"\"";
+        perror(error_string.c_str());
+        return false;
+    }// end of if
+    ChronosProcess cp;
+    csv_file << cp.get_header_csv() << '\n';
+    // The records are stored in the order of the report's rows
+    for (long i = 0; i < m_record_count; i++){
+        csv_file << get_process(i).to_csv() << '\n';
+    }// end of for
+    return csv_file.good();
+}
+
+bool ChronosProfileReader::write_txt(std::string txt_path) {
+    std::ofstream txt_file(txt_path.c_str(), std::ios::out);
+    if (!txt_file.is_open()){
+        std::string error_string = "Error writing file to: \"" + txt_path+"\"";
+        perror(error_string.c_str());
+        return false;
+    }// end of if
+    ChronosProcess cp;
+    std::string header = cp.get_header();
+    txt_file << get_preamble() << '\n' << header << '\n';
+    // The records come merged over the threads first, then thread by thread, then the benchmarks
+    long index = 0;
+    while (index < m_record_count && m_records[index].thread_id == -1){
+        txt_file << get_process(index++).to_string() << '\n';
+    }// end of while
+    for (long thread_id = 0; thread_id < get_thread_count(); thread_id++){
+        txt_file << "\nThread " << thread_id << '\n' << header << '\n';
+        while (index < m_record_count && m_records[index].thread_id == thread_id){
+            txt_file << get_process(index++).to_string() << '\n';
+        }// end of while
+    }// end of for
+    if (index < m_record_count && m_records[index].thread_id == ChronosProcess::k_benchmark_thread){
+        txt_file << "\nBenchmarks\n" << header << '\n';
+        while (index < m_record_count && m_records[index].thread_id == ChronosProcess::k_benchmark_thread){
+            txt_file << get_process(index++).to_string() << '\n';
+        }// end of while
+        txt_file << '\n' << get_text(m_header->notes_offset, m_header->notes_length);
+    }// end of if
+    txt_file << get_text(m_header->trailer_offset, m_header->trailer_length);
+    return txt_file.good();
+}
+
+bool ChronosProfileReader::write_histograms(std::string histogram_path) {
+    std::ofstream histogram_file(histogram_path.c_str(), std::ios::out);
+    if (!histogram_file.is_open()){
+        std::string error_string = "Error writing file to: \"" + histogram_path+"\"";
+        perror(error_string.c_str());
+        return false;
+    }// end of if
+    histogram_file << "Total Calls,Buckets,Calling Function\n";
+    for (long i = 0; i < m_record_count; i++){
+        if (m_records[i].thread_id != -1){
+            continue;
+        }// end of if
+        ChronosProcess process = get_process(i);
+        histogram_file << process.get_total_calls() << ',' << process.get_histogram().serialize() << ',' << process.get_name() << '\n';
+    }// end of for
+    return histogram_file.good();
+}
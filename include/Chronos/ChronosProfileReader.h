@@ -0,0 +1,176 @@
+/**   Copyright 2020 Benrick Smit
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ * 
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+*/
+/**
+ * @author: Benrick Smit
+ * @email: metatronicprogramming@hotmail.com
+ * @date: 13 June 2020
+ * @modified: 13 June 2020
+ * 
+ * @brief: This class reads a profile written by ChronosProfileWriter, by mapping it into memory. The records are read in
+ *          place, and can be turned back into ChronosProcess objects, or converted to the ChronosProfile.csv,
+ *          ChronosProfile.txt and ChronosHistograms.csv reports, in the same layouts as Chronos::friendly_stop writes them.
+ * 
+ */ 
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+#include "ChronosProcess.h"
+#include "ChronosProfileWriter.h"
+
+class ChronosProfileReader {
+	public:
+		//ctors and dtors
+		/**
+		 * @brief Construct a new Chronos Profile Reader object, which holds nothing until opened
+		 * 
+		 */
+		ChronosProfileReader();
+		/**
+		 * @brief Destroy the Chronos Profile Reader object, and unmap the file
+		 * 
+		 */
+		~ChronosProfileReader();
+
+		ChronosProfileReader(const ChronosProfileReader&) = delete;
+		ChronosProfileReader& operator=(const ChronosProfileReader&) = delete;
+
+		//Basic Operation
+		/**
+		 * @brief Maps a profile, and checks that every record, bucket and string lies within it
+		 * 
+		 * @param path 
+		 * @return true if the file is a readable profile
+		 */
+		bool open(std::string path);
+		/**
+		 * @brief Unmaps the file
+		 * 
+		 */
+		void close();
+		/**
+		 * @brief Tells whether a file starts like a profile, without mapping it
+		 * 
+		 * @param path 
+		 * @return true 
+		 * @return false 
+		 */
+		static bool is_profile(std::string path);
+
+		//Getters
+		/**
+		 * @brief Get the record count object
+		 * 
+		 * @return long 
+		 */
+		long get_record_count();
+		/**
+		 * @brief Get the statistics of a function, as they are stored
+		 * 
+		 * @param index below get_record_count()
+		 * @return const ChronosProfileRecord& 
+		 */
+		const ChronosProfileRecord& get_record(long index);
+		/**
+		 * @brief Get the hardware counters, allocations and CPU times of a function
+		 * 
+		 * @param index below get_record_count()
+		 * @return const ChronosProfileExtra* nullptr when the function has none
+		 */
+		const ChronosProfileExtra* get_extra(long index);
+		/**
+		 * @brief Get the name of a function
+		 * 
+		 * @param index below get_record_count()
+		 * @return std::string_view into the mapped file
+		 */
+		std::string_view get_name(long index);
+		/**
+		 * @brief Get the hash id of a function
+		 * 
+		 * @param index below get_record_count()
+		 * @return std::string_view into the mapped file
+		 */
+		std::string_view get_unique_id(long index);
+		/**
+		 * @brief Get the count of a bucket of a function's histogram
+		 * 
+		 * @param index below get_record_count()
+		 * @param bucket below ChronosHistogram::k_bucket_count
+		 * @return unsigned long long 
+		 */
+		unsigned long long get_bucket(long index, long bucket);
+		/**
+		 * @brief Get a function as a ChronosProcess, histogram and all
+		 * 
+		 * @param index below get_record_count()
+		 * @return ChronosProcess 
+		 */
+		ChronosProcess get_process(long index);
+		/**
+		 * @brief Get the thread count object
+		 * 
+		 * @return long the threads which have a section in the .txt report
+		 */
+		long get_thread_count();
+		/**
+		 * @brief Get the lines above the table of the .txt report: the clock, the overhead and the like
+		 * 
+		 * @return std::string_view 
+		 */
+		std::string_view get_preamble();
+
+		//Exporters
+		/**
+		 * @brief Writes the records in the layout of ChronosProfile.csv
+		 * 
+		 * @param csv_path 
+		 * @return true if the file was written
+		 */
+		bool write_csv(std::string csv_path);
+		/**
+		 * @brief Writes the records in the layout of ChronosProfile.txt: the functions merged over the threads, a section for
+		 *          every thread, the benchmarks, and the sections stored with them
+		 * 
+		 * @param txt_path 
+		 * @return true if the file was written
+		 */
+		bool write_txt(std::string txt_path);
+		/**
+		 * @brief Writes the histograms of the functions merged over the threads, in the layout of ChronosHistograms.csv
+		 * 
+		 * @param histogram_path 
+		 * @return true if the file was written
+		 */
+		bool write_histograms(std::string histogram_path);
+
+	private:
+		// Get a text block of the string table
+		std::string_view get_text(unsigned long long offset, unsigned long long length);
+
+		//Member variables
+		int m_file;																// Descriptor of the profile, -1 when closed
+		const char* m_map;														// The mapped file
+		unsigned long m_size;													// Bytes mapped
+		const ChronosProfileHeader* m_header;									// Start of the file
+		const ChronosProfileRecord* m_records;									// Functions following the header
+		const ChronosProfileExtra* m_extras;									// Statistics following the records
+		const std::uint64_t* m_buckets;											// Histogram buckets following the extras
+		const char* m_strings;													// String table following the buckets
+		long m_record_count;													// Functions in the file
+};
@@ -0,0 +1,242 @@
+/**   Copyright 2020 Benrick Smit
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ * 
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+*/
+
+/**
+ * @author: Benrick Smit
+ * @email: metatronicprogramming@hotmail.com
+ * @date: 13 June 2020
+ * @modified: 13 June 2020
+ * 
+ * @brief: This class writes a profile in the compact binary format of the Chronos profiler.
+ * 
+ */ 
+
+
+#include "ChronosProfileWriter.h"
+
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <string_view>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+
+//Ctors and Dtors
+ChronosProfileWriter::ChronosProfileWriter() {
+    m_thread_count = 0;
+    m_extra_count = 0;
+    m_bucket_count = 0;
+}
+
+//Setters
+void ChronosProfileWriter::set_preamble(const std::string& value) {
+    m_preamble = value;
+}
+
+void ChronosProfileWriter::set_notes(const std::string& value) {
+    m_notes = value;
+}
+
+void ChronosProfileWriter::set_trailer(const std::string& value) {
+    m_trailer = value;
+}
+
+void ChronosProfileWriter::set_thread_count(long value) {
+    m_thread_count = value;
+}
+
+//Basic Functionality
+void ChronosProfileWriter::add(std::vector<ChronosProcess>& processes) {
+    m_processes.reserve(m_processes.size() + processes.size());
+    for (ChronosProcess& process: processes){
+        m_processes.push_back(&process);
+    }// end of for
+}
+
+void ChronosProfileWriter::add(ChronosProcess& process) {
+    m_processes.push_back(&process);
+}
+
+bool ChronosProfileWriter::write(std::string path) {
+    // Work out where everything goes, so the file can be sized once
+    std::uint64_t strings_size = place_strings();
+    std::uint64_t records_offset = sizeof(ChronosProfileHeader);
+    std::uint64_t extras_offset = records_offset + m_processes.size() * sizeof(ChronosProfileRecord);
+    std::uint64_t buckets_offset = extras_offset + m_extra_count * sizeof(ChronosProfileExtra);
+    std::uint64_t strings_offset = buckets_offset + m_bucket_count * sizeof(std::uint64_t);
+    std::uint64_t size = strings_offset + strings_size;
+
+    std::string error_string = "Error writing file to: \"" + path + "\"";
+    int file = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (file < 0){
+        perror(error_string.c_str());
+        return false;
+    }// end of if
+    if (ftruncate(file, static_cast<off_t>(size)) != 0){
+        perror(error_string.c_str());
+        ::close(file);
+        return false;
+    }// end of if
+    void* map = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, file, 0);
+    if (map == MAP_FAILED){
+        perror(error_string.c_str());
+        ::close(file);
+        return false;
+    }// end of if
+    // The file starts out zeroed, so only the fields in use are written
+    char* bytes = static_cast<char*>(map);
+    ChronosProfileHeader* header = reinterpret_cast<ChronosProfileHeader*>(bytes);
+    ChronosProfileRecord* records = reinterpret_cast<ChronosProfileRecord*>(bytes + records_offset);
+    ChronosProfileExtra* extras = reinterpret_cast<ChronosProfileExtra*>(bytes + extras_offset);
+    std::uint64_t* buckets = reinterpret_cast<std::uint64_t*>(bytes + buckets_offset);
+    char* strings = bytes + strings_offset;
+
+    std::memcpy(header->magic, "CHRPROFL", 8);
+    header->version = k_profile_version;
+    header->record_size = sizeof(ChronosProfileRecord);
+    header->extra_size = sizeof(ChronosProfileExtra);
+    header->counter_count = ChronosCounters::k_counter_count;
+    header->thread_count = static_cast<std::uint64_t>(m_thread_count);
+    header->record_count = m_processes.size();
+    header->records_offset = records_offset;
+    header->extra_count = m_extra_count;
+    header->extras_offset = extras_offset;
+    header->bucket_count = m_bucket_count;
+    header->buckets_offset = buckets_offset;
+    header->strings_size = strings_size;
+    header->strings_offset = strings_offset;
+    // The text blocks lead the string table
+    header->preamble_offset = 0;
+    header->preamble_length = m_preamble.size();
+    header->notes_offset = header->preamble_length;
+    header->notes_length = m_notes.size();
+    header->trailer_offset = header->notes_offset + header->notes_length;
+    header->trailer_length = m_trailer.size();
+    std::memcpy(strings + header->preamble_offset, m_preamble.data(), m_preamble.size());
+    std::memcpy(strings + header->notes_offset, m_notes.data(), m_notes.size());
+    std::memcpy(strings + header->trailer_offset, m_trailer.data(), m_trailer.size());
+
+    std::uint64_t extra = 0;
+    std::uint64_t bucket = 0;
+    for (unsigned long i = 0; i < m_processes.size(); i++){
+        ChronosProcess& process = *m_processes[i];
+        ChronosProfileRecord& record = records[i];
+        const std::string& name = process.get_name();
+        const std::string& id = process.get_unique_id();
+        // A name which repeats is copied over itself, which is cheaper than remembering that it was written
+        record.name_offset = m_offsets[2 * i];
+        record.name_length = static_cast<std::uint32_t>(name.size());
+        std::memcpy(strings + record.name_offset, name.data(), name.size());
+        record.id_offset = m_offsets[2 * i + 1];
+        record.id_length = static_cast<std::uint32_t>(id.size());
+        std::memcpy(strings + record.id_offset, id.data(), id.size());
+
+        record.thread_id = process.get_thread_id();
+        record.total_calls = static_cast<std::int64_t>(process.get_total_calls());
+        record.timed_calls = process.get_timed_calls();
+        record.max_time = process.get_max_time();
+        record.min_time = process.get_min_time();
+        record.mean_time = process.get_mean_time();
+        record.total_time = process.get_total_time();
+        record.inclusive_time = process.get_inclusive_time();
+        record.self_time = process.get_self_time();
+        record.sum_squares = process.get_sum_squares();
+        // The counters, allocations and CPU times only take space when the function has them
+        record.extra = k_profile_no_extra;
+        if (has_extra(process)){
+            record.extra = static_cast<std::uint32_t>(extra);
+            ChronosProfileExtra& details = extras[extra++];
+            for (int counter = 0; counter < ChronosCounters::k_counter_count; counter++){
+                details.counters[counter] = process.get_counter(counter);
+            }// end of for
+            details.counted_calls = process.get_counted_calls();
+            details.allocations = process.get_allocations();
+            details.allocated_bytes = process.get_allocated_bytes();
+            details.peak_live_bytes = process.get_peak_live_bytes();
+            details.cpu_calls = process.get_cpu_calls();
+            details.cpu_time = process.get_cpu_time();
+            details.cpu_wall_time = process.get_cpu_wall_time();
+            details.voluntary_switches = process.get_voluntary_switches();
+            details.involuntary_switches = process.get_involuntary_switches();
+        }// end of if
+
+        record.first_bucket = bucket;
+        const unsigned long long* counts = process.get_histogram().get_buckets();
+        for (long index = 0; counts != nullptr && index < ChronosHistogram::k_bucket_count; index++){
+            if (counts[index] != 0){
+                buckets[bucket++] = (static_cast<std::uint64_t>(counts[index]) << k_profile_bucket_bits) | static_cast<std::uint64_t>(index);
+            }// end of if
+        }// end of for
+        record.bucket_count = bucket - record.first_bucket;
+    }// end of for
+
+    bool written = munmap(map, size) == 0;
+    written = ::close(file) == 0 && written;
+    if (!written){
+        perror(error_string.c_str());
+    }// end of if
+    return written;
+}
+
+std::uint64_t ChronosProfileWriter::place_strings() {
+    // An open-addressed table of the strings placed so far, kept at most half full. A slot holds the number of the
+    // string plus one, the name of function i being string 2 * i and its id 2 * i + 1
+    unsigned long string_count = 2 * m_processes.size();
+    unsigned long slot_count = 16;
+    while (slot_count < 2 * string_count){
+        slot_count *= 2;
+    }// end of while
+    std::vector<unsigned long> slots(slot_count, 0);
+    m_offsets.assign(string_count, 0);
+    m_extra_count = 0;
+    m_bucket_count = 0;
+
+    auto string_of = [this](unsigned long number) -> const std::string& {
+        ChronosProcess* process = m_processes[number / 2];
+        return number % 2 == 0 ? process->get_name() : process->get_unique_id();
+    };
+    std::uint64_t size = m_preamble.size() + m_notes.size() + m_trailer.size();
+    std::hash<std::string_view> hash;
+    for (unsigned long number = 0; number < string_count; number++){
+        const std::string& value = string_of(number);
+        unsigned long slot = hash(std::string_view(value)) & (slot_count - 1);
+        while (slots[slot] != 0 && string_of(slots[slot] - 1) != value){
+            slot = (slot + 1) & (slot_count - 1);
+        }// end of while
+        if (slots[slot] == 0){
+            slots[slot] = number + 1;
+            m_offsets[number] = size;
+            size += value.size();
+        }else{
+            m_offsets[number] = m_offsets[slots[slot] - 1];
+        }// end of if else
+        if (number % 2 == 0){
+            m_extra_count += has_extra(*m_processes[number / 2]) ? 1 : 0;
+            const unsigned long long* counts = m_processes[number / 2]->get_histogram().get_buckets();
+            for (long index = 0; counts != nullptr && index < ChronosHistogram::k_bucket_count; index++){
+                m_bucket_count += counts[index] != 0 ? 1 : 0;
+            }// end of for
+        }// end of if
+    }// end of for
+    return size;
+}
+
+bool ChronosProfileWriter::has_extra(ChronosProcess& process) {
+    return process.get_counted_calls() > 0 || process.get_allocations() > 0 || process.get_allocated_bytes() > 0
+        || process.get_peak_live_bytes() > 0 || process.get_cpu_calls() > 0;
+}
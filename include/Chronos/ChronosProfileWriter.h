@@ -0,0 +1,188 @@
+/**   Copyright 2020 Benrick Smit
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ * 
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+*/
+/**
+ * @author: Benrick Smit
+ * @email: metatronicprogramming@hotmail.com
+ * @date: 13 June 2020
+ * @modified: 13 June 2020
+ * 
+ * @brief: This class writes a profile in the compact binary format of the Chronos profiler. The file starts with a
+ *          ChronosProfileHeader, followed by a fixed-width ChronosProfileRecord for every function, a ChronosProfileExtra for
+ *          those with hardware counters, allocations or CPU times, the non-empty buckets of their histograms, and a string
+ *          table holding every name and id once. The size of the file is worked out first,
+ *          and the file is then filled in through a single mapping, so nothing is allocated per function and no text is
+ *          formatted. ChronosProfileReader reads the file back, and converts it to the .csv and .txt reports.
+ * 
+ */ 
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "ChronosCounters.h"
+#include "ChronosHistogram.h"
+#include "ChronosProcess.h"
+
+/**
+ * @brief The header at the start of a profile file. The offsets of the text blocks are within the string table
+ * 
+ */
+struct ChronosProfileHeader {
+    char magic[8];                                                          // "CHRPROFL"
+    std::uint32_t version;                                                  // k_profile_version
+    std::uint32_t record_size;                                              // sizeof(ChronosProfileRecord)
+    std::uint32_t extra_size;                                               // sizeof(ChronosProfileExtra)
+    std::uint32_t counter_count;                                            // ChronosCounters::k_counter_count
+    std::uint64_t thread_count;                                             // Threads which have a section in the reports
+    std::uint64_t record_count;                                             // Functions in the file
+    std::uint64_t records_offset;                                           // File offset of the records
+    std::uint64_t extra_count;                                              // Functions with counters, allocations or CPU times
+    std::uint64_t extras_offset;                                            // File offset of their statistics
+    std::uint64_t bucket_count;                                             // Histogram buckets of all the functions
+    std::uint64_t buckets_offset;                                           // File offset of the buckets
+    std::uint64_t strings_size;                                             // Bytes in the string table
+    std::uint64_t strings_offset;                                           // File offset of the string table
+    std::uint64_t preamble_offset;                                          // Lines above the table of the .txt report
+    std::uint64_t preamble_length;
+    std::uint64_t notes_offset;                                             // Lines below the benchmarks of the .txt report
+    std::uint64_t notes_length;
+    std::uint64_t trailer_offset;                                           // Sections at the end of the .txt report
+    std::uint64_t trailer_length;
+};
+
+/**
+ * @brief The statistics of one function, in the order of the reports: merged over the threads, then per thread, then
+ *          the benchmarks
+ * 
+ */
+struct ChronosProfileRecord {
+    std::uint64_t name_offset;                                              // Name of the function in the string table
+    std::uint64_t id_offset;                                                // Hash id in the string table
+    std::uint32_t name_length;
+    std::uint32_t id_length;
+    std::int32_t thread_id;                                                 // As ChronosProcess::get_thread_id
+    std::uint32_t extra;                                                    // Index of its ChronosProfileExtra, or k_profile_no_extra
+    std::int64_t total_calls;
+    std::int64_t timed_calls;
+    double max_time;                                                        // In seconds, as are all the times
+    double min_time;
+    double mean_time;
+    double total_time;
+    double inclusive_time;
+    double self_time;
+    double sum_squares;
+    std::uint64_t first_bucket;                                             // Index of the function's first bucket
+    std::uint64_t bucket_count;                                             // Non-empty buckets of its histogram
+};
+
+/**
+ * @brief The statistics most functions do not have, stored only for those which do
+ * 
+ */
+struct ChronosProfileExtra {
+    std::uint64_t counters[ChronosCounters::k_counter_count];               // Hardware counter totals
+    std::int64_t counted_calls;
+    std::int64_t allocations;
+    std::int64_t allocated_bytes;
+    std::int64_t peak_live_bytes;
+    std::int64_t cpu_calls;
+    double cpu_time;
+    double cpu_wall_time;
+    std::int64_t voluntary_switches;
+    std::int64_t involuntary_switches;
+};
+
+// Every histogram bucket is a uint64: the count shifted left by k_profile_bucket_bits, or'ed with the bucket's index
+static const std::uint32_t k_profile_version = 1;
+static const std::uint32_t k_profile_no_extra = 0xffffffff;
+static const int k_profile_bucket_bits = 10;
+static_assert(sizeof(ChronosProfileRecord) % 8 == 0 && sizeof(ChronosProfileExtra) % 8 == 0, "The parts of a profile must stay 8-byte aligned");
+static_assert(ChronosHistogram::k_bucket_count <= (1 << k_profile_bucket_bits), "A bucket index must fit in its bits");
+
+class ChronosProfileWriter {
+	public:
+		//ctors and dtors
+		/**
+		 * @brief Construct a new Chronos Profile Writer object, which holds no functions
+		 * 
+		 */
+		ChronosProfileWriter();
+
+		//Setters
+		/**
+		 * @brief Set the lines written above the table of the .txt report
+		 * 
+		 * @param value 
+		 */
+		void set_preamble(const std::string& value);
+		/**
+		 * @brief Set the lines written below the benchmarks of the .txt report
+		 * 
+		 * @param value 
+		 */
+		void set_notes(const std::string& value);
+		/**
+		 * @brief Set the sections written at the end of the .txt report
+		 * 
+		 * @param value 
+		 */
+		void set_trailer(const std::string& value);
+		/**
+		 * @brief Set the number of threads, which all get a section in the .txt report, even those without functions
+		 * 
+		 * @param value 
+		 */
+		void set_thread_count(long value);
+
+		//Basic Operation
+		/**
+		 * @brief Adds functions to the profile. They are not copied, so they must outlive the call to write
+		 * 
+		 * @param processes 
+		 */
+		void add(std::vector<ChronosProcess>& processes);
+		/**
+		 * @brief Adds a function to the profile. It is not copied, so it must outlive the call to write
+		 * 
+		 * @param process 
+		 */
+		void add(ChronosProcess& process);
+		/**
+		 * @brief Writes the profile to a file, replacing it
+		 * 
+		 * @param path 
+		 * @return true if the file was written
+		 */
+		bool write(std::string path);
+
+	private:
+		// Gives every name and id its offset in the string table, storing the names which repeat only once, and counts the
+		// extras and buckets
+		std::uint64_t place_strings();
+		// Whether a function has any of the statistics of a ChronosProfileExtra
+		static bool has_extra(ChronosProcess& process);
+
+		//Member variables
+		std::string m_preamble;
+		std::string m_notes;
+		std::string m_trailer;
+		long m_thread_count;
+		std::vector<ChronosProcess*> m_processes;								// The functions, in the order they were added
+		std::vector<std::uint64_t> m_offsets;									// Offset of the name and id of every function
+		std::uint64_t m_extra_count;											// Functions with a ChronosProfileExtra
+		std::uint64_t m_bucket_count;											// Non-empty buckets over all the functions
+};
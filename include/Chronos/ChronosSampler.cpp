@@ -0,0 +1,127 @@
+/**   Copyright 2020 Benrick Smit
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ * 
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+*/
+
+/**
+ * @author: Benrick Smit
+ * @email: metatronicprogramming@hotmail.com
+ * @date: 13 June 2020
+ * @modified: 13 June 2020
+ * 
+ * @brief: This class holds the sampling settings the recording threads read.
+ * 
+ */ 
+
+
+#include "ChronosSampler.h"
+
+#include "ChronosClock.h"
+
+
+//Ctors and Dtors
+ChronosSampler::ChronosSampler() {
+    m_default_period.store(1);
+    m_adaptive.store(false);
+    m_overhead_budget = 0.01;
+    // A rough guess until the profiler measures its own cost
+    m_timed_call_cost = 100e-9;
+    for (long i = 0; i < k_max_blocks; i++){
+        m_blocks[i].store(nullptr, std::memory_order_relaxed);
+        m_cpu_blocks[i].store(nullptr, std::memory_order_relaxed);
+        m_adaptive_blocks[i].store(nullptr, std::memory_order_relaxed);
+    }// end of for
+    m_cpu_timing.store(false);
+    m_adaptive_sites.store(false);
+    // Worked out when the adaptive mode is turned on, once the clock is calibrated
+    m_min_window.store(0);
+}
+
+ChronosSampler::~ChronosSampler() {
+    for (long i = 0; i < k_max_blocks; i++){
+        delete[] m_blocks[i].load(std::memory_order_relaxed);
+        delete[] m_cpu_blocks[i].load(std::memory_order_relaxed);
+        delete[] m_adaptive_blocks[i].load(std::memory_order_relaxed);
+    }// end of for
+}
+
+//Setters
+void ChronosSampler::set_default_period(long period) {
+    m_default_period.store(period < 1 ? 1 : period, std::memory_order_relaxed);
+}
+
+void ChronosSampler::set_period(long site, long period) {
+    unsigned long block = static_cast<unsigned long>(site) / k_block_size;
+    if (site < 0 || block >= static_cast<unsigned long>(k_max_blocks)){
+        return;
+    }// end of if
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::atomic<long>* periods = m_blocks[block].load(std::memory_order_relaxed);
+    if (periods == nullptr){
+        periods = new std::atomic<long>[k_block_size]();
+        m_blocks[block].store(periods, std::memory_order_release);
+    }// end of if
+    periods[site % k_block_size].store(period < 0 ? 0 : period, std::memory_order_relaxed);
+}
+
+void ChronosSampler::set_cpu_timed(long site, bool enabled) {
+    set_flag(m_cpu_blocks, site, enabled);
+    if (enabled){
+        m_cpu_timing.store(true, std::memory_order_relaxed);
+    }// end of if
+}
+
+void ChronosSampler::set_adaptive(bool enabled, double overhead_budget) {
+    set_overhead_budget(overhead_budget);
+    m_adaptive.store(enabled, std::memory_order_relaxed);
+}
+
+void ChronosSampler::set_adaptive(long site, bool enabled) {
+    set_flag(m_adaptive_blocks, site, enabled);
+    if (enabled){
+        m_adaptive_sites.store(true, std::memory_order_relaxed);
+    }// end of if
+}
+
+void ChronosSampler::set_overhead_budget(double overhead_budget) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_overhead_budget = overhead_budget > 0 ? overhead_budget : 0.01;
+    update_min_window();
+}
+
+void ChronosSampler::set_timed_call_cost(double seconds) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_timed_call_cost = seconds > 0 ? seconds : m_timed_call_cost;
+    update_min_window();
+}
+
+//Private Functions
+void ChronosSampler::update_min_window() {
+    // One timed call per window keeps its cost within the budget
+    double seconds = m_timed_call_cost / m_overhead_budget;
+    m_min_window.store(static_cast<long long>(seconds / ChronosClock::get_seconds_per_tick()), std::memory_order_relaxed);
+}
+
+void ChronosSampler::set_flag(std::atomic<std::atomic<bool>*>* blocks, long site, bool enabled) {
+    unsigned long block = static_cast<unsigned long>(site) / k_block_size;
+    if (site < 0 || block >= static_cast<unsigned long>(k_max_blocks)){
+        return;
+    }// end of if
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::atomic<bool>* flags = blocks[block].load(std::memory_order_relaxed);
+    if (flags == nullptr){
+        flags = new std::atomic<bool>[k_block_size]();
+        blocks[block].store(flags, std::memory_order_release);
+    }// end of if
+    flags[site % k_block_size].store(enabled, std::memory_order_relaxed);
+}
@@ -0,0 +1,195 @@
+/**   Copyright 2020 Benrick Smit
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ * 
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+*/
+
+/**
+ * @author: Benrick Smit
+ * @email: metatronicprogramming@hotmail.com
+ * @date: 13 June 2020
+ * @modified: 13 June 2020
+ * 
+ * @brief: This class holds the sampling settings the recording threads read. With a sample period of N only every Nth call of
+ *          a site is timed, while every call is still counted; the reports extrapolate the timed calls to all of them. The
+ *          period can be set for all sites, and overridden per site. In adaptive mode every thread raises the period of a
+ *          site whenever the timed calls of the site would cost more than the overhead budget, and lowers it again when the
+ *          site calms down. The adaptive mode can be on for all the sites, or only for some, such as the functions the
+ *          instrumentation finds. The settings are read with relaxed atomics, and only when a thread's countdown for a site
+ *          runs out.
+ *          It also holds the sites whose timed calls read the thread's CPU time as well, which costs two system calls at the
+ *          start and two at the stop, so only the sites asked for pay for it.
+ * 
+ */ 
+
+#pragma once
+
+#include <atomic>
+#include <mutex>
+
+class ChronosSampler {
+	public:
+		//ctors and dtors
+		/**
+		 * @brief Construct a new Chronos Sampler object, which times every call until told otherwise
+		 * 
+		 */
+		ChronosSampler();
+		/**
+		 * @brief Destroy the Chronos Sampler object
+		 * 
+		 */
+		~ChronosSampler();
+
+		ChronosSampler(const ChronosSampler&) = delete;
+		ChronosSampler& operator=(const ChronosSampler&) = delete;
+
+		//Setters
+		/**
+		 * @brief Set the sample period of all the sites without a period of their own
+		 * 
+		 * @param period time one in every period calls, 1 times every call
+		 */
+		void set_default_period(long period);
+		/**
+		 * @brief Set the sample period of one site
+		 * 
+		 * @param site 
+		 * @param period time one in every period calls, 0 goes back to the default period
+		 */
+		void set_period(long site, long period);
+		/**
+		 * @brief Set the adaptive object
+		 * 
+		 * @param enabled whether the periods should be raised for sites that are called too often
+		 * @param overhead_budget the share of a site's time its timed calls may cost, such as 0.01 for 1%
+		 */
+		void set_adaptive(bool enabled, double overhead_budget);
+		/**
+		 * @brief Set whether one site adapts its period while the adaptive mode is off for the others
+		 * 
+		 * @param site 
+		 * @param enabled 
+		 */
+		void set_adaptive(long site, bool enabled);
+		/**
+		 * @brief Set the overhead budget of the adaptive sites, without turning the adaptive mode on or off
+		 * 
+		 * @param overhead_budget the share of a site's time its timed calls may cost, such as 0.01 for 1%
+		 */
+		void set_overhead_budget(double overhead_budget);
+		/**
+		 * @brief Set the cost of one timed call, which the adaptive mode weighs against the budget
+		 * 
+		 * @param seconds 
+		 */
+		void set_timed_call_cost(double seconds);
+		/**
+		 * @brief Set whether the timed calls of a site read the thread's CPU time and context switches
+		 * 
+		 * @param site 
+		 * @param enabled 
+		 */
+		void set_cpu_timed(long site, bool enabled);
+
+		//Getters
+		/**
+		 * @brief Get the period of a site
+		 * 
+		 * @param site 
+		 * @return long 
+		 */
+		inline long get_period(long site) {
+			unsigned long block = static_cast<unsigned long>(site) / k_block_size;
+			if (block < static_cast<unsigned long>(k_max_blocks)){
+				std::atomic<long>* periods = m_blocks[block].load(std::memory_order_acquire);
+				if (periods != nullptr){
+					long period = periods[site % k_block_size].load(std::memory_order_relaxed);
+					if (period > 0){
+						return period;
+					}// end of if
+				}// end of if
+			}// end of if
+			return m_default_period.load(std::memory_order_relaxed);
+		}
+		/**
+		 * @brief Whether the timed calls of a site read the thread's CPU time. A single load while no site asks for it.
+		 * 
+		 * @param site a handle below the k_block_size * k_max_blocks limit
+		 * @return true 
+		 * @return false 
+		 */
+		inline bool is_cpu_timed(long site) {
+			if (!m_cpu_timing.load(std::memory_order_relaxed)){
+				return false;
+			}// end of if
+			std::atomic<bool>* flags = m_cpu_blocks[site / k_block_size].load(std::memory_order_acquire);
+			return flags != nullptr && flags[site % k_block_size].load(std::memory_order_relaxed);
+		}
+		/**
+		 * @brief Whether the adaptive mode is on for all the sites
+		 * 
+		 * @return true 
+		 * @return false 
+		 */
+		inline bool is_adaptive() {
+			return m_adaptive.load(std::memory_order_relaxed);
+		}
+		/**
+		 * @brief Whether a site adapts its period, through the adaptive mode or on its own. A single load while neither is used.
+		 * 
+		 * @param site a handle below the k_block_size * k_max_blocks limit
+		 * @return true 
+		 * @return false 
+		 */
+		inline bool is_adaptive(long site) {
+			if (m_adaptive.load(std::memory_order_relaxed)){
+				return true;
+			}// end of if
+			if (!m_adaptive_sites.load(std::memory_order_relaxed)){
+				return false;
+			}// end of if
+			std::atomic<bool>* flags = m_adaptive_blocks[site / k_block_size].load(std::memory_order_acquire);
+			return flags != nullptr && flags[site % k_block_size].load(std::memory_order_relaxed);
+		}
+		/**
+		 * @brief Get the shortest stretch of time, in clock ticks, that may pass between two timed calls of a site in adaptive mode
+		 * 
+		 * @return long long 
+		 */
+		inline long long get_min_window() {
+			return m_min_window.load(std::memory_order_relaxed);
+		}
+
+		static const long k_block_size = 256;									// Sites per block, as in ChronosThread
+		static const long k_max_blocks = 4096;
+		static const long k_max_period = 1l << 20;								// Upper limit of the adaptive period
+
+	private:
+		// Works out the minimum window from the cost and budget
+		void update_min_window();
+		// Sets the flag of a site in a list of blocks, allocating its block if needed
+		void set_flag(std::atomic<std::atomic<bool>*>* blocks, long site, bool enabled);
+
+		//Member variables
+		std::atomic<long> m_default_period;										// Period of the sites without their own
+		std::atomic<bool> m_adaptive;											// Whether the periods adapt to the call rate
+		std::atomic<long long> m_min_window;									// Ticks that should pass between timed calls
+		double m_overhead_budget;												// Share of time the timed calls may cost
+		double m_timed_call_cost;												// Seconds one timed call costs
+		std::mutex m_mutex;														// Guards the allocation of the blocks
+		std::atomic<std::atomic<long>*> m_blocks[k_max_blocks];				// Periods per site, 0 for the default
+		std::atomic<bool> m_cpu_timing;											// Whether any site ever read the CPU time
+		std::atomic<std::atomic<bool>*> m_cpu_blocks[k_max_blocks];			// Whether each site reads the CPU time
+		std::atomic<bool> m_adaptive_sites;										// Whether any site ever adapted on its own
+		std::atomic<std::atomic<bool>*> m_adaptive_blocks[k_max_blocks];		// Whether each site adapts on its own
+};
@@ -0,0 +1,89 @@
+/**   Copyright 2020 Benrick Smit
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ * 
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+*/
+
+/**
+ * @author: Benrick Smit
+ * @email: metatronicprogramming@hotmail.com
+ * @date: 13 June 2020
+ * @modified: 13 June 2020
+ * 
+ * @brief: This class starts the timing of a site when it is constructed, and stops it when the scope it is declared in is
+ *          left, whether by a return or by an exception. It is normally used through the CHRONOS_SCOPE and CHRONOS_FUNCTION
+ *          macros, which register the call site once through a static local. Defining CHRONOS_ENABLED as 0 turns the
+ *          macros into nothing, so a disabled build carries no profiling code at all.
+ * 
+ */ 
+
+#pragma once
+
+#ifndef CHRONOS_ENABLED
+#define CHRONOS_ENABLED 1
+#endif
+
+#if CHRONOS_ENABLED
+
+#include "Chronos.h"
+
+class ChronosScope {
+	public:
+		//ctors and dtors
+		/**
+		 * @brief Construct a new Chronos Scope object, which starts the timing of the site
+		 * 
+		 * @param site the handle returned by Chronos::register_site
+		 */
+		explicit ChronosScope(long site) : m_profiler(Chronos::get_instance()), m_site(site) {
+			m_profiler->start(m_site);
+		}
+		/**
+		 * @brief Destroy the Chronos Scope object, which stops the timing of the site
+		 * 
+		 */
+		~ChronosScope() {
+			m_profiler->stop(m_site);
+		}
+
+		ChronosScope(const ChronosScope&) = delete;
+		ChronosScope& operator=(const ChronosScope&) = delete;
+
+	private:
+		//Member variables
+		Chronos* m_profiler;													// The profiler the site is registered with
+		long m_site;															// The site being timed
+};
+
+#define CHRONOS_CONCAT_INNER(a, b) a##b
+#define CHRONOS_CONCAT(a, b) CHRONOS_CONCAT_INNER(a, b)
+
+/**
+ * @brief Times the rest of the enclosing scope under the given name
+ * 
+ */
+#define CHRONOS_SCOPE(name) \
+	static const long CHRONOS_CONCAT(chronos_site_, __LINE__) = Chronos::get_instance()->register_site(name); \
+	ChronosScope CHRONOS_CONCAT(chronos_scope_, __LINE__)(CHRONOS_CONCAT(chronos_site_, __LINE__))
+
+/**
+ * @brief Times the rest of the enclosing function under its __PRETTY_FUNCTION__ name
+ * 
+ */
+#define CHRONOS_FUNCTION() CHRONOS_SCOPE(__PRETTY_FUNCTION__)
+
+#else
+
+#define CHRONOS_SCOPE(name)
+#define CHRONOS_FUNCTION()
+
+#endif
@@ -0,0 +1,351 @@
+/**   Copyright 2020 Benrick Smit
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ * 
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+*/
+
+/**
+ * @author: Benrick Smit
+ * @email: metatronicprogramming@hotmail.com
+ * @date: 13 June 2020
+ * @modified: 13 June 2020
+ * 
+ * @brief: This class lets several processes record into one named shared memory segment.
+ * 
+ */ 
+
+
+#include "ChronosShared.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <thread>
+
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "ChronosClock.h"
+
+static_assert(std::atomic<std::uint64_t>::is_always_lock_free, "The shared records need lock-free atomics to work across processes");
+static_assert(sizeof(ChronosSharedName) == 512, "A name table entry should take 512 bytes");
+
+// "CHRSHARE" as read from memory on a little endian machine
+static const std::uint64_t k_shared_magic = 0x4552414853524843ull;
+
+
+//Ctors and Dtors
+ChronosShared::ChronosShared() {
+    m_map = nullptr;
+    m_size = 0;
+    m_header = nullptr;
+    m_slot = nullptr;
+    m_records.store(nullptr, std::memory_order_relaxed);
+    for (long i = 0; i < k_max_blocks; i++){
+        m_blocks[i].store(nullptr, std::memory_order_relaxed);
+    }// end of for
+}
+
+ChronosShared::~ChronosShared() {
+    close();
+    for (long i = 0; i < k_max_blocks; i++){
+        delete[] m_blocks[i].load(std::memory_order_relaxed);
+    }// end of for
+}
+
+//Basic Functionality
+bool ChronosShared::open(std::string name, long max_processes, long max_sites) {
+    if (is_open() || max_processes <= 0 || max_sites <= 0){
+        return false;
+    }// end of if
+    std::uint32_t sites = 1;
+    while (sites < static_cast<std::uint64_t>(max_sites) && sites < (1u << 24)){
+        sites <<= 1;
+    }// end of while
+    std::uint64_t names_offset = (sizeof(ChronosSharedHeader) + 63) / 64 * 64;
+    std::uint64_t processes_offset = names_offset + sizeof(ChronosSharedName) * sites;
+    std::uint64_t records_offset = (processes_offset + sizeof(ChronosSharedSlot) * max_processes + 63) / 64 * 64;
+    std::uint64_t size = records_offset + sizeof(ChronosSharedRecord) * sites * max_processes;
+
+    // The first process creates and sizes the segment; the file is sparse, so only the pages used take up memory
+    bool created = true;
+    int file = shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0644);
+    if (file < 0 && errno == EEXIST){
+        created = false;
+        file = shm_open(name.c_str(), O_RDWR, 0644);
+    }// end of if
+    if (file < 0){
+        std::string error_string = "Error opening shared memory: \"" + name + "\"";
+        perror(error_string.c_str());
+        return false;
+    }// end of if
+    if (created){
+        if (ftruncate(file, static_cast<off_t>(size)) != 0){
+            perror("Error sizing shared memory");
+            ::close(file);
+            shm_unlink(name.c_str());
+            return false;
+        }// end of if
+    }else{
+        // Another process created it, so its sizes hold; wait for it to be sized
+        struct stat status;
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+        while (fstat(file, &status) == 0 && status.st_size < static_cast<off_t>(sizeof(ChronosSharedHeader))
+               && std::chrono::steady_clock::now() < deadline){
+            std::this_thread::yield();
+        }// end of while
+        if (status.st_size < static_cast<off_t>(sizeof(ChronosSharedHeader))){
+            ::close(file);
+            return false;
+        }// end of if
+        size = static_cast<std::uint64_t>(status.st_size);
+    }// end of if else
+
+    void* map = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, file, 0);
+    ::close(file);
+    if (map == MAP_FAILED){
+        perror("Error mapping shared memory");
+        return false;
+    }// end of if
+    m_map = static_cast<char*>(map);
+    m_size = size;
+    m_header = reinterpret_cast<ChronosSharedHeader*>(m_map);
+
+    if (created){
+        m_header->version = k_shared_version;
+        m_header->record_size = sizeof(ChronosSharedRecord);
+        m_header->max_processes = static_cast<std::uint32_t>(max_processes);
+        m_header->max_sites = sites;
+        m_header->names_offset = names_offset;
+        m_header->processes_offset = processes_offset;
+        m_header->records_offset = records_offset;
+        m_header->size = size;
+        m_header->magic.store(k_shared_magic, std::memory_order_release);
+    }else{
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+        while (m_header->magic.load(std::memory_order_acquire) != k_shared_magic && std::chrono::steady_clock::now() < deadline){
+            std::this_thread::yield();
+        }// end of while
+        if (m_header->magic.load(std::memory_order_acquire) != k_shared_magic || m_header->version != k_shared_version
+            || m_header->record_size != sizeof(ChronosSharedRecord) || m_header->size > size){
+            std::string error_string = "Error reading shared memory: \"" + name + "\" was not written by this version of Chronos";
+            fprintf(stderr, "%s\n", error_string.c_str());
+            munmap(m_map, m_size);
+            m_map = nullptr;
+            m_header = nullptr;
+            return false;
+        }// end of if
+    }// end of if else
+    m_name = name;
+    return claim_slot();
+}
+
+void ChronosShared::close() {
+    if (!is_open()){
+        return;
+    }// end of if
+    m_records.store(nullptr, std::memory_order_relaxed);
+    if (m_slot != nullptr){
+        m_slot->state.store(k_process_finished, std::memory_order_release);
+    }// end of if
+    munmap(m_map, m_size);
+    m_map = nullptr;
+    m_header = nullptr;
+    m_slot = nullptr;
+}
+
+void ChronosShared::reattach() {
+    if (is_open()){
+        claim_slot();
+    }// end of if
+}
+
+void ChronosShared::add_site(long site, std::string_view name, std::string_view id) {
+    unsigned long block = static_cast<unsigned long>(site) / k_block_size;
+    if (!is_open() || block >= static_cast<unsigned long>(k_max_blocks)){
+        return;
+    }// end of if
+    long entry = find_name(name, id);
+    if (entry < 0){
+        return;
+    }// end of if
+    std::atomic<long>* entries = m_blocks[block].load(std::memory_order_relaxed);
+    if (entries == nullptr){
+        entries = new std::atomic<long>[k_block_size]();
+        m_blocks[block].store(entries, std::memory_order_release);
+    }// end of if
+    entries[site % k_block_size].store(entry + 1, std::memory_order_relaxed);
+}
+
+//Getters
+bool ChronosShared::is_open() {
+    return m_map != nullptr;
+}
+
+std::string ChronosShared::get_name() {
+    return m_name;
+}
+
+//Static Functions
+bool ChronosShared::read(std::string name, std::vector<ChronosSharedProfile>& profiles) {
+    int file = shm_open(name.c_str(), O_RDONLY, 0);
+    if (file < 0){
+        std::string error_string = "Error opening shared memory: \"" + name + "\"";
+        perror(error_string.c_str());
+        return false;
+    }// end of if
+    struct stat status;
+    if (fstat(file, &status) != 0 || status.st_size < static_cast<off_t>(sizeof(ChronosSharedHeader))){
+        ::close(file);
+        return false;
+    }// end of if
+    unsigned long size = static_cast<unsigned long>(status.st_size);
+    void* map = mmap(nullptr, size, PROT_READ, MAP_SHARED, file, 0);
+    ::close(file);
+    if (map == MAP_FAILED){
+        perror("Error mapping shared memory");
+        return false;
+    }// end of if
+    const char* base = static_cast<const char*>(map);
+    ChronosSharedHeader* header = reinterpret_cast<ChronosSharedHeader*>(static_cast<char*>(map));
+    if (header->magic.load(std::memory_order_acquire) != k_shared_magic || header->version != k_shared_version
+        || header->record_size != sizeof(ChronosSharedRecord) || header->size > size){
+        munmap(map, size);
+        return false;
+    }// end of if
+
+    const ChronosSharedName* names = reinterpret_cast<const ChronosSharedName*>(base + header->names_offset);
+    ChronosSharedSlot* slots = reinterpret_cast<ChronosSharedSlot*>(static_cast<char*>(map) + header->processes_offset);
+    ChronosSharedRecord* records = reinterpret_cast<ChronosSharedRecord*>(static_cast<char*>(map) + header->records_offset);
+    std::uint32_t process_count = std::min(header->process_count.load(std::memory_order_acquire), header->max_processes);
+    profiles.clear();
+    for (std::uint32_t slot = 0; slot < process_count; slot++){
+        ChronosSharedProfile profile;
+        profile.pid = static_cast<long>(slots[slot].pid.load(std::memory_order_acquire));
+        if (profile.pid <= 0){
+            // Taken, but not filled in yet
+            continue;
+        }// end of if
+        if (slots[slot].state.load(std::memory_order_acquire) == k_process_finished){
+            profile.state = "finished";
+        }else if (kill(static_cast<pid_t>(profile.pid), 0) != 0 && errno == ESRCH){
+            // Still marked running, but the process is gone
+            profile.state = "crashed";
+        }else{
+            profile.state = "running";
+        }// end of if else
+
+        // Convert the clock ticks into seconds, and extrapolate the timed calls to the calls not already inside one of the same
+        // site, as ChronosThread::read_site does
+        double period = slots[slot].seconds_per_tick;
+        for (std::uint32_t entry = 0; entry < header->max_sites; entry++){
+            ChronosSharedRecord& record = records[static_cast<std::uint64_t>(slot) * header->max_sites + entry];
+            long calls = static_cast<long>(record.calls.load(std::memory_order_relaxed));
+            if (calls == 0 || names[entry].state.load(std::memory_order_acquire) != k_name_ready){
+                continue;
+            }// end of if
+            long timed = static_cast<long>(record.timed.load(std::memory_order_relaxed));
+            long extrapolated = calls - static_cast<long>(record.covered.load(std::memory_order_relaxed));
+            extrapolated = extrapolated < timed ? timed : extrapolated;
+            double mean = timed > 0 ? record.total.load(std::memory_order_relaxed) * period / timed : 0;
+            double scale = timed > 0 ? static_cast<double>(calls) / timed : 0;
+            std::uint64_t min = record.min.load(std::memory_order_relaxed);
+            ChronosProcess process(std::string(names[entry].name, names[entry].length),
+                                   std::string(names[entry].id, strnlen(names[entry].id, sizeof(names[entry].id))));
+            process.set_total_calls(calls);
+            process.set_timed_calls(timed);
+            process.set_total_time(mean * extrapolated);
+            process.set_min_time(min > 0 ? (min - 1) * period : 0);
+            process.set_max_time(record.max.load(std::memory_order_relaxed) * period);
+            process.set_mean_time(mean);
+            process.set_sum_squares(record.sum_squares.load(std::memory_order_relaxed) * period * period * scale);
+            process.set_thread_id(-1);
+            // Every power of two is counted at its geometric middle, so the percentiles are within a factor of 1.42
+            ChronosHistogram histogram;
+            for (long i = 0; i < k_shared_bucket_count; i++){
+                unsigned long long count = record.buckets[i].load(std::memory_order_relaxed);
+                if (count > 0){
+                    double ticks = i == 0 ? 1 : static_cast<double>(1ull << i) * 1.41421356;
+                    histogram.add(ChronosHistogram::bucket_index(static_cast<unsigned long long>(ticks * period * 1e9)), count);
+                }// end of if
+            }// end of for
+            process.set_histogram(histogram);
+            profile.processes.push_back(std::move(process));
+        }// end of for
+        std::sort(profile.processes.begin(), profile.processes.end(), [](ChronosProcess& a, ChronosProcess& b){
+            return a.get_name() < b.get_name();
+        });
+        profiles.push_back(std::move(profile));
+    }// end of for
+    munmap(map, size);
+    return true;
+}
+
+bool ChronosShared::remove(std::string name) {
+    return shm_unlink(name.c_str()) == 0;
+}
+
+//Private Functions
+bool ChronosShared::claim_slot() {
+    m_records.store(nullptr, std::memory_order_relaxed);
+    m_slot = nullptr;
+    std::uint32_t slot = m_header->process_count.fetch_add(1, std::memory_order_acq_rel);
+    if (slot >= m_header->max_processes){
+        fprintf(stderr, "Error recording into shared memory: all %u process slots of \"%s\" are taken\n", m_header->max_processes, m_name.c_str());
+        return false;
+    }// end of if
+    m_slot = reinterpret_cast<ChronosSharedSlot*>(m_map + m_header->processes_offset) + slot;
+    m_slot->seconds_per_tick = ChronosClock::get_seconds_per_tick();
+    m_slot->state.store(k_process_running, std::memory_order_relaxed);
+    m_slot->pid.store(static_cast<std::int64_t>(getpid()), std::memory_order_release);
+    ChronosSharedRecord* records = reinterpret_cast<ChronosSharedRecord*>(m_map + m_header->records_offset);
+    m_records.store(records + static_cast<std::uint64_t>(slot) * m_header->max_sites, std::memory_order_release);
+    return true;
+}
+
+long ChronosShared::find_name(std::string_view name, std::string_view id) {
+    std::uint64_t hash = std::hash<std::string_view>{}(name);
+    std::uint32_t length = static_cast<std::uint32_t>(std::min<std::size_t>(name.size(), k_shared_name_size));
+    std::uint32_t mask = m_header->max_sites - 1;
+    ChronosSharedName* names = reinterpret_cast<ChronosSharedName*>(m_map + m_header->names_offset);
+    for (std::uint32_t probe = 0; probe <= mask; probe++){
+        std::uint32_t entry = static_cast<std::uint32_t>(hash + probe) & mask;
+        ChronosSharedName& slot = names[entry];
+        std::uint32_t state = slot.state.load(std::memory_order_acquire);
+        if (state == k_name_empty && slot.state.compare_exchange_strong(state, k_name_writing, std::memory_order_acq_rel)){
+            slot.hash = hash;
+            slot.length = length;
+            std::memcpy(slot.name, name.data(), length);
+            std::size_t id_length = std::min(id.size(), sizeof(slot.id) - 1);
+            std::memcpy(slot.id, id.data(), id_length);
+            slot.id[id_length] = '\0';
+            slot.state.store(k_name_ready, std::memory_order_release);
+            return static_cast<long>(entry);
+        }// end of if
+        // Wait for a name being written by another process, but not for one that crashed halfway
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(100);
+        while (state == k_name_writing && std::chrono::steady_clock::now() < deadline){
+            std::this_thread::yield();
+            state = slot.state.load(std::memory_order_acquire);
+        }// end of while
+        if (state == k_name_ready && slot.hash == hash && slot.length == length && std::memcmp(slot.name, name.data(), length) == 0){
+            return static_cast<long>(entry);
+        }// end of if
+    }// end of for
+    return -1;
+}
@@ -0,0 +1,307 @@
+/**   Copyright 2020 Benrick Smit
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ * 
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+*/
+
+/**
+ * @author: Benrick Smit
+ * @email: metatronicprogramming@hotmail.com
+ * @date: 13 June 2020
+ * @modified: 13 June 2020
+ * 
+ * @brief: This class lets several processes, such as pre-forked workers, record into one named shared memory segment, so
+ *          a parent or any other process can read a single profile merged over all of them. The segment is created by the
+ *          first process to open it, with shm_open and mmap, and holds a table of site names, a slot for every process, and
+ *          a record per site and process. The calls are added to the records with atomics as they stop, so nothing is lost
+ *          when a worker crashes: its slot is still marked running, and the reader reports it as crashed when its process
+ *          is gone. Only POSIX systems are supported.
+ * 
+ */ 
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "ChronosProcess.h"
+
+// Power of two buckets of the shared records, enough for any duration in ticks
+static const long k_shared_bucket_count = 64;
+// Longest site name kept in the segment, longer names are cut short
+static const long k_shared_name_size = 472;
+static const std::uint32_t k_shared_version = 2;
+
+// States of a name table entry
+static const std::uint32_t k_name_empty = 0;
+static const std::uint32_t k_name_writing = 1;
+static const std::uint32_t k_name_ready = 2;
+// States of a process slot
+static const std::uint32_t k_process_running = 1;
+static const std::uint32_t k_process_finished = 2;
+
+/**
+ * @brief The header at the start of the segment, written once by the process that creates it
+ * 
+ */
+struct ChronosSharedHeader {
+    std::atomic<std::uint64_t> magic;                                       // "CHRSHARE", stored last, once the header is complete
+    std::uint32_t version;                                                  // k_shared_version
+    std::uint32_t record_size;                                              // sizeof(ChronosSharedRecord)
+    std::uint32_t max_processes;                                            // Slots for processes
+    std::uint32_t max_sites;                                                // Entries of the name table, a power of two
+    std::atomic<std::uint32_t> process_count;                               // Slots handed out, may run past max_processes
+    std::uint32_t reserved;
+    std::uint64_t names_offset;                                             // Byte offset of the name table
+    std::uint64_t processes_offset;                                         // Byte offset of the process slots
+    std::uint64_t records_offset;                                           // Byte offset of the records, max_sites per process
+    std::uint64_t size;                                                     // Bytes in the segment
+};
+
+/**
+ * @brief An entry of the open addressed name table. The state goes from empty to writing to ready exactly once, so every
+ *          process finds a site at the same entry, whose index is also the index of the site's records.
+ * 
+ */
+struct ChronosSharedName {
+    std::atomic<std::uint32_t> state;                                       // k_name_empty, k_name_writing or k_name_ready
+    std::uint32_t length;                                                   // Bytes of the name, at most k_shared_name_size
+    std::uint64_t hash;                                                     // Hash of the whole name, also when it was cut short
+    char id[24];                                                            // Id of the process that registered the site
+    char name[k_shared_name_size];
+};
+
+/**
+ * @brief The slot of one process
+ * 
+ */
+struct ChronosSharedSlot {
+    std::atomic<std::int64_t> pid;                                          // The process, 0 until the slot is taken
+    std::atomic<std::uint32_t> state;                                       // k_process_running or k_process_finished
+    std::uint32_t reserved;
+    double seconds_per_tick;                                                // Length of the process's ChronosClock tick
+};
+
+/**
+ * @brief The statistics of one site in one process, updated with atomics by all the threads of the process
+ * 
+ */
+struct alignas(64) ChronosSharedRecord {
+    std::atomic<std::uint64_t> calls;                                       // Completed calls, timed or not
+    std::atomic<std::uint64_t> timed;                                       // Completed calls that were timed
+    std::atomic<std::uint64_t> covered;                                     // Untimed calls made inside a timed call of the site
+    std::atomic<std::uint64_t> total;                                       // Ticks spent in the timed calls
+    std::atomic<std::uint64_t> min;                                         // Shortest call plus one, 0 before the first timed call
+    std::atomic<std::uint64_t> max;                                         // Longest call
+    std::atomic<double> sum_squares;                                        // Sum of the squared calls, for the deviation
+    std::atomic<std::uint64_t> buckets[k_shared_bucket_count];              // Timed calls per power of two of their ticks
+};
+
+/**
+ * @brief The profile of one process, as read out of the segment
+ * 
+ */
+struct ChronosSharedProfile {
+    long pid;
+    std::string state;                                                      // "running", "finished" or "crashed"
+    std::vector<ChronosProcess> processes;                                  // One per site the process called, ordered by name
+};
+
+class ChronosShared {
+	public:
+		//ctors and dtors
+		/**
+		 * @brief Construct a new Chronos Shared object, which does nothing until opened
+		 * 
+		 */
+		ChronosShared();
+		/**
+		 * @brief Destroy the Chronos Shared object, marking the process finished if it is still open
+		 * 
+		 */
+		~ChronosShared();
+
+		ChronosShared(const ChronosShared&) = delete;
+		ChronosShared& operator=(const ChronosShared&) = delete;
+
+		//Basic Operation
+		/**
+		 * @brief Opens the segment, creating it if no other process has yet, and takes a slot for this process
+		 * 
+		 * @param name the name of the segment, such as "/chronos"
+		 * @param max_processes the slots of a new segment; a process which finds them all taken records only for itself
+		 * @param max_sites the distinct site names a new segment holds, rounded up to a power of two
+		 * @return true if the process has a slot to record into
+		 */
+		bool open(std::string name, long max_processes, long max_sites);
+		/**
+		 * @brief Marks the process finished, and unmaps the segment. The segment itself stays until removed.
+		 * 
+		 */
+		void close();
+		/**
+		 * @brief Takes a new slot in the forked child, so its calls are not added to those of its parent. Only to be called in
+		 *          the child, before it records anything.
+		 * 
+		 */
+		void reattach();
+		/**
+		 * @brief Finds or adds the site's entry in the name table, and maps the local site handle onto it
+		 * 
+		 * @param site the handle returned by Chronos::register_site
+		 * @param name 
+		 * @param id 
+		 */
+		void add_site(long site, std::string_view name, std::string_view id);
+		/**
+		 * @brief Adds a call which was not timed. Safe to call from any thread.
+		 * 
+		 * @param site 
+		 */
+		inline void count(long site) {
+			ChronosSharedRecord* record = get_record(site);
+			if (record != nullptr){
+				record->calls.fetch_add(1, std::memory_order_relaxed);
+			}// end of if
+		}
+		/**
+		 * @brief Marks an untimed call as made inside a timed call of the same site, whose time already holds it. Safe to call
+		 *          from any thread.
+		 * 
+		 * @param site 
+		 */
+		inline void cover(long site) {
+			ChronosSharedRecord* record = get_record(site);
+			if (record != nullptr){
+				record->covered.fetch_add(1, std::memory_order_relaxed);
+			}// end of if
+		}
+		/**
+		 * @brief Adds a timed call. Safe to call from any thread.
+		 * 
+		 * @param site 
+		 * @param elapsed the duration of the call in clock ticks
+		 */
+		inline void add(long site, long long elapsed) {
+			ChronosSharedRecord* record = get_record(site);
+			if (record == nullptr){
+				return;
+			}// end of if
+			std::uint64_t ticks = elapsed < 0 ? 0 : static_cast<std::uint64_t>(elapsed);
+			record->buckets[bucket_index(ticks)].fetch_add(1, std::memory_order_relaxed);
+			double squares = record->sum_squares.load(std::memory_order_relaxed);
+			double squared = static_cast<double>(ticks) * static_cast<double>(ticks);
+			while (!record->sum_squares.compare_exchange_weak(squares, squares + squared, std::memory_order_relaxed)){
+			}// end of while
+			std::uint64_t min = record->min.load(std::memory_order_relaxed);
+			while ((min == 0 || ticks + 1 < min) && !record->min.compare_exchange_weak(min, ticks + 1, std::memory_order_relaxed)){
+			}// end of while
+			std::uint64_t max = record->max.load(std::memory_order_relaxed);
+			while (ticks > max && !record->max.compare_exchange_weak(max, ticks, std::memory_order_relaxed)){
+			}// end of while
+			record->total.fetch_add(ticks, std::memory_order_relaxed);
+			record->timed.fetch_add(1, std::memory_order_relaxed);
+			record->calls.fetch_add(1, std::memory_order_relaxed);
+		}
+
+		//Getters
+		/**
+		 * @brief Whether this process records into a segment
+		 * 
+		 * @return true 
+		 * @return false 
+		 */
+		bool is_open();
+		/**
+		 * @brief Get the name object
+		 * 
+		 * @return std::string the name of the open segment
+		 */
+		std::string get_name();
+
+		/**
+		 * @brief Reads the profiles of all the processes which recorded into a segment. Any process may read, whether it records
+		 *          into the segment or not, while the others carry on recording.
+		 * 
+		 * @param name the name of the segment
+		 * @param profiles receives one profile per process, in the order they opened the segment
+		 * @return true if the segment could be read
+		 */
+		static bool read(std::string name, std::vector<ChronosSharedProfile>& profiles);
+		/**
+		 * @brief Removes the segment's name, so the next process to open it starts a new one. Processes which have it open
+		 *          keep their mapping.
+		 * 
+		 * @param name 
+		 * @return true if the segment existed
+		 */
+		static bool remove(std::string name);
+
+		static const long k_block_size = 256;									// Site handles per block of the mapping, as in ChronosThread
+		static const long k_max_blocks = 4096;
+
+	private:
+		/**
+		 * @brief Get the record of the site for this process
+		 * 
+		 * @param site 
+		 * @return ChronosSharedRecord* nullptr if the site is not mapped or the process has no slot
+		 */
+		inline ChronosSharedRecord* get_record(long site) {
+			ChronosSharedRecord* records = m_records.load(std::memory_order_relaxed);
+			unsigned long block = static_cast<unsigned long>(site) / k_block_size;
+			if (records == nullptr || block >= static_cast<unsigned long>(k_max_blocks)){
+				return nullptr;
+			}// end of if
+			std::atomic<long>* entries = m_blocks[block].load(std::memory_order_acquire);
+			if (entries == nullptr){
+				return nullptr;
+			}// end of if
+			long entry = entries[site % k_block_size].load(std::memory_order_relaxed);
+			return entry > 0 ? records + (entry - 1) : nullptr;
+		}
+		/**
+		 * @brief The power of two bucket of a duration
+		 * 
+		 * @param ticks 
+		 * @return long 
+		 */
+		static inline long bucket_index(std::uint64_t ticks) {
+			return ticks == 0 ? 0 : 63 - __builtin_clzll(ticks);
+		}
+		/**
+		 * @brief Takes the next free slot, and points the records at it
+		 * 
+		 * @return true if there was a slot left
+		 */
+		bool claim_slot();
+		/**
+		 * @brief Finds the entry of a name in the table, adding it if no process has yet
+		 * 
+		 * @param name 
+		 * @param id 
+		 * @return long the entry, or -1 if the table is full
+		 */
+		long find_name(std::string_view name, std::string_view id);
+
+		//Member variables
+		std::string m_name;														// Name of the open segment
+		char* m_map;															// The mapped segment, nullptr when closed
+		unsigned long m_size;													// Bytes mapped
+		ChronosSharedHeader* m_header;
+		ChronosSharedSlot* m_slot;												// Slot of this process, nullptr if none was left
+		std::atomic<ChronosSharedRecord*> m_records;							// Records of this process, read by the recording threads
+		std::atomic<std::atomic<long>*> m_blocks[k_max_blocks];				// Name table entry plus one per site handle, 0 if not mapped
+};
@@ -0,0 +1,165 @@
+/**   Copyright 2020 Benrick Smit
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ * 
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+*/
+
+/**
+ * @author: Benrick Smit
+ * @email: metatronicprogramming@hotmail.com
+ * @date: 13 June 2020
+ * @modified: 13 June 2020
+ * 
+ * @brief: This class times an asynchronous operation, which may be suspended on one thread and resumed on another.
+ * 
+ */ 
+
+
+#include "ChronosSpan.h"
+
+#include <vector>
+
+
+// The spans running on the thread, innermost last. A span is only on the list of the thread it runs on, and leaves it when
+// it is suspended or finished, so the list never points at a span which may be resumed or destroyed elsewhere. Its address
+// also tells the threads apart
+static thread_local std::vector<ChronosSpan*> t_running;
+
+
+//Ctors and Dtors
+ChronosSpan::ChronosSpan(long site) : ChronosSpan(site, get_current()) {
+}
+
+
+ChronosSpan::ChronosSpan(long site, ChronosSpan* parent) {
+    m_profiler = Chronos::get_instance();
+    m_site = site;
+    m_parent = parent != nullptr ? parent->m_site : -1;
+    m_active = 0;
+    m_suspended = 0;
+    m_end = 0;
+    m_suspensions = 0;
+    m_hops = 0;
+    m_thread = &t_running;
+    m_running = site >= 0;
+    m_finished = site < 0;
+    if (m_running){
+        t_running.push_back(this);
+    }// end of if
+    m_start = ChronosClock::start_ticks();
+    m_resumed = m_start;
+}
+
+
+ChronosSpan::~ChronosSpan() {
+    finish();
+}
+
+
+
+//Basic Functionality
+void ChronosSpan::suspend() {
+    if (!m_running){
+        return;
+    }// end of if
+    m_suspended = ChronosClock::stop_ticks();
+    m_active += m_suspended - m_resumed;
+    m_suspensions++;
+    m_running = false;
+    leave_thread();
+}
+
+
+void ChronosSpan::cancel_suspend() {
+    if (m_running || m_finished){
+        return;
+    }// end of if
+    // Running since the last resume, as if the suspend never happened
+    m_active -= m_suspended - m_resumed;
+    m_suspensions--;
+    t_running.push_back(this);
+    m_running = true;
+}
+
+
+void ChronosSpan::resume() {
+    if (m_running || m_finished){
+        return;
+    }// end of if
+    if (m_thread != &t_running){
+        m_hops++;
+        m_thread = &t_running;
+    }// end of if
+    t_running.push_back(this);
+    m_running = true;
+    m_resumed = ChronosClock::start_ticks();
+}
+
+
+void ChronosSpan::finish() {
+    if (m_finished){
+        return;
+    }// end of if
+    m_end = ChronosClock::stop_ticks();
+    if (m_running){
+        m_active += m_end - m_resumed;
+        m_running = false;
+        leave_thread();
+    }// end of if
+    m_finished = true;
+    m_profiler->record_span({m_site, m_parent, m_suspensions, m_hops, m_active, m_end - m_start});
+}
+
+
+
+//Getters
+ChronosSpan* ChronosSpan::get_current() {
+    return t_running.empty() ? nullptr : t_running.back();
+}
+
+
+long ChronosSpan::get_site() {
+    return m_site;
+}
+
+
+long ChronosSpan::get_parent_site() {
+    return m_parent;
+}
+
+
+double ChronosSpan::get_active_time() {
+    long long active = m_active;
+    if (m_running){
+        active += ChronosClock::stop_ticks() - m_resumed;
+    }// end of if
+    return active * ChronosClock::get_seconds_per_tick();
+}
+
+
+double ChronosSpan::get_latency() {
+    long long end = m_finished && m_site >= 0 ? m_end : ChronosClock::stop_ticks();
+    return (end - m_start) * ChronosClock::get_seconds_per_tick();
+}
+
+
+
+//Private Functions
+void ChronosSpan::leave_thread() {
+    // Normally the innermost span, but a parent may be suspended while its child still runs
+    for (long i = static_cast<long>(t_running.size()) - 1; i >= 0; i--){
+        if (t_running[i] == this){
+            t_running.erase(t_running.begin() + i);
+            return;
+        }// end of if
+    }// end of for
+}
@@ -0,0 +1,220 @@
+/**   Copyright 2020 Benrick Smit
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ * 
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+*/
+
+/**
+ * @author: Benrick Smit
+ * @email: metatronicprogramming@hotmail.com
+ * @date: 13 June 2020
+ * @modified: 13 June 2020
+ * 
+ * @brief: This class times an asynchronous operation, such as a coroutine, which may be suspended on one thread and resumed
+ *          on another. Where start and stop measure the wall time from the first to the last, a span keeps two times apart:
+ *          the active time, while the operation was running on some thread, and the latency, from its start to its end.
+ *          The timing pauses on suspend and carries on at resume, on whichever thread that is.
+ * 
+ *          The parent of a span is fixed when it is created: the span given, or the span running on the thread at the time.
+ *          Only the parent's site is kept, so the tree of operations stays intact across thread hops, and a child may outlive
+ *          its parent. Between two suspensions, the spans running on one thread should nest like scopes.
+ * 
+ *          With C++20 coroutines, chronos_await wraps an awaitable so the span is suspended and resumed around the co_await:
+ *          co_await chronos_await(span, socket.read(buffer));
+ * 
+ */ 
+
+#pragma once
+
+#include "Chronos.h"
+
+class ChronosSpan {
+	public:
+		//ctors and dtors
+		/**
+		 * @brief Construct a new Chronos Span object, which starts running on the calling thread, as a child of the span
+		 *          running on it, if there is one
+		 * 
+		 * @param site the handle returned by Chronos::register_site, a negative handle turns the span off
+		 */
+		explicit ChronosSpan(long site);
+		/**
+		 * @brief Construct a new Chronos Span object, which starts running on the calling thread
+		 * 
+		 * @param site the handle returned by Chronos::register_site, a negative handle turns the span off
+		 * @param parent the span of the operation this one is part of, or nullptr for a root span
+		 */
+		ChronosSpan(long site, ChronosSpan* parent);
+		/**
+		 * @brief Destroy the Chronos Span object, finishing the span if it was not finished yet
+		 * 
+		 */
+		~ChronosSpan();
+
+		ChronosSpan(const ChronosSpan&) = delete;
+		ChronosSpan& operator=(const ChronosSpan&) = delete;
+
+		//Basic Operation
+		/**
+		 * @brief Pauses the active time, when the operation is about to wait. Must be called on the thread the span runs on,
+		 *          before the operation can be resumed anywhere else.
+		 * 
+		 */
+		void suspend();
+		/**
+		 * @brief Takes back the last suspend, when the operation carried on at once without waiting: the time in between
+		 *          stays active, and the suspension is not counted. Does nothing if the span is running.
+		 * 
+		 */
+		void cancel_suspend();
+		/**
+		 * @brief Carries on the active time, on the calling thread, which counts as a hop if the span last ran on another.
+		 *          Does nothing if the span is running.
+		 * 
+		 */
+		void resume();
+		/**
+		 * @brief Ends the span, and adds it to the profiler's spans. Does nothing the second time.
+		 * 
+		 */
+		void finish();
+
+		//Getters
+		/**
+		 * @brief Get the span running on the calling thread
+		 * 
+		 * @return ChronosSpan* nullptr if there is none
+		 */
+		static ChronosSpan* get_current();
+		/**
+		 * @brief Get the site object
+		 * 
+		 * @return long 
+		 */
+		long get_site();
+		/**
+		 * @brief Get the site of the parent span
+		 * 
+		 * @return long -1 for a root span
+		 */
+		long get_parent_site();
+		/**
+		 * @brief Get the active time so far
+		 * 
+		 * @return double seconds
+		 */
+		double get_active_time();
+		/**
+		 * @brief Get the latency so far
+		 * 
+		 * @return double seconds
+		 */
+		double get_latency();
+
+	private:
+		// Takes the span off the list of spans running on the calling thread
+		void leave_thread();
+
+		//Member variables
+		Chronos* m_profiler;													// The profiler the span is added to
+		long m_site;															// Site of the span
+		long m_parent;															// Site of the parent span, -1 for a root
+		long long m_start;														// Clock ticks at the start of the span
+		long long m_resumed;													// Clock ticks at the last resume
+		long long m_active;														// Ticks the span ran before the last resume
+		long long m_suspended;													// Clock ticks at the last suspend
+		long long m_end;														// Clock ticks at the end of the span
+		long m_suspensions;														// Times the span was suspended
+		long m_hops;															// Times it was resumed on another thread
+		const void* m_thread;													// The thread the span last ran on
+		bool m_running;															// Whether the span is running on a thread
+		bool m_finished;														// Whether the span was added to the profiler
+};
+
+#if defined(__cpp_impl_coroutine) && __has_include(<coroutine>)
+
+#include <coroutine>
+#include <type_traits>
+#include <utility>
+
+/**
+ * @brief Wraps the awaiter of a co_await, suspending the span before the coroutine is handed on, and resuming it once the
+ *          coroutine carries on. An awaiter which is ready at once, or which carries on without suspending, leaves the span
+ *          running.
+ * 
+ */
+template <typename Awaiter>
+class ChronosAwaiter {
+	public:
+		ChronosAwaiter(ChronosSpan& span, Awaiter&& awaiter) : m_span(span), m_awaiter(std::forward<Awaiter>(awaiter)) {
+		}
+
+		bool await_ready() {
+			return m_awaiter.await_ready();
+		}
+		template <typename Promise>
+		auto await_suspend(std::coroutine_handle<Promise> handle) {
+			// Once the awaiter has the handle the coroutine may already run on another thread, so the span is only touched
+			// after it when the awaiter says the coroutine carries on here: false, or the coroutine's own handle back
+			using Result = decltype(m_awaiter.await_suspend(handle));
+			m_span.suspend();
+			if constexpr (std::is_same_v<Result, bool>){
+				bool suspended = m_awaiter.await_suspend(handle);
+				if (!suspended){
+					m_span.cancel_suspend();
+				}// end of if
+				return suspended;
+			}else if constexpr (std::is_void_v<Result>){
+				m_awaiter.await_suspend(handle);
+			}else{
+				auto next = m_awaiter.await_suspend(handle);
+				if (next.address() == handle.address()){
+					m_span.cancel_suspend();
+				}// end of if
+				return next;
+			}// end of if else
+		}
+		decltype(auto) await_resume() {
+			m_span.resume();
+			return m_awaiter.await_resume();
+		}
+
+	private:
+		ChronosSpan& m_span;
+		Awaiter m_awaiter;
+};
+
+// Whether an awaitable gives its awaiter through a member operator co_await
+template <typename Awaitable, typename = void>
+struct ChronosHasCoAwait : std::false_type {};
+template <typename Awaitable>
+struct ChronosHasCoAwait<Awaitable, std::void_t<decltype(std::declval<Awaitable>().operator co_await())>> : std::true_type {};
+
+/**
+ * @brief Wraps an awaitable so the span is suspended while the coroutine waits on it. The awaitable is either an awaiter
+ *          itself or gives one through a member operator co_await.
+ * 
+ * @param span the span of the awaiting coroutine
+ * @param awaitable 
+ * @return ChronosAwaiter to co_await on
+ */
+template <typename Awaitable>
+auto chronos_await(ChronosSpan& span, Awaitable&& awaitable) {
+	if constexpr (ChronosHasCoAwait<Awaitable>::value){
+		using Awaiter = decltype(std::forward<Awaitable>(awaitable).operator co_await());
+		return ChronosAwaiter<Awaiter>(span, std::forward<Awaitable>(awaitable).operator co_await());
+	}else{
+		return ChronosAwaiter<Awaitable>(span, std::forward<Awaitable>(awaitable));
+	}// end of if else
+}
+
+#endif
@@ -0,0 +1,203 @@
+/**   Copyright 2020 Benrick Smit
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ * 
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+*/
+
+/**
+ * @author: Benrick Smit
+ * @email: metatronicprogramming@hotmail.com
+ * @date: 13 June 2020
+ * @modified: 13 June 2020
+ * 
+ * @brief: This class gathers the spans of asynchronous operations, as they finish.
+ * 
+ */ 
+
+
+#include "ChronosSpanTable.h"
+
+#include <algorithm>
+#include <map>
+#include <set>
+
+#include "ChronosClock.h"
+
+
+// Converts clock ticks to seconds, as text
+static std::string seconds(long long ticks) {
+    return std::to_string(ticks * ChronosClock::get_seconds_per_tick());
+}
+
+// Converts clock ticks to whole nanoseconds, for the histograms
+static unsigned long long nanoseconds(long long ticks) {
+    return ticks <= 0 ? 0 : static_cast<unsigned long long>(ticks * ChronosClock::get_seconds_per_tick() * 1e9);
+}
+
+// The name of a site, or its handle if it is not known
+static std::string site_name(long site, std::vector<ChronosSiteName>& names) {
+    if (site >= 0 && site < static_cast<long>(names.size())){
+        return std::string(names[site].name);
+    }// end of if
+    return "site " + std::to_string(site);
+}
+
+// The columns both reports share, from the spans to the share of their latency they were running, as a fraction
+static std::string columns(ChronosSpanData& span, const std::string& separator) {
+    double spans = span.spans > 0 ? static_cast<double>(span.spans) : 1.0;
+    double share = span.latency > 0 ? static_cast<double>(span.active) / span.latency : 1.0;
+    // The percentiles are kept within the exact extremes, which the middle of a bucket may lie outside of
+    unsigned long long min_active = nanoseconds(span.min_active);
+    unsigned long long max_active = nanoseconds(span.max_active);
+    unsigned long long min_latency = nanoseconds(span.min_latency);
+    unsigned long long max_latency = nanoseconds(span.max_latency);
+    return std::to_string(span.spans) + separator + std::to_string(span.suspensions) + separator + std::to_string(span.hops)
+           + separator + seconds(span.active) + separator + seconds(static_cast<long long>(span.active / spans))
+           + separator + std::to_string(span.active_histogram.get_percentile(99, min_active, max_active) * 1e-9)
+           + separator + seconds(span.latency) + separator + seconds(static_cast<long long>(span.latency / spans))
+           + separator + std::to_string(span.latency_histogram.get_percentile(50, min_latency, max_latency) * 1e-9)
+           + separator + std::to_string(span.latency_histogram.get_percentile(99, min_latency, max_latency) * 1e-9)
+           + separator + seconds(span.max_latency) + separator + std::to_string(share);
+}
+
+// Appends a span and, indented below it, its children. A site already on the path is not followed again.
+static void append_tree(std::string& to_return, std::vector<ChronosSpanData>& spans, std::map<long, std::vector<long>>& children,
+                        std::vector<ChronosSiteName>& names, long index, std::vector<long>& path) {
+    ChronosSpanData& span = spans[index];
+    bool recursive = std::find(path.begin(), path.end(), span.site) != path.end();
+    to_return += columns(span, "\t\t") + "\t\t" + std::string(2 * path.size(), ' ') + site_name(span.site, names)
+                 + (recursive ? " (recursive)" : "") + '\n';
+    auto found = children.find(span.site);
+    if (recursive || found == children.end()){
+        return;
+    }// end of if
+    path.push_back(span.site);
+    for (long child: found->second){
+        append_tree(to_return, spans, children, names, child, path);
+    }// end of for
+    path.pop_back();
+}
+
+
+
+//Ctors and Dtors
+ChronosSpanTable::ChronosSpanTable() {
+}
+
+
+ChronosSpanTable::~ChronosSpanTable() {
+}
+
+
+
+//Basic Functionality
+void ChronosSpanTable::add(const ChronosSpanRecord& record) {
+    unsigned long long key = (static_cast<unsigned long long>(record.parent + 1) << 32) | static_cast<unsigned long long>(record.site);
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto found = m_index.find(key);
+    if (found == m_index.end()){
+        found = m_index.emplace(key, static_cast<long>(m_spans.size())).first;
+        m_spans.emplace_back();
+        ChronosSpanData& span = m_spans.back();
+        span.site = record.site;
+        span.parent = record.parent;
+        span.spans = 0;
+        span.suspensions = 0;
+        span.hops = 0;
+        span.active = 0;
+        span.min_active = record.active;
+        span.max_active = record.active;
+        span.latency = 0;
+        span.min_latency = record.latency;
+        span.max_latency = record.latency;
+    }// end of if
+    ChronosSpanData& span = m_spans[found->second];
+    span.spans++;
+    span.suspensions += record.suspensions;
+    span.hops += record.hops;
+    span.active += record.active;
+    span.latency += record.latency;
+    span.min_active = std::min(span.min_active, record.active);
+    span.max_active = std::max(span.max_active, record.active);
+    span.min_latency = std::min(span.min_latency, record.latency);
+    span.max_latency = std::max(span.max_latency, record.latency);
+    span.active_histogram.add_value(nanoseconds(record.active));
+    span.latency_histogram.add_value(nanoseconds(record.latency));
+}
+
+
+std::vector<ChronosSpanData> ChronosSpanTable::snapshot() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_spans;
+}
+
+
+bool ChronosSpanTable::is_empty() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_spans.empty();
+}
+
+
+
+//Display
+std::string ChronosSpanTable::get_header_csv() {
+    return "Site,Parent Site,Spans,Suspensions,Thread Hops,Active Time,Mean Active Time,P99 Active Time,Latency,Mean Latency,"
+           "P50 Latency,P99 Latency,Max Latency,Active Share,Span";
+}
+
+
+std::string ChronosSpanTable::to_csv(std::vector<ChronosSpanData>& spans, std::vector<ChronosSiteName>& names) {
+    std::string to_return;
+    for (ChronosSpanData& span: spans){
+        to_return += std::to_string(span.site) + ',' + std::to_string(span.parent) + ',' + columns(span, ",") + ','
+                     + site_name(span.site, names) + '\n';
+    }// end of for
+    return to_return;
+}
+
+
+std::string ChronosSpanTable::to_string(std::vector<ChronosSpanData>& spans, std::vector<ChronosSiteName>& names) {
+    // Gather the children of every site, the longest latency first
+    std::vector<long> order(spans.size());
+    for (unsigned long i = 0; i < spans.size(); i++){
+        order[i] = static_cast<long>(i);
+    }// end of for
+    std::sort(order.begin(), order.end(), [&spans](long a, long b){
+        return spans[a].latency > spans[b].latency;
+    });
+    std::map<long, std::vector<long>> children;
+    for (long index: order){
+        children[spans[index].parent].push_back(index);
+    }// end of for
+
+    std::string to_return = "Spans\t\tSuspensions\t\tThread Hops\t\tActive Time\t\tMean Active Time\t\tP99 Active Time\t\tLatency\t\t"
+                            "Mean Latency\t\tP50 Latency\t\tP99 Latency\t\tMax Latency\t\tActive Share\t\tSpan\n";
+    std::vector<long> path;
+    auto roots = children.find(-1);
+    if (roots != children.end()){
+        for (long index: roots->second){
+            append_tree(to_return, spans, children, names, index, path);
+        }// end of for
+    }// end of if
+    // Spans whose parent never finished, or finished in another run, are shown at the top level as well
+    std::set<long> finished;
+    for (ChronosSpanData& span: spans){
+        finished.insert(span.site);
+    }// end of for
+    for (long index: order){
+        long parent = spans[index].parent;
+        if (parent >= 0 && finished.count(parent) == 0){
+            append_tree(to_return, spans, children, names, index, path);
+        }// end of if
+    }// end of for
+    return to_return;
+}
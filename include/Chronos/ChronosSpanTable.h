@@ -0,0 +1,137 @@
+/**   Copyright 2020 Benrick Smit
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ * 
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+*/
+
+/**
+ * @author: Benrick Smit
+ * @email: metatronicprogramming@hotmail.com
+ * @date: 13 June 2020
+ * @modified: 13 June 2020
+ * 
+ * @brief: This class gathers the spans of asynchronous operations, as they finish, from whichever thread finishes them.
+ *          A span is kept per site and parent site, so the tree of operations survives however the work hopped between
+ *          threads: the time the operation was running, the time from its start to its end, how often it was suspended and
+ *          how often it came back on another thread. Spans finish once per operation, rather than once per call, so they are
+ *          added under a lock.
+ * 
+ */ 
+
+#pragma once
+
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "ChronosArena.h"
+#include "ChronosHistogram.h"
+
+/**
+ * @brief A finished span, as handed to the table
+ * 
+ */
+struct ChronosSpanRecord {
+    long site;                                                              // Site of the span
+    long parent;                                                            // Site of the parent span, -1 for a root
+    long suspensions;                                                       // Times the span was suspended
+    long hops;                                                              // Times it was resumed on another thread
+    long long active;                                                       // Ticks the span was running
+    long long latency;                                                      // Ticks from its start to its end
+};
+
+/**
+ * @brief The spans of one site under one parent site, with the times in clock ticks and the histograms in nanoseconds
+ * 
+ */
+struct ChronosSpanData {
+    long site;
+    long parent;
+    long spans;
+    long suspensions;
+    long hops;
+    long long active;
+    long long min_active;
+    long long max_active;
+    long long latency;
+    long long min_latency;
+    long long max_latency;
+    ChronosHistogram active_histogram;
+    ChronosHistogram latency_histogram;
+};
+
+class ChronosSpanTable {
+	public:
+		//ctors and dtors
+		/**
+		 * @brief Construct a new Chronos Span Table object, which is empty
+		 * 
+		 */
+		ChronosSpanTable();
+		/**
+		 * @brief Destroy the Chronos Span Table object
+		 * 
+		 */
+		~ChronosSpanTable();
+
+		//Basic Operation
+		/**
+		 * @brief Adds a finished span. Safe to call from any thread.
+		 * 
+		 * @param record 
+		 */
+		void add(const ChronosSpanRecord& record);
+		/**
+		 * @brief Copies the spans, one entry per site and parent site
+		 * 
+		 * @return std::vector<ChronosSpanData> 
+		 */
+		std::vector<ChronosSpanData> snapshot();
+		/**
+		 * @brief Whether no span has finished yet
+		 * 
+		 * @return true 
+		 * @return false 
+		 */
+		bool is_empty();
+
+		//Display
+		/**
+		 * @brief Get the header of the CSV rows, in which the name of the span is the last column
+		 * 
+		 * @return std::string 
+		 */
+		static std::string get_header_csv();
+		/**
+		 * @brief Writes the spans as CSV rows, the parent given by its site so the name can stay the last column
+		 * 
+		 * @param spans 
+		 * @param names the name of every site, indexed by the site handle
+		 * @return std::string 
+		 */
+		static std::string to_csv(std::vector<ChronosSpanData>& spans, std::vector<ChronosSiteName>& names);
+		/**
+		 * @brief Writes the spans as a tree, every child indented below its parent, the longest latency first
+		 * 
+		 * @param spans 
+		 * @param names the name of every site, indexed by the site handle
+		 * @return std::string 
+		 */
+		static std::string to_string(std::vector<ChronosSpanData>& spans, std::vector<ChronosSiteName>& names);
+
+	private:
+		//Member variables
+		std::mutex m_mutex;														// Guards the spans
+		std::vector<ChronosSpanData> m_spans;									// One entry per site and parent site
+		std::unordered_map<unsigned long long, long> m_index;					// Maps the parent and site pair to its entry
+};
@@ -0,0 +1,382 @@
+/**   Copyright 2020 Benrick Smit
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ * 
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+*/
+
+/**
+ * @author: Benrick Smit
+ * @email: metatronicprogramming@hotmail.com
+ * @date: 13 June 2020
+ * @modified: 13 June 2020
+ * 
+ * @brief: This class holds the recording buffer of a single thread. Only the owning thread ever writes to it, so the
+ *          start and stop calls need no locks.
+ * 
+ */ 
+
+
+#include "ChronosThread.h"
+
+#if defined(__linux__)
+#include <sys/resource.h>
+#include <time.h>
+#endif
+
+
+// Reads the CPU time and context switches of the calling thread. The CPU clock is read last at the start of a call and
+// first at its end, nearest the wall clock, so the context switches are read outside the call's CPU time
+static bool read_cpu(ChronosCpuSample& sample, bool at_start) {
+#if defined(__linux__)
+    timespec time;
+    rusage usage;
+    if (at_start && getrusage(RUSAGE_THREAD, &usage) != 0){
+        return false;
+    }// end of if
+    if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &time) != 0){
+        return false;
+    }// end of if
+    if (!at_start && getrusage(RUSAGE_THREAD, &usage) != 0){
+        return false;
+    }// end of if
+    sample.cpu_time = static_cast<long long>(time.tv_sec) * 1000000000ll + time.tv_nsec;
+    sample.voluntary = usage.ru_nvcsw;
+    sample.involuntary = usage.ru_nivcsw;
+    return true;
+#else
+    (void)sample;
+    (void)at_start;
+    return false;
+#endif
+}
+
+
+//Ctors and Dtors
+ChronosThread::ChronosThread(long thread_id, ChronosSampler* sampler) {
+    m_thread_id = thread_id;
+    m_sampler = sampler;
+    for (long i = 0; i < k_max_blocks; i++){
+        m_blocks[i].store(nullptr, std::memory_order_relaxed);
+    }// end of for
+    for (long i = 0; i < k_max_node_blocks; i++){
+        m_node_blocks[i].store(nullptr, std::memory_order_relaxed);
+    }// end of for
+    m_node_count.store(0, std::memory_order_relaxed);
+    m_trace.store(nullptr, std::memory_order_relaxed);
+    m_shared.store(nullptr, std::memory_order_relaxed);
+    m_counting.store(false, std::memory_order_relaxed);
+    m_live_bytes = 0;
+    m_timed_calls = 0;
+    m_untimed_calls = 0;
+    m_internal = false;
+    // Every thread starts its countdowns somewhere else, and the state must never be 0
+    m_random = (static_cast<unsigned long long>(std::chrono::steady_clock::now().time_since_epoch().count()) ^
+                (static_cast<unsigned long long>(thread_id) + 1) * 0x9E3779B97F4A7C15ull) | 1;
+    // The root of the call tree
+    add_node(-1, -1);
+    m_stack.reserve(64);
+}
+
+ChronosThread::~ChronosThread() {
+    for (long i = 0; i < k_max_blocks; i++){
+        ChronosSiteBlock* block = m_blocks[i].load(std::memory_order_relaxed);
+        if (block == nullptr){
+            continue;
+        }// end of if
+        for (long site = 0; site < k_block_size; site++){
+            delete[] block->stats[site].histogram.load(std::memory_order_relaxed);
+        }// end of for
+        delete block;
+    }// end of for
+    for (long i = 0; i < k_max_node_blocks; i++){
+        delete[] m_node_blocks[i].load(std::memory_order_relaxed);
+    }// end of for
+}
+
+//Getters
+long ChronosThread::get_thread_id() {
+    return m_thread_id;
+}
+
+//Basic Functionality
+bool ChronosThread::read_site(long site, ChronosProcess& process) {
+    unsigned long index = static_cast<unsigned long>(site) / k_block_size;
+    if (index >= static_cast<unsigned long>(k_max_blocks)){
+        return false;
+    }// end of if
+    ChronosSiteBlock* block = m_blocks[index].load(std::memory_order_acquire);
+    if (block == nullptr){
+        return false;
+    }// end of if
+    ChronosSiteStats* stats = &block->stats[site % k_block_size];
+    ChronosSiteDetail* detail = &block->details[site % k_block_size];
+
+    long calls = stats->calls.load(std::memory_order_relaxed);
+    long timed = stats->timed.load(std::memory_order_relaxed);
+    if (calls == 0){
+        return false;
+    }// end of if
+
+    // Convert the clock ticks into seconds. The mean and spread are those of the timed calls, which stand for all of the calls,
+    // so the sum of squares is scaled to all of them. The total is the same mean over the calls, less the untimed ones made
+    // inside a timed call of the same site, as a recursive function makes, since their time is already part of it
+    double period = ChronosClock::get_seconds_per_tick();
+    long extrapolated = calls - detail->covered.load(std::memory_order_relaxed);
+    extrapolated = extrapolated < timed ? timed : extrapolated;
+    double mean = timed > 0 ? stats->total.load(std::memory_order_relaxed) * period / timed : 0;
+    process.set_total_calls(calls);
+    process.set_timed_calls(timed);
+    process.set_total_time(mean * extrapolated);
+    process.set_min_time(timed > 0 ? stats->min.load(std::memory_order_relaxed) * period : 0);
+    process.set_max_time(stats->max.load(std::memory_order_relaxed) * period);
+    process.set_mean_time(mean);
+    double scale = timed > 0 ? static_cast<double>(calls) / timed : 0;
+    process.set_sum_squares(stats->sum_squares.load(std::memory_order_relaxed) * period * period * scale);
+    process.set_thread_id(m_thread_id);
+
+    // Move the buckets from clock ticks to nanoseconds
+    std::atomic<unsigned long long>* buckets = stats->histogram.load(std::memory_order_acquire);
+    ChronosHistogram histogram;
+    for (long i = 0; buckets != nullptr && i < ChronosHistogram::k_bucket_count; i++){
+        unsigned long long count = buckets[i].load(std::memory_order_relaxed);
+        if (count > 0){
+            double nanoseconds = ChronosHistogram::bucket_value(i) * period * 1e9;
+            histogram.add(ChronosHistogram::bucket_index(static_cast<unsigned long long>(nanoseconds)), count);
+        }// end of if
+    }// end of for
+    process.set_histogram(histogram);
+
+    // The hardware counters, for the calls they were read for
+    unsigned long long counters[ChronosCounters::k_counter_count];
+    for (int i = 0; i < ChronosCounters::k_counter_count; i++){
+        counters[i] = detail->counters[i].load(std::memory_order_relaxed);
+    }// end of for
+    process.set_counters(counters, detail->counted.load(std::memory_order_relaxed));
+    process.set_allocations(detail->allocations.load(std::memory_order_relaxed), detail->allocated_bytes.load(std::memory_order_relaxed),
+                            detail->peak_live_bytes.load(std::memory_order_relaxed));
+    // The CPU time, for the calls it was read for
+    process.set_cpu_time(detail->cpu_calls.load(std::memory_order_relaxed), detail->cpu_time.load(std::memory_order_relaxed) * 1e-9,
+                         detail->cpu_wall.load(std::memory_order_relaxed) * period, detail->voluntary_switches.load(std::memory_order_relaxed),
+                         detail->involuntary_switches.load(std::memory_order_relaxed));
+    return true;
+}
+
+long ChronosThread::get_node_count() {
+    return m_node_count.load(std::memory_order_acquire);
+}
+
+void ChronosThread::read_node(long index, ChronosNodeData& node) {
+    ChronosNode* source = m_node_blocks[index / k_node_block_size].load(std::memory_order_acquire) + (index % k_node_block_size);
+    node.site = source->site;
+    node.parent = source->parent;
+    node.calls = source->calls.load(std::memory_order_relaxed);
+    node.timed = source->timed.load(std::memory_order_relaxed);
+    // Every timed call was weighed by the calls it stood for when it stopped, so the sums already cover the whole path
+    node.inclusive = static_cast<long long>(source->weighted.load(std::memory_order_relaxed));
+    node.weight = source->weight.load(std::memory_order_relaxed);
+    node.timed_below = source->timed_below.load(std::memory_order_relaxed);
+    node.untimed_below = source->untimed_below.load(std::memory_order_relaxed);
+}
+
+ChronosTraceBuffer* ChronosThread::enable_trace(unsigned long capacity) {
+    if (m_trace_storage == nullptr){
+        m_trace_storage = std::make_unique<ChronosTraceBuffer>(m_thread_id, capacity);
+    }// end of if
+    m_trace.store(m_trace_storage.get(), std::memory_order_release);
+    return m_trace_storage.get();
+}
+
+void ChronosThread::disable_trace() {
+    m_trace.store(nullptr, std::memory_order_release);
+}
+
+void ChronosThread::enable_shared(ChronosShared* shared) {
+    m_shared.store(shared, std::memory_order_release);
+}
+
+void ChronosThread::enable_counters(bool enabled) {
+    m_counting.store(enabled, std::memory_order_relaxed);
+}
+
+long ChronosThread::find_cached_site(const std::string& key) {
+    auto found = m_site_cache.find(key);
+    if (found == m_site_cache.end()){
+        return -1;
+    }// end of if
+    return found->second;
+}
+
+void ChronosThread::cache_site(const std::string& key, long site) {
+    m_internal = true;
+    m_site_cache.emplace(key, site);
+    m_internal = false;
+}
+
+//Private Functions
+long ChronosThread::adapt_period(long site, ChronosSiteDetail* detail, long long now) {
+    long period = detail->period > 0 ? detail->period : m_sampler->get_period(site);
+    if (detail->window_start > 0){
+        // The window holds one timed call, and period calls in all
+        long long window = now - detail->window_start;
+        long long min_window = m_sampler->get_min_window();
+        if (window < min_window && period < ChronosSampler::k_max_period){
+            period *= 2;
+        }else if (window > 4 * min_window && period > m_sampler->get_period(site)){
+            period /= 2;
+        }// end of if else
+    }// end of if
+    detail->window_start = now;
+    detail->period = period;
+    return period;
+}
+
+long ChronosThread::add_node(long parent, long site) {
+    long index = m_node_count.load(std::memory_order_relaxed);
+    long block = index / k_node_block_size;
+    if (block >= k_max_node_blocks){
+        return -1;
+    }// end of if
+    ChronosNode* nodes = m_node_blocks[block].load(std::memory_order_relaxed);
+    if (nodes == nullptr){
+        m_internal = true;
+        nodes = new ChronosNode[k_node_block_size]();
+        m_internal = false;
+        m_node_blocks[block].store(nodes, std::memory_order_release);
+    }// end of if
+
+    ChronosNode* node = nodes + (index % k_node_block_size);
+    node->site = static_cast<int>(site);
+    node->parent = static_cast<int>(parent);
+    node->first_child = -1;
+    node->next_sibling = -1;
+    if (parent >= 0){
+        // Link the node in front of its siblings
+        ChronosNode* parent_node = get_node(parent);
+        node->next_sibling = parent_node->first_child;
+        parent_node->first_child = static_cast<int>(index);
+    }// end of if
+    m_node_count.store(index + 1, std::memory_order_release);
+    return index;
+}
+
+bool ChronosThread::unwind_to(long site) {
+    for (long i = static_cast<long>(m_stack.size()) - 1; i >= 0; i--){
+        if (m_stack[i].site == site){
+            // The timed calls dropped are no longer running
+            for (unsigned long dropped = i + 1; dropped < m_stack.size(); dropped++){
+                if (m_stack[dropped].start >= 0){
+                    get_block(m_stack[dropped].site)->paths[m_stack[dropped].site % k_block_size].active--;
+                }// end of if
+            }// end of for
+            m_stack.resize(i + 1);
+            return true;
+        }// end of if
+    }// end of for
+    return false;
+}
+
+long ChronosThread::start_counters() {
+    m_internal = true;
+    if (m_counters == nullptr){
+        m_counters = std::make_unique<ChronosCounters>();
+        if (!m_counters->open()){
+            // The counters are not available to this thread, so stop asking
+            m_counting.store(false, std::memory_order_relaxed);
+        }// end of if
+    }// end of if
+    if (!m_counters->is_open()){
+        m_internal = false;
+        return -1;
+    }// end of if
+    long entry = static_cast<long>(m_counter_stack.size()) / ChronosCounters::k_counter_count;
+    m_counter_stack.resize(m_counter_stack.size() + ChronosCounters::k_counter_count);
+    m_internal = false;
+    m_counters->read(&m_counter_stack[entry * ChronosCounters::k_counter_count]);
+    return entry;
+}
+
+void ChronosThread::stop_counters(long site, long entry) {
+    ChronosSiteDetail* detail = get_detail(site);
+    unsigned long long values[ChronosCounters::k_counter_count];
+    m_counters->read(values);
+    unsigned long long* start = &m_counter_stack[entry * ChronosCounters::k_counter_count];
+    for (int i = 0; i < ChronosCounters::k_counter_count; i++){
+        unsigned long long delta = values[i] >= start[i] ? values[i] - start[i] : 0;
+        detail->counters[i].store(detail->counters[i].load(std::memory_order_relaxed) + delta, std::memory_order_relaxed);
+    }// end of for
+    detail->counted.store(detail->counted.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    // Drops the entries of calls above this one which were never stopped as well
+    m_counter_stack.resize(entry * ChronosCounters::k_counter_count);
+}
+
+long ChronosThread::start_cpu() {
+    ChronosCpuSample sample;
+    if (!read_cpu(sample, true)){
+        return -1;
+    }// end of if
+    long entry = static_cast<long>(m_cpu_stack.size());
+    m_internal = true;
+    m_cpu_stack.push_back(sample);
+    m_internal = false;
+    return entry;
+}
+
+void ChronosThread::stop_cpu(long site, long entry, long long elapsed) {
+    ChronosCpuSample sample;
+    if (read_cpu(sample, false)){
+        ChronosCpuSample& start = m_cpu_stack[entry];
+        ChronosSiteDetail* detail = get_detail(site);
+        // The CPU clock is still read just outside the wall clock, so a short call could be on the CPU for longer than it took
+        long long cpu_time = sample.cpu_time - start.cpu_time;
+        long long wall_time = static_cast<long long>(elapsed * ChronosClock::get_seconds_per_tick() * 1e9);
+        cpu_time = cpu_time < wall_time ? cpu_time : wall_time;
+        detail->cpu_time.store(detail->cpu_time.load(std::memory_order_relaxed) + (cpu_time > 0 ? cpu_time : 0), std::memory_order_relaxed);
+        detail->cpu_wall.store(detail->cpu_wall.load(std::memory_order_relaxed) + (elapsed > 0 ? elapsed : 0), std::memory_order_relaxed);
+        detail->voluntary_switches.store(detail->voluntary_switches.load(std::memory_order_relaxed) + sample.voluntary - start.voluntary,
+                                         std::memory_order_relaxed);
+        detail->involuntary_switches.store(detail->involuntary_switches.load(std::memory_order_relaxed) + sample.involuntary - start.involuntary,
+                                           std::memory_order_relaxed);
+        detail->cpu_calls.store(detail->cpu_calls.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }// end of if
+    // Drops the entries of calls above this one which were never stopped as well
+    m_cpu_stack.resize(entry);
+}
+
+void ChronosThread::grow_stack() {
+    m_internal = true;
+    m_stack.reserve(m_stack.capacity() * 2 + 1);
+    m_internal = false;
+}
+
+std::atomic<unsigned long long>* ChronosThread::allocate_histogram(ChronosSiteStats* stats) {
+    m_internal = true;
+    std::atomic<unsigned long long>* histogram = new std::atomic<unsigned long long>[ChronosHistogram::k_bucket_count]();
+    m_internal = false;
+    stats->histogram.store(histogram, std::memory_order_release);
+    return histogram;
+}
+
+ChronosSiteBlock* ChronosThread::allocate_block(unsigned long index) {
+    m_internal = true;
+    ChronosSiteBlock* block = new ChronosSiteBlock();
+    m_internal = false;
+    for (long i = 0; i < k_block_size; i++){
+        // No node until the first call, so a call made below a frame outside the full tree is never put on the root
+        block->paths[i].parent = -1;
+        block->paths[i].node = -1;
+        // Start the countdown of every site at a random phase of its period, so the threads do not all time the same calls
+        long period = m_sampler->get_period(static_cast<long>(index) * k_block_size + i);
+        block->stats[i].countdown = period > 1 ? 1 + static_cast<long>(next_random() % static_cast<unsigned long long>(period)) : 0;
+    }// end of for
+    m_blocks[index].store(block, std::memory_order_release);
+    return block;
+}
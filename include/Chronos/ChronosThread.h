@@ -0,0 +1,690 @@
+/**   Copyright 2020 Benrick Smit
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ * 
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+*/
+
+/**
+ * @author: Benrick Smit
+ * @email: metatronicprogramming@hotmail.com
+ * @date: 13 June 2020
+ * @modified: 13 June 2020
+ * 
+ * @brief: This class holds the recording buffer of a single thread. Only the owning thread ever writes to it, so the
+ *          start and stop calls need no locks. The statistics are kept in relaxed atomics, which compile to plain loads and
+ *          stores, so that the Chronos class can merge the buffers of all the threads while they are still recording.
+ *          The sites are stored in blocks laid out as a structure of arrays: the statistics every call updates take one
+ *          cache line per site, apart from the call tree shortcuts and the state only the timed, counted or allocating calls
+ *          need. The blocks, nodes and the buffer itself are aligned to cache lines, so no two threads ever write to the same one.
+ *          The sites asked to through ChronosSampler read the thread's CPU time and context switches around their timed calls.
+ * 
+ */ 
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "ChronosProcess.h"
+#include "ChronosClock.h"
+#include "ChronosTraceBuffer.h"
+#include "ChronosHistogram.h"
+#include "ChronosSampler.h"
+#include "ChronosCounters.h"
+#include "ChronosShared.h"
+
+// Bytes per cache line on x86 and most ARM cores
+const long k_cache_line_size = 64;
+
+/**
+ * @brief The statistics of one call site, as recorded by one thread, which every call updates. They fill exactly one cache
+ *          line. The times are kept in the integer ticks of ChronosClock, and only converted to seconds when they are read out.
+ * 
+ */
+struct alignas(k_cache_line_size) ChronosSiteStats {
+    std::atomic<long> calls;                                                // Number of completed calls, timed or not
+    std::atomic<long> timed;                                                // Number of completed calls that were timed
+    std::atomic<long long> total;                                           // Total ticks spent in the site
+    std::atomic<long long> min;                                             // Shortest call, only valid when calls > 0
+    std::atomic<long long> max;                                             // Longest call
+    std::atomic<double> sum_squares;                                        // Sum of the squared calls, for the deviation
+    std::atomic<std::atomic<unsigned long long>*> histogram;               // ChronosHistogram buckets in ticks, allocated on first use
+    long countdown;                                                         // Calls left until the next timed one, owner only
+};
+
+static_assert(sizeof(ChronosSiteStats) == k_cache_line_size, "The statistics of a site should fill one cache line");
+
+/**
+ * @brief Where the last call to a site was made from, which saves the owning thread walking the siblings in the call tree
+ *          when the site is called from the same place again, and how many timed calls of the site are running. Only used by
+ *          the owning thread.
+ * 
+ */
+struct ChronosSitePath {
+    long parent;                                                            // Caller node of the last call, -1 before the first
+    long node;                                                              // Call tree node of the last call, -1 before the first
+    long active;                                                            // Timed calls of the site on the shadow stack
+};
+
+/**
+ * @brief The state of a site that only the adaptive sampling, the hardware counters and the allocation hooks need
+ * 
+ */
+struct ChronosSiteDetail {
+    long period;                                                            // Current sample period, owner only
+    long long window_start;                                                 // Start of the last timed call, for the adaptive mode
+    std::atomic<long> allocations;                                          // Allocations made by the site itself
+    std::atomic<long long> allocated_bytes;                                 // Bytes asked for by those allocations
+    std::atomic<long long> peak_live_bytes;                                 // Most bytes in use during one call, callees included
+    std::atomic<long> counted;                                              // Number of timed calls the hardware counters were read for
+    std::atomic<unsigned long long> counters[ChronosCounters::k_counter_count]; // Hardware counter totals of those calls
+    std::atomic<long> cpu_calls;                                            // Number of timed calls the CPU time was read for
+    std::atomic<long long> cpu_time;                                        // CPU nanoseconds of those calls
+    std::atomic<long long> cpu_wall;                                        // Ticks of those calls
+    std::atomic<long> voluntary_switches;                                   // Context switches made by those calls while waiting
+    std::atomic<long> involuntary_switches;                                 // Context switches forced on those calls
+    std::atomic<long> covered;                                              // Untimed calls made inside a timed call of the site
+};
+
+/**
+ * @brief A block of sites, as a structure of arrays. It is allocated zeroed on the first call to one of its sites, and never
+ *          moves after that, so the readers need no lock.
+ * 
+ */
+struct ChronosSiteBlock {
+    static const long k_size = 256;                                         // Sites per block
+
+    ChronosSiteStats stats[k_size];
+    ChronosSitePath paths[k_size];
+    ChronosSiteDetail details[k_size];
+};
+
+/**
+ * @brief A node of the thread's call tree. Every distinct path of call sites from the root gets its own node, so a recursive
+ *          call is a child of the call it was made from. The site and parent are written before the node is published through
+ *          the node count; the links to the children are only ever used by the owning thread. A node takes one cache line.
+ * 
+ */
+struct alignas(k_cache_line_size) ChronosNode {
+    int site;                                                               // Site of the node, -1 for the root
+    int parent;                                                             // Index of the parent node, -1 for the root
+    int first_child;                                                        // Owner only
+    int next_sibling;                                                       // Owner only
+    std::atomic<long> calls;                                                // Number of completed calls along this path
+    std::atomic<long> timed;                                                // Number of those calls that were timed
+    // Every timed call is weighed by the calls its sample period stood for, so the sums cover all of the path's calls
+    std::atomic<double> weighted;                                           // Ticks of the timed calls, children included
+    std::atomic<double> weight;                                             // Calls the timed calls stood for
+    std::atomic<double> timed_below;                                        // Timed calls made inside the timed calls
+    std::atomic<double> untimed_below;                                      // Untimed calls made inside the timed calls
+};
+
+static_assert(sizeof(ChronosNode) == k_cache_line_size, "A node of the call tree should fill one cache line");
+
+/**
+ * @brief A copy of a node, as read by the report
+ * 
+ */
+struct ChronosNodeData {
+    long site;
+    long parent;
+    long calls;
+    long timed;
+    long long inclusive;                                                    // Ticks of all the calls, estimated from the timed ones
+    double weight;                                                          // Calls the timed calls stood for
+    double timed_below;                                                     // Timed calls below them, weighed the same way
+    double untimed_below;                                                   // Untimed calls below them, weighed the same way
+};
+
+/**
+ * @brief The thread's CPU time and context switches, read at the start of a call
+ * 
+ */
+struct ChronosCpuSample {
+    long long cpu_time;                                                     // CPU nanoseconds of the thread
+    long voluntary;                                                         // Context switches made while waiting
+    long involuntary;                                                       // Context switches forced by the scheduler
+};
+
+/**
+ * @brief An entry of the thread's shadow stack of running calls
+ * 
+ */
+struct ChronosFrame {
+    long site;                                                              // Site of the running call
+    long node;                                                              // Node of the call tree, -1 when the tree is full
+    long long start;                                                        // Clock ticks at the start of the call, -1 if not timed
+    long counters;                                                          // Entry of the counter stack, -1 if not counted
+    long cpu;                                                               // Entry of the CPU time stack, -1 if not read
+    long weight;                                                            // Calls of the site the timed call stands for
+    long timed_mark;                                                        // Timed calls the thread had started at the start
+    long untimed_mark;                                                      // Untimed calls the thread had started at the start
+    long long live_start;                                                   // Bytes in use on the thread when the call started
+    long long live_peak;                                                    // Most bytes in use on the thread during the call
+};
+
+class alignas(k_cache_line_size) ChronosThread {
+	public:
+		//ctors and dtors
+		/**
+		 * @brief Construct a new Chronos Thread object
+		 * 
+		 * @param thread_id the index of the thread, in the order the threads first used the profiler
+		 * @param sampler the sampling settings of the profiler
+		 */
+		ChronosThread(long thread_id, ChronosSampler* sampler);
+		/**
+		 * @brief Destroy the Chronos Thread object, and release the site blocks
+		 * 
+		 */
+		~ChronosThread();
+
+		ChronosThread(const ChronosThread&) = delete;
+		ChronosThread& operator=(const ChronosThread&) = delete;
+
+		//Getters
+		/**
+		 * @brief Get the thread id object
+		 * 
+		 * @return long 
+		 */
+		long get_thread_id();
+
+		//Basic Operation
+		/**
+		 * @brief Pushes a call to the site onto the shadow stack, and records its start time. May only be called by the owning
+		 *          thread.
+		 * 
+		 * @param site the handle returned by Chronos::register_site
+		 */
+		inline void start(long site) {
+			ChronosSiteBlock* block = get_block(site);
+			if (block == nullptr){
+				return;
+			}// end of if
+			ChronosSiteStats* stats = &block->stats[site % k_block_size];
+			ChronosSitePath& path = block->paths[site % k_block_size];
+			long parent = m_stack.empty() ? 0 : m_stack.back().node;
+			long node = -1;
+			if (parent == path.parent){
+				// Called from the same place as last time, which saves walking the siblings
+				node = path.node;
+			}else if (parent >= 0){
+				node = find_child(parent, site);
+				path.parent = parent;
+				path.node = node;
+			}// end of if else
+			if (--stats->countdown > 0){
+				// Not sampled, the call is only counted
+				m_untimed_calls++;
+				if (path.active > 0){
+					// Its time is already part of the timed call it is nested in, so it is left out of the extrapolation
+					ChronosSiteDetail* detail = &block->details[site % k_block_size];
+					detail->covered.store(detail->covered.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+					ChronosShared* shared = m_shared.load(std::memory_order_relaxed);
+					if (shared != nullptr){
+						shared->cover(site);
+					}// end of if
+				}// end of if
+				push_frame({site, node, -1, -1, -1, 0, 0, 0, m_live_bytes, m_live_bytes});
+				ChronosTraceBuffer* trace = m_trace.load(std::memory_order_relaxed);
+				if (trace != nullptr){
+					// The trace holds every call, so the clock is read for it alone
+					trace->push(site, k_trace_begin, ChronosClock::start_ticks());
+				}// end of if
+				return;
+			}// end of if
+			path.active++;
+			// The call was picked at the period in force before this one, and stands for that many calls in the call tree
+			ChronosSiteDetail* detail = &block->details[site % k_block_size];
+			long weight = m_sampler->is_adaptive(site) && detail->period > 0 ? detail->period : m_sampler->get_period(site);
+			// Read from the outside in, so the clock is nearest the call and the CPU time next to it
+			long counters = m_counting.load(std::memory_order_relaxed) ? start_counters() : -1;
+			long cpu = m_sampler->is_cpu_timed(site) ? start_cpu() : -1;
+			long long now = ChronosClock::start_ticks();
+			stats->countdown = next_period(site, now);
+			m_timed_calls++;
+			push_frame({site, node, now, counters, cpu, weight, m_timed_calls, m_untimed_calls, m_live_bytes, m_live_bytes});
+			ChronosTraceBuffer* trace = m_trace.load(std::memory_order_relaxed);
+			if (trace != nullptr){
+				trace->push(site, k_trace_begin, now);
+			}// end of if
+		}
+		/**
+		 * @brief Pops the call to the site off the shadow stack, and adds its time to the site's statistics and to its node
+		 *          of the call tree. Calls above it on the stack which were never stopped are dropped. May only be called by the
+		 *          owning thread.
+		 * 
+		 * @param site the handle returned by Chronos::register_site
+		 */
+		inline void stop(long site) {
+			if (m_stack.empty()){
+				return;
+			}// end of if
+			if (m_stack.back().site != site && !unwind_to(site)){
+				return;
+			}// end of if
+			ChronosFrame& frame = m_stack.back();
+			ChronosNode* node = frame.node >= 0 ? get_node(frame.node) : nullptr;
+			if (frame.start < 0){
+				// Not sampled, only count the call
+				ChronosSiteStats* stats = get_stats(site);
+				close_allocations(site, frame);
+				stats->calls.store(stats->calls.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+				if (node != nullptr){
+					node->calls.store(node->calls.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+				}// end of if
+				m_stack.pop_back();
+				ChronosShared* shared = m_shared.load(std::memory_order_relaxed);
+				if (shared != nullptr){
+					shared->count(site);
+				}// end of if
+				ChronosTraceBuffer* trace = m_trace.load(std::memory_order_relaxed);
+				if (trace != nullptr){
+					trace->push(site, k_trace_end, ChronosClock::stop_ticks());
+				}// end of if
+				return;
+			}// end of if
+
+			long long now = ChronosClock::stop_ticks();
+			long long elapsed = now - frame.start;
+			ChronosSiteBlock* block = get_block(site);
+			ChronosSiteStats* stats = &block->stats[site % k_block_size];
+			block->paths[site % k_block_size].active--;
+			if (frame.cpu >= 0){
+				stop_cpu(site, frame.cpu, elapsed);
+			}// end of if
+			if (frame.counters >= 0){
+				stop_counters(site, frame.counters);
+			}// end of if
+			close_allocations(site, frame);
+			add_ticks(stats, elapsed);
+			if (node != nullptr){
+				node->calls.store(node->calls.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+				node->timed.store(node->timed.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+				double weight = static_cast<double>(frame.weight);
+				double timed_below = weight * (m_timed_calls - frame.timed_mark);
+				double untimed_below = weight * (m_untimed_calls - frame.untimed_mark);
+				node->weighted.store(node->weighted.load(std::memory_order_relaxed) + elapsed * weight, std::memory_order_relaxed);
+				node->weight.store(node->weight.load(std::memory_order_relaxed) + weight, std::memory_order_relaxed);
+				node->timed_below.store(node->timed_below.load(std::memory_order_relaxed) + timed_below, std::memory_order_relaxed);
+				node->untimed_below.store(node->untimed_below.load(std::memory_order_relaxed) + untimed_below, std::memory_order_relaxed);
+			}// end of if
+			m_stack.pop_back();
+			ChronosShared* shared = m_shared.load(std::memory_order_relaxed);
+			if (shared != nullptr){
+				shared->add(site, elapsed);
+			}// end of if
+			ChronosTraceBuffer* trace = m_trace.load(std::memory_order_relaxed);
+			if (trace != nullptr){
+				trace->push(site, k_trace_end, now);
+			}// end of if
+		}
+		/**
+		 * @brief Adds an allocation to the site of the running call, and to the bytes in use. Called by the allocation hooks,
+		 *          on the owning thread.
+		 * 
+		 * @param requested the bytes asked for
+		 * @param usable the bytes the allocator handed out, which are also given back when it is freed
+		 */
+		inline void record_allocation(long long requested, long long usable) {
+			m_live_bytes += usable;
+			if (m_stack.empty()){
+				return;
+			}// end of if
+			ChronosFrame& frame = m_stack.back();
+			if (m_live_bytes > frame.live_peak){
+				frame.live_peak = m_live_bytes;
+			}// end of if
+			ChronosSiteDetail* detail = get_detail(frame.site);
+			detail->allocations.store(detail->allocations.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+			detail->allocated_bytes.store(detail->allocated_bytes.load(std::memory_order_relaxed) + requested, std::memory_order_relaxed);
+		}
+		/**
+		 * @brief Takes a freed allocation off the bytes in use. Called by the allocation hooks, on the owning thread.
+		 *          A block freed on another thread than the one it was allocated on is taken off the thread freeing it,
+		 *          which never goes below none in use, so that thread's later peaks are not lowered by blocks it never had.
+		 * 
+		 * @param usable the bytes the allocator had handed out
+		 */
+		inline void record_free(long long usable) {
+			m_live_bytes = m_live_bytes > usable ? m_live_bytes - usable : 0;
+		}
+		/**
+		 * @brief Whether the profiler is changing its own buffers on this thread, so the allocation hooks should leave them be
+		 * 
+		 * @return true 
+		 * @return false 
+		 */
+		inline bool is_internal() {
+			return m_internal;
+		}
+		/**
+		 * @brief Copies the statistics of the site into the process. Safe to call from any thread, while the owner is recording.
+		 * 
+		 * @param site the handle returned by Chronos::register_site
+		 * @param process the process to fill in, which should already carry the site's name and id
+		 * @return true if the thread recorded at least one call to the site
+		 */
+		bool read_site(long site, ChronosProcess& process);
+
+		/**
+		 * @brief Get the node count object. Nodes below the count are safe to read from any thread.
+		 * 
+		 * @return long 
+		 */
+		long get_node_count();
+		/**
+		 * @brief Copies a node of the call tree. Safe to call from any thread, while the owner is recording.
+		 * 
+		 * @param index below get_node_count()
+		 * @param node 
+		 */
+		void read_node(long index, ChronosNodeData& node);
+
+		/**
+		 * @brief Starts appending the calls to a trace ring buffer, which is created on the first use and kept for the lifetime
+		 *          of the thread's buffer, so the owner can never write into a freed ring.
+		 * 
+		 * @param capacity number of events the ring holds
+		 * @return ChronosTraceBuffer* the ring, for the trace writer to drain
+		 */
+		ChronosTraceBuffer* enable_trace(unsigned long capacity);
+		/**
+		 * @brief Stops appending the calls to the trace ring buffer
+		 * 
+		 */
+		void disable_trace();
+
+		/**
+		 * @brief Sets the shared memory segment every call is added to as well
+		 * 
+		 * @param shared the segment, or nullptr to stop adding to it
+		 */
+		void enable_shared(ChronosShared* shared);
+
+		/**
+		 * @brief Sets whether the timed calls should read the hardware counters. The counters are opened by the owning thread
+		 *          on its next timed call; should that fail, the thread carries on without them.
+		 * 
+		 * @param enabled 
+		 */
+		void enable_counters(bool enabled);
+
+		/**
+		 * @brief Looks up the site handle for a function name in the thread's own cache, so the string overloads of
+		 *          Chronos::start and Chronos::stop do not need to lock the shared registry.
+		 * 
+		 * @param key the function name
+		 * @return long the handle, or -1 if the thread has not seen the name yet
+		 */
+		long find_cached_site(const std::string& key);
+		/**
+		 * @brief Adds a function name to the thread's cache
+		 * 
+		 * @param key the function name
+		 * @param site the handle returned by Chronos::register_site
+		 */
+		void cache_site(const std::string& key, long site);
+
+		static const long k_block_size = ChronosSiteBlock::k_size;				// Sites per block
+		static const long k_max_blocks = 4096;									// Upper limit of sites is k_block_size * k_max_blocks
+		static const long k_node_block_size = 1024;								// Call tree nodes per block
+		static const long k_max_node_blocks = 4096;								// Upper limit of nodes is k_node_block_size * k_max_node_blocks
+
+	private:
+		/**
+		 * @brief Pushes a call onto the shadow stack, growing it with the allocation hooks kept out
+		 * 
+		 * @param frame 
+		 */
+		inline void push_frame(const ChronosFrame& frame) {
+			if (m_stack.size() == m_stack.capacity()){
+				grow_stack();
+			}// end of if
+			m_stack.push_back(frame);
+		}
+		/**
+		 * @brief Adds the peak of bytes in use during a call to its site, and passes it on to the caller
+		 * 
+		 * @param site 
+		 * @param frame the call, still on top of the stack
+		 */
+		inline void close_allocations(long site, ChronosFrame& frame) {
+			if (frame.live_peak <= frame.live_start){
+				return;
+			}// end of if
+			long long peak = frame.live_peak - frame.live_start;
+			ChronosSiteDetail* detail = get_detail(site);
+			if (peak > detail->peak_live_bytes.load(std::memory_order_relaxed)){
+				detail->peak_live_bytes.store(peak, std::memory_order_relaxed);
+			}// end of if
+			if (m_stack.size() > 1){
+				ChronosFrame& caller = m_stack[m_stack.size() - 2];
+				caller.live_peak = frame.live_peak > caller.live_peak ? frame.live_peak : caller.live_peak;
+			}// end of if
+		}
+		/**
+		 * @brief Doubles the capacity of the shadow stack
+		 * 
+		 */
+		void grow_stack();
+		/**
+		 * @brief Adds one call to the statistics
+		 * 
+		 * @param stats 
+		 * @param elapsed the duration of the call in clock ticks
+		 */
+		inline void add_ticks(ChronosSiteStats* stats, long long elapsed) {
+			// A clock read on another core may be a tick behind
+			elapsed = elapsed < 0 ? 0 : elapsed;
+			std::atomic<unsigned long long>* histogram = stats->histogram.load(std::memory_order_relaxed);
+			if (histogram == nullptr){
+				histogram = allocate_histogram(stats);
+			}// end of if
+			std::atomic<unsigned long long>& bucket = histogram[ChronosHistogram::bucket_index(static_cast<unsigned long long>(elapsed))];
+			bucket.store(bucket.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+			double squared = static_cast<double>(elapsed) * static_cast<double>(elapsed);
+			stats->sum_squares.store(stats->sum_squares.load(std::memory_order_relaxed) + squared, std::memory_order_relaxed);
+
+			if (stats->timed.load(std::memory_order_relaxed) == 0 || elapsed < stats->min.load(std::memory_order_relaxed)){
+				stats->min.store(elapsed, std::memory_order_relaxed);
+			}// end of if
+			if (elapsed > stats->max.load(std::memory_order_relaxed)){
+				stats->max.store(elapsed, std::memory_order_relaxed);
+			}// end of if
+			stats->total.store(stats->total.load(std::memory_order_relaxed) + elapsed, std::memory_order_relaxed);
+			stats->timed.store(stats->timed.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+			stats->calls.store(stats->calls.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+		}
+		/**
+		 * @brief Works out how many calls of the site should pass before the next one is timed
+		 * 
+		 * @param site 
+		 * @param now the start of the call being timed
+		 * @return long 
+		 */
+		inline long next_period(long site, long long now) {
+			long period = m_sampler->is_adaptive(site) ? adapt_period(site, get_detail(site), now) : m_sampler->get_period(site);
+			if (period <= 1){
+				return period;
+			}// end of if
+			// Anywhere from 1 to 2 * period - 1 calls, so one in period is still timed on average without locking onto a pattern of the calls
+			return 1 + static_cast<long>(next_random() % static_cast<unsigned long long>(2 * period - 1));
+		}
+		/**
+		 * @brief Steps the thread's xorshift generator, which spreads the timed calls of the sampled sites
+		 * 
+		 * @return unsigned long long 
+		 */
+		inline unsigned long long next_random() {
+			m_random ^= m_random << 13;
+			m_random ^= m_random >> 7;
+			m_random ^= m_random << 17;
+			return m_random;
+		}
+		/**
+		 * @brief Raises the period of the site when the last window of calls was shorter than the budget allows, and lowers it
+		 *          when the window was well over
+		 * 
+		 * @param site 
+		 * @param detail 
+		 * @param now 
+		 * @return long 
+		 */
+		long adapt_period(long site, ChronosSiteDetail* detail, long long now);
+		/**
+		 * @brief Get the block holding the site, allocating it on first use
+		 * 
+		 * @param site 
+		 * @return ChronosSiteBlock* nullptr if the handle is out of range
+		 */
+		inline ChronosSiteBlock* get_block(long site) {
+			unsigned long index = static_cast<unsigned long>(site) / k_block_size;
+			if (index >= static_cast<unsigned long>(k_max_blocks)){
+				return nullptr;
+			}// end of if
+			ChronosSiteBlock* block = m_blocks[index].load(std::memory_order_relaxed);
+			if (block == nullptr){
+				block = allocate_block(index);
+			}// end of if
+			return block;
+		}
+		/**
+		 * @brief Get the statistics of the site, allocating the block holding it on first use
+		 * 
+		 * @param site 
+		 * @return ChronosSiteStats* nullptr if the handle is out of range
+		 */
+		inline ChronosSiteStats* get_stats(long site) {
+			ChronosSiteBlock* block = get_block(site);
+			return block == nullptr ? nullptr : &block->stats[site % k_block_size];
+		}
+		/**
+		 * @brief Get the detail of a site which has already been called
+		 * 
+		 * @param site 
+		 * @return ChronosSiteDetail* 
+		 */
+		inline ChronosSiteDetail* get_detail(long site) {
+			return &m_blocks[site / k_block_size].load(std::memory_order_relaxed)->details[site % k_block_size];
+		}
+		/**
+		 * @brief Get a node of the call tree, which must already exist
+		 * 
+		 * @param index 
+		 * @return ChronosNode* 
+		 */
+		inline ChronosNode* get_node(long index) {
+			return m_node_blocks[index / k_node_block_size].load(std::memory_order_relaxed) + (index % k_node_block_size);
+		}
+		/**
+		 * @brief Finds the child of a node for the given site, creating it on the first call along that path
+		 * 
+		 * @param parent 
+		 * @param site 
+		 * @return long the index of the child, or -1 if the tree is full
+		 */
+		inline long find_child(long parent, long site) {
+			long child = get_node(parent)->first_child;
+			while (child >= 0){
+				ChronosNode* node = get_node(child);
+				if (node->site == site){
+					return child;
+				}// end of if
+				child = node->next_sibling;
+			}// end of while
+			return add_node(parent, site);
+		}
+		/**
+		 * @brief Appends a node to the call tree and publishes it to the readers
+		 * 
+		 * @param parent 
+		 * @param site 
+		 * @return long the index of the new node, or -1 if the tree is full
+		 */
+		long add_node(long parent, long site);
+		/**
+		 * @brief Drops the calls above the latest call to the site from the shadow stack, for stops that were missed
+		 * 
+		 * @param site 
+		 * @return true if the site was found on the stack, and is now on top
+		 */
+		bool unwind_to(long site);
+		/**
+		 * @brief Allocates the zeroed histogram of a site and publishes it to the readers
+		 * 
+		 * @param stats 
+		 * @return std::atomic<unsigned long long>* 
+		 */
+		std::atomic<unsigned long long>* allocate_histogram(ChronosSiteStats* stats);
+		/**
+		 * @brief Allocates a zeroed block of sites and publishes it to the readers
+		 * 
+		 * @param index 
+		 * @return ChronosSiteBlock* 
+		 */
+		ChronosSiteBlock* allocate_block(unsigned long index);
+		/**
+		 * @brief Reads the hardware counters at the start of a call onto the counter stack, opening them on the first call
+		 * 
+		 * @return long the entry of the counter stack, or -1 if the counters can not be read
+		 */
+		long start_counters();
+		/**
+		 * @brief Reads the hardware counters at the end of a call, and adds the difference with its start to the site
+		 * 
+		 * @param site 
+		 * @param entry the entry of the counter stack returned by start_counters
+		 */
+		void stop_counters(long site, long entry);
+		/**
+		 * @brief Reads the thread's CPU time and context switches at the start of a call onto the CPU time stack
+		 * 
+		 * @return long the entry of the CPU time stack, or -1 if they can not be read
+		 */
+		long start_cpu();
+		/**
+		 * @brief Reads the thread's CPU time and context switches at the end of a call, and adds the difference with its
+		 *          start to the site
+		 * 
+		 * @param site 
+		 * @param entry the entry of the CPU time stack returned by start_cpu
+		 * @param elapsed the wall time of the call in clock ticks
+		 */
+		void stop_cpu(long site, long entry, long long elapsed);
+
+		//Member variables
+		long m_thread_id;														// Index of the thread
+		std::atomic<ChronosSiteBlock*> m_blocks[k_max_blocks];					// Blocks never move once allocated, so readers need no lock
+		std::atomic<ChronosNode*> m_node_blocks[k_max_node_blocks];				// Blocks of the call tree, node 0 is the root
+		std::atomic<long> m_node_count;											// Number of published nodes
+		std::vector<ChronosFrame> m_stack;										// Shadow stack of the running calls
+		std::atomic<ChronosTraceBuffer*> m_trace;								// Ring the calls are traced to, nullptr when not tracing
+		std::unique_ptr<ChronosTraceBuffer> m_trace_storage;					// Owns the ring
+		std::atomic<ChronosShared*> m_shared;									// Segment the calls are added to, nullptr when not shared
+		std::unordered_map<std::string, long> m_site_cache;						// Thread-local copy of the name lookups
+		ChronosSampler* m_sampler;												// Sampling settings of the profiler
+		std::atomic<bool> m_counting;											// Whether the timed calls read the hardware counters
+		std::unique_ptr<ChronosCounters> m_counters;							// The thread's counters, opened by the owner
+		std::vector<unsigned long long> m_counter_stack;						// Counter values at the start of the running calls
+		std::vector<ChronosCpuSample> m_cpu_stack;								// CPU times at the start of the running calls
+		long long m_live_bytes;													// Bytes allocated and not yet freed, while the hooks count
+		long m_timed_calls;														// Timed calls the thread has started, owner only
+		long m_untimed_calls;													// Untimed calls the thread has started, owner only
+		unsigned long long m_random;											// State of the generator of the sample countdowns
+		bool m_internal;														// Set while the profiler allocates for itself
+};
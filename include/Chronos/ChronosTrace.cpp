@@ -0,0 +1,220 @@
+/**   Copyright 2020 Benrick Smit
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ * 
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+*/
+
+/**
+ * @author: Benrick Smit
+ * @email: metatronicprogramming@hotmail.com
+ * @date: 13 June 2020
+ * @modified: 13 June 2020
+ * 
+ * @brief: This class writes the event trace of the Chronos profiler.
+ * 
+ */ 
+
+
+#include "ChronosTrace.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "ChronosClock.h"
+
+
+//Ctors and Dtors
+ChronosTrace::ChronosTrace() {
+    m_file = -1;
+    m_map = nullptr;
+    m_mapped = 0;
+    m_used = 0;
+    m_running.store(false);
+    m_records.store(0);
+}
+
+ChronosTrace::~ChronosTrace() {
+    if (is_open()){
+        m_running.store(false);
+        m_writer.join();
+        unmap(m_used);
+    }// end of if
+}
+
+//Basic Functionality
+bool ChronosTrace::open(std::string path) {
+    if (is_open()){
+        return false;
+    }// end of if
+    m_file = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (m_file < 0){
+        std::string error_string = "Error writing file to: \"" + path + "\"";
+        perror(error_string.c_str());
+        return false;
+    }// end of if
+
+    m_used = 0;
+    m_records.store(0);
+    if (!reserve(sizeof(ChronosTraceHeader))){
+        ::close(m_file);
+        m_file = -1;
+        return false;
+    }// end of if
+
+    ChronosTraceHeader* header = reinterpret_cast<ChronosTraceHeader*>(m_map);
+    std::memset(header, 0, sizeof(ChronosTraceHeader));
+    std::memcpy(header->magic, "CHRTRACE", 8);
+    header->version = k_trace_version;
+    header->record_size = sizeof(ChronosTraceRecord);
+    header->seconds_per_tick = ChronosClock::get_seconds_per_tick();
+    m_used = sizeof(ChronosTraceHeader);
+
+    m_running.store(true);
+    m_writer = std::thread(&ChronosTrace::run, this);
+    return true;
+}
+
+void ChronosTrace::add_buffer(ChronosTraceBuffer* buffer) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_buffers.push_back(buffer);
+}
+
+void ChronosTrace::close(std::vector<ChronosSiteName>& sites) {
+    if (!is_open()){
+        return;
+    }// end of if
+    m_running.store(false);
+    m_writer.join();
+    drain();
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    // Append the name table
+    unsigned long names_offset = m_used;
+    unsigned long names_bytes = 0;
+    for (ChronosSiteName& site: sites){
+        names_bytes += 2 * sizeof(std::uint32_t) + site.name.size();
+    }// end of for
+    if (reserve(names_bytes)){
+        for (unsigned long i = 0; i < sites.size(); i++){
+            std::string_view name = sites[i].name;
+            std::uint32_t entry[2] = {static_cast<std::uint32_t>(i), static_cast<std::uint32_t>(name.size())};
+            std::memcpy(m_map + m_used, entry, sizeof(entry));
+            std::memcpy(m_map + m_used + sizeof(entry), name.data(), name.size());
+            m_used += sizeof(entry) + name.size();
+        }// end of for
+        ChronosTraceHeader* header = reinterpret_cast<ChronosTraceHeader*>(m_map);
+        header->names_offset = names_offset;
+        header->names_count = sites.size();
+    }// end of if
+
+    long dropped = 0;
+    for (ChronosTraceBuffer* buffer: m_buffers){
+        dropped += buffer->get_dropped();
+    }// end of for
+    if (m_map != nullptr){
+        reinterpret_cast<ChronosTraceHeader*>(m_map)->dropped = static_cast<std::uint64_t>(dropped);
+    }// end of if
+    m_buffers.clear();
+    unmap(m_used);
+}
+
+long ChronosTrace::get_record_count() {
+    return m_records.load();
+}
+
+long ChronosTrace::get_dropped() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    long dropped = 0;
+    for (ChronosTraceBuffer* buffer: m_buffers){
+        dropped += buffer->get_dropped();
+    }// end of for
+    return dropped;
+}
+
+bool ChronosTrace::is_open() {
+    return m_file >= 0;
+}
+
+//Private Functions
+void ChronosTrace::run() {
+    while (m_running.load()){
+        if (drain() == 0){
+            // Nothing was waiting, give the recording threads time to fill their rings
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }// end of if
+    }// end of while
+}
+
+unsigned long ChronosTrace::drain() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    unsigned long written = 0;
+    for (ChronosTraceBuffer* buffer: m_buffers){
+        unsigned long pending = buffer->get_pending();
+        if (pending == 0 || !reserve(pending * sizeof(ChronosTraceRecord))){
+            continue;
+        }// end of if
+        ChronosTraceRecord* destination = reinterpret_cast<ChronosTraceRecord*>(m_map + m_used);
+        unsigned long count = buffer->drain(destination, pending);
+        m_used += count * sizeof(ChronosTraceRecord);
+        written += count;
+    }// end of for
+    if (written > 0){
+        m_records.fetch_add(static_cast<long>(written));
+        reinterpret_cast<ChronosTraceHeader*>(m_map)->record_count = static_cast<std::uint64_t>(m_records.load());
+    }// end of if
+    return written;
+}
+
+bool ChronosTrace::reserve(unsigned long bytes) {
+    if (m_used + bytes <= m_mapped){
+        return true;
+    }// end of if
+    unsigned long size = m_mapped;
+    while (size < m_used + bytes){
+        size += k_grow_bytes;
+    }// end of while
+    if (ftruncate(m_file, static_cast<off_t>(size)) != 0){
+        perror("Error growing the Chronos trace file");
+        return false;
+    }// end of if
+    if (m_map != nullptr){
+        munmap(m_map, m_mapped);
+    }// end of if
+    void* map = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, m_file, 0);
+    if (map == MAP_FAILED){
+        perror("Error mapping the Chronos trace file");
+        m_map = nullptr;
+        m_mapped = 0;
+        return false;
+    }// end of if
+    m_map = static_cast<char*>(map);
+    m_mapped = size;
+    return true;
+}
+
+void ChronosTrace::unmap(unsigned long used) {
+    if (m_map != nullptr){
+        munmap(m_map, m_mapped);
+    }// end of if
+    if (ftruncate(m_file, static_cast<off_t>(used)) != 0){
+        perror("Error closing the Chronos trace file");
+    }// end of if
+    ::close(m_file);
+    m_file = -1;
+    m_map = nullptr;
+    m_mapped = 0;
+}
@@ -0,0 +1,139 @@
+/**   Copyright 2020 Benrick Smit
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ * 
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+*/
+
+/**
+ * @author: Benrick Smit
+ * @email: metatronicprogramming@hotmail.com
+ * @date: 13 June 2020
+ * @modified: 13 June 2020
+ * 
+ * @brief: This class writes the event trace of the Chronos profiler. A background thread drains the ring buffers of the
+ *          recording threads into a memory-mapped, append-only file, which grows in large steps. The file starts with a
+ *          ChronosTraceHeader, followed by the ChronosTraceRecord events in the order they were drained, which is in time
+ *          order per thread. When the trace is closed the names of the sites are appended as a table. The header's event
+ *          count is kept current while the trace runs, so the events of a process that never closed its trace can still be read.
+ * 
+ */ 
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "ChronosArena.h"
+#include "ChronosTraceBuffer.h"
+
+/**
+ * @brief The header at the start of a trace file
+ * 
+ */
+struct ChronosTraceHeader {
+    char magic[8];                                                          // "CHRTRACE"
+    std::uint32_t version;                                                  // k_trace_version
+    std::uint32_t record_size;                                              // sizeof(ChronosTraceRecord)
+    double seconds_per_tick;                                                // Calibrated length of a ChronosClock tick
+    std::uint64_t record_count;                                             // Events following the header
+    std::uint64_t dropped;                                                  // Events lost to full rings, set when closed
+    std::uint64_t names_offset;                                             // File offset of the name table, 0 until closed
+    std::uint64_t names_count;                                              // Entries in the name table
+};
+
+// Every name table entry is a uint32 site handle and a uint32 length, followed by the name's bytes
+static const std::uint32_t k_trace_version = 1;
+
+class ChronosTrace {
+	public:
+		//ctors and dtors
+		/**
+		 * @brief Construct a new Chronos Trace object, which does nothing until opened
+		 * 
+		 */
+		ChronosTrace();
+		/**
+		 * @brief Destroy the Chronos Trace object, closing the file without a name table if it is still open
+		 * 
+		 */
+		~ChronosTrace();
+
+		ChronosTrace(const ChronosTrace&) = delete;
+		ChronosTrace& operator=(const ChronosTrace&) = delete;
+
+		//Basic Operation
+		/**
+		 * @brief Creates the trace file and starts the background writer
+		 * 
+		 * @param path 
+		 * @return true if the file could be created and mapped
+		 */
+		bool open(std::string path);
+		/**
+		 * @brief Adds a ring buffer for the writer to drain
+		 * 
+		 * @param buffer 
+		 */
+		void add_buffer(ChronosTraceBuffer* buffer);
+		/**
+		 * @brief Stops the writer, drains what is left in the buffers, appends the name table and closes the file
+		 * 
+		 * @param sites the names of the registered sites, indexed by site handle
+		 */
+		void close(std::vector<ChronosSiteName>& sites);
+		/**
+		 * @brief Get the number of events written so far
+		 * 
+		 * @return long 
+		 */
+		long get_record_count();
+		/**
+		 * @brief Get the number of events dropped so far, over all the buffers
+		 * 
+		 * @return long 
+		 */
+		long get_dropped();
+		/**
+		 * @brief Whether the trace is open
+		 * 
+		 * @return true 
+		 * @return false 
+		 */
+		bool is_open();
+
+		static const unsigned long k_grow_bytes = 64ul << 20;					// The file grows in steps of 64 MiB
+
+	private:
+		// The loop of the background writer
+		void run();
+		// Drains all the buffers once, returns the number of events written
+		unsigned long drain();
+		// Makes room in the mapping for the given number of bytes past the events
+		bool reserve(unsigned long bytes);
+		// Unmaps the file, and cuts it to its used size
+		void unmap(unsigned long used);
+
+		//Member variables
+		int m_file;																// Descriptor of the trace file, -1 when closed
+		char* m_map;															// The mapped file
+		unsigned long m_mapped;													// Bytes mapped, and the size of the file
+		unsigned long m_used;													// Bytes written, header included
+		std::atomic<bool> m_running;											// Keeps the writer going
+		std::atomic<long> m_records;											// Events written
+		std::thread m_writer;													// The background writer
+		std::mutex m_mutex;														// Guards the buffer list and the mapping
+		std::vector<ChronosTraceBuffer*> m_buffers;								// Rings of the recording threads
+};
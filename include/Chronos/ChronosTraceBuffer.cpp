@@ -0,0 +1,73 @@
+/**   Copyright 2020 Benrick Smit
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ * 
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+*/
+
+/**
+ * @author: Benrick Smit
+ * @email: metatronicprogramming@hotmail.com
+ * @date: 13 June 2020
+ * @modified: 13 June 2020
+ * 
+ * @brief: This class is the ring buffer a thread appends its trace events to.
+ * 
+ */ 
+
+
+#include "ChronosTraceBuffer.h"
+
+#include <algorithm>
+#include <cstring>
+
+
+//Ctors and Dtors
+ChronosTraceBuffer::ChronosTraceBuffer(long thread_id, unsigned long capacity) {
+    m_capacity = 1;
+    while (m_capacity < capacity){
+        m_capacity <<= 1;
+    }// end of while
+    m_records.resize(m_capacity);
+    m_head.store(0, std::memory_order_relaxed);
+    m_tail.store(0, std::memory_order_relaxed);
+    m_cached_tail = 0;
+    m_thread_id = static_cast<std::uint16_t>(thread_id);
+    m_dropped.store(0, std::memory_order_relaxed);
+}
+
+ChronosTraceBuffer::~ChronosTraceBuffer() {
+    // Do Nothing
+}
+
+//Basic Functionality
+unsigned long ChronosTraceBuffer::drain(ChronosTraceRecord* destination, unsigned long max_records) {
+    unsigned long tail = m_tail.load(std::memory_order_relaxed);
+    unsigned long head = m_head.load(std::memory_order_acquire);
+    unsigned long count = std::min(head - tail, max_records);
+
+    // Copy in at most two pieces, as the pending events may wrap around the end of the ring
+    unsigned long first = tail & (m_capacity - 1);
+    unsigned long first_count = std::min(count, m_capacity - first);
+    std::memcpy(destination, &m_records[first], first_count * sizeof(ChronosTraceRecord));
+    std::memcpy(destination + first_count, &m_records[0], (count - first_count) * sizeof(ChronosTraceRecord));
+
+    m_tail.store(tail + count, std::memory_order_release);
+    return count;
+}
+
+unsigned long ChronosTraceBuffer::get_pending() {
+    return m_head.load(std::memory_order_acquire) - m_tail.load(std::memory_order_relaxed);
+}
+
+long ChronosTraceBuffer::get_dropped() {
+    return m_dropped.load(std::memory_order_relaxed);
+}
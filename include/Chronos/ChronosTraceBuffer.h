@@ -0,0 +1,122 @@
+/**   Copyright 2020 Benrick Smit
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ * 
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+*/
+
+/**
+ * @author: Benrick Smit
+ * @email: metatronicprogramming@hotmail.com
+ * @date: 13 June 2020
+ * @modified: 13 June 2020
+ * 
+ * @brief: This class is the ring buffer a thread appends its trace events to. It has a single producer, the owning thread,
+ *          and a single consumer, the background writer of ChronosTrace. Appending an event is a few stores with no locks,
+ *          system calls or allocations. When the writer falls behind and the ring is full, the event is dropped and counted.
+ * 
+ */ 
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief One fixed-size trace event, as stored in the ring and in the trace file
+ * 
+ */
+struct ChronosTraceRecord {
+    std::uint32_t site;                                                     // Site handle
+    std::uint16_t thread;                                                   // Index of the recording thread
+    std::uint16_t type;                                                     // k_trace_begin or k_trace_end
+    std::uint64_t ticks;                                                    // ChronosClock ticks of the event
+};
+
+static const std::uint16_t k_trace_begin = 0;
+static const std::uint16_t k_trace_end = 1;
+
+class ChronosTraceBuffer {
+	public:
+		//ctors and dtors
+		/**
+		 * @brief Construct a new Chronos Trace Buffer object
+		 * 
+		 * @param thread_id the index of the owning thread
+		 * @param capacity number of events the ring holds, rounded up to a power of two
+		 */
+		ChronosTraceBuffer(long thread_id, unsigned long capacity);
+		/**
+		 * @brief Destroy the Chronos Trace Buffer object
+		 * 
+		 */
+		~ChronosTraceBuffer();
+
+		ChronosTraceBuffer(const ChronosTraceBuffer&) = delete;
+		ChronosTraceBuffer& operator=(const ChronosTraceBuffer&) = delete;
+
+		//Basic Operation
+		/**
+		 * @brief Appends an event to the ring, or counts it as dropped if the ring is full. May only be called by the owning thread.
+		 * 
+		 * @param site 
+		 * @param type k_trace_begin or k_trace_end
+		 * @param ticks 
+		 */
+		inline void push(long site, std::uint16_t type, long long ticks) {
+			unsigned long head = m_head.load(std::memory_order_relaxed);
+			if (head - m_cached_tail >= m_capacity){
+				// Only look at the writer's position when the ring seems full
+				m_cached_tail = m_tail.load(std::memory_order_acquire);
+				if (head - m_cached_tail >= m_capacity){
+					m_dropped.store(m_dropped.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+					return;
+				}// end of if
+			}// end of if
+			ChronosTraceRecord& record = m_records[head & (m_capacity - 1)];
+			record.site = static_cast<std::uint32_t>(site);
+			record.thread = m_thread_id;
+			record.type = type;
+			record.ticks = static_cast<std::uint64_t>(ticks);
+			m_head.store(head + 1, std::memory_order_release);
+		}
+		/**
+		 * @brief Copies the pending events out of the ring. May only be called by the writer.
+		 * 
+		 * @param destination room for at least max_records events
+		 * @param max_records 
+		 * @return unsigned long the number of events copied
+		 */
+		unsigned long drain(ChronosTraceRecord* destination, unsigned long max_records);
+		/**
+		 * @brief Get the number of events waiting in the ring
+		 * 
+		 * @return unsigned long 
+		 */
+		unsigned long get_pending();
+		/**
+		 * @brief Get the number of events dropped because the ring was full
+		 * 
+		 * @return long 
+		 */
+		long get_dropped();
+
+	private:
+		//Member variables
+		alignas(64) std::atomic<unsigned long> m_head;							// Next slot the owner writes, owner's cache line
+		unsigned long m_cached_tail;											// Last seen writer position, owner only
+		std::uint16_t m_thread_id;												// Index of the owning thread
+		std::atomic<long> m_dropped;											// Events lost to a full ring
+		alignas(64) std::atomic<unsigned long> m_tail;							// Next slot the writer reads, writer's cache line
+		unsigned long m_capacity;												// Power of two
+		std::vector<ChronosTraceRecord> m_records;								// The ring
+};
@@ -0,0 +1,261 @@
+/**   Copyright 2020 Benrick Smit
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ * 
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+*/
+
+/**
+ * @author: Benrick Smit
+ * @email: metatronicprogramming@hotmail.com
+ * @date: 13 June 2020
+ * @modified: 13 June 2020
+ * 
+ * @brief: This class reads a trace file written by ChronosTrace, and exports it to the Chrome Trace Event format.
+ * 
+ */ 
+
+
+#include "ChronosTraceReader.h"
+
+#include <cstring>
+#include <map>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+
+//Ctors and Dtors
+ChronosTraceReader::ChronosTraceReader() {
+    m_file = -1;
+    m_map = nullptr;
+    m_size = 0;
+    m_header = nullptr;
+    m_records = nullptr;
+    m_record_count = 0;
+}
+
+ChronosTraceReader::~ChronosTraceReader() {
+    close();
+}
+
+//Basic Functionality
+bool ChronosTraceReader::open(std::string path) {
+    close();
+    m_file = ::open(path.c_str(), O_RDONLY);
+    if (m_file < 0){
+        std::string error_string = "Error reading file from: \"" + path + "\"";
+        perror(error_string.c_str());
+        return false;
+    }// end of if
+    struct stat status;
+    if (fstat(m_file, &status) != 0 || static_cast<unsigned long>(status.st_size) < sizeof(ChronosTraceHeader)){
+        close();
+        return false;
+    }// end of if
+    m_size = static_cast<unsigned long>(status.st_size);
+    void* map = mmap(nullptr, m_size, PROT_READ, MAP_SHARED, m_file, 0);
+    if (map == MAP_FAILED){
+        m_map = nullptr;
+        close();
+        return false;
+    }// end of if
+    m_map = static_cast<const char*>(map);
+    m_header = reinterpret_cast<const ChronosTraceHeader*>(m_map);
+    if (std::memcmp(m_header->magic, "CHRTRACE", 8) != 0 || m_header->version != k_trace_version
+        || m_header->record_size != sizeof(ChronosTraceRecord)){
+        close();
+        return false;
+    }// end of if
+
+    // Never trust the count past the end of the file, a crashed writer may have left it behind
+    m_records = reinterpret_cast<const ChronosTraceRecord*>(m_map + sizeof(ChronosTraceHeader));
+    unsigned long fits = (m_size - sizeof(ChronosTraceHeader)) / sizeof(ChronosTraceRecord);
+    m_record_count = static_cast<long>(m_header->record_count < fits ? m_header->record_count : fits);
+
+    // Read the name table
+    m_names.clear();
+    unsigned long offset = m_header->names_offset;
+    for (unsigned long i = 0; offset != 0 && i < m_header->names_count; i++){
+        std::uint32_t entry[2];
+        if (offset + sizeof(entry) > m_size){
+            break;
+        }// end of if
+        std::memcpy(entry, m_map + offset, sizeof(entry));
+        offset += sizeof(entry);
+        if (offset + entry[1] > m_size){
+            break;
+        }// end of if
+        if (entry[0] >= m_names.size()){
+            m_names.resize(entry[0] + 1);
+        }// end of if
+        m_names[entry[0]].assign(m_map + offset, entry[1]);
+        offset += entry[1];
+    }// end of for
+    return true;
+}
+
+void ChronosTraceReader::close() {
+    if (m_map != nullptr){
+        munmap(const_cast<char*>(m_map), m_size);
+    }// end of if
+    if (m_file >= 0){
+        ::close(m_file);
+    }// end of if
+    m_file = -1;
+    m_map = nullptr;
+    m_size = 0;
+    m_header = nullptr;
+    m_records = nullptr;
+    m_record_count = 0;
+    m_names.clear();
+}
+
+//Getters
+long ChronosTraceReader::get_record_count() {
+    return m_record_count;
+}
+
+const ChronosTraceRecord& ChronosTraceReader::get_record(long index) {
+    return m_records[index];
+}
+
+std::string ChronosTraceReader::get_name(long site) {
+    if (site >= 0 && site < static_cast<long>(m_names.size()) && !m_names[site].empty()){
+        return m_names[site];
+    }// end of if
+    return "site " + std::to_string(site);
+}
+
+double ChronosTraceReader::get_seconds_per_tick() {
+    return m_header == nullptr ? 0 : m_header->seconds_per_tick;
+}
+
+long ChronosTraceReader::get_dropped() {
+    return m_header == nullptr ? 0 : static_cast<long>(m_header->dropped);
+}
+
+//Exporters
+bool ChronosTraceReader::write_chrome_trace(std::string json_path) {
+    if (m_header == nullptr){
+        return false;
+    }// end of if
+    FILE* json_file = fopen(json_path.c_str(), "w");
+    if (json_file == nullptr){
+        std::string error_string = "Error writing file to: \"" + json_path + "\"";
+        perror(error_string.c_str());
+        return false;
+    }// end of if
+
+    // Everything goes through one fixed buffer, flushed whenever it runs low
+    std::vector<char> buffer(1 << 20);
+    unsigned long used = 0;
+    auto flush = [&](){
+        fwrite(buffer.data(), 1, used, json_file);
+        used = 0;
+    };
+    auto append = [&](const char* data, unsigned long length){
+        if (used + length > buffer.size()){
+            flush();
+        }// end of if
+        if (length > buffer.size()){
+            fwrite(data, 1, length, json_file);
+            return;
+        }// end of if
+        std::memcpy(buffer.data() + used, data, length);
+        used += length;
+    };
+
+    // The names are escaped once per site, not once per event
+    std::vector<std::string> names;
+    std::map<unsigned int, std::vector<const ChronosTraceRecord*>> stacks;
+    long long base = m_record_count > 0 ? static_cast<long long>(m_records[0].ticks) : 0;
+    for (long i = 0; i < m_record_count; i++){
+        long long ticks = static_cast<long long>(m_records[i].ticks);
+        base = ticks < base ? ticks : base;
+    }// end of for
+    double microseconds = m_header->seconds_per_tick * 1e6;
+
+    const char* opening = "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n"
+                          "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"Chronos\"}}";
+    append(opening, std::strlen(opening));
+
+    char line[256];
+    for (long i = 0; i < m_record_count; i++){
+        const ChronosTraceRecord& record = m_records[i];
+        std::vector<const ChronosTraceRecord*>& stack = stacks[record.thread];
+        if (stack.capacity() == 0){
+            // Name the thread the first time it is seen
+            int length = snprintf(line, sizeof(line), ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"Thread %u\"}}",
+                                  static_cast<unsigned int>(record.thread), static_cast<unsigned int>(record.thread));
+            append(line, static_cast<unsigned long>(length));
+            stack.reserve(64);
+        }// end of if
+        if (record.type == k_trace_begin){
+            stack.push_back(&record);
+            continue;
+        }// end of if
+
+        // Pair the end with its begin, dropping the begins above it whose end was lost. An end with no begin of its site on
+        // the stack, as the ring's oldest records leave behind, is dropped on its own, so the calls it was made in stay open
+        long match = static_cast<long>(stack.size()) - 1;
+        while (match >= 0 && stack[match]->site != record.site){
+            match--;
+        }// end of while
+        if (match < 0){
+            continue;
+        }// end of if
+        const ChronosTraceRecord* begin = stack[match];
+        stack.resize(match);
+
+        if (record.site >= names.size()){
+            names.resize(record.site + 1);
+        }// end of if
+        std::string& name = names[record.site];
+        if (name.empty()){
+            name = escape_json(get_name(record.site));
+        }// end of if
+
+        append(",\n{\"name\":\"", 11);
+        append(name.data(), name.size());
+        int length = snprintf(line, sizeof(line), "\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+                              static_cast<unsigned int>(record.thread),
+                              (static_cast<long long>(begin->ticks) - base) * microseconds,
+                              (static_cast<long long>(record.ticks) - static_cast<long long>(begin->ticks)) * microseconds);
+        append(line, static_cast<unsigned long>(length));
+    }// end of for
+    append("\n]}\n", 4);
+    flush();
+
+    bool success = ferror(json_file) == 0;
+    fclose(json_file);
+    return success;
+}
+
+//Private Functions
+std::string ChronosTraceReader::escape_json(const std::string& value) {
+    std::string to_return;
+    for (char character: value){
+        if (character == '"' || character == '\\'){
+            to_return += '\\';
+            to_return += character;
+        }else if (static_cast<unsigned char>(character) < 0x20){
+            char escaped[8];
+            snprintf(escaped, sizeof(escaped), "\\u%04x", static_cast<unsigned int>(static_cast<unsigned char>(character)));
+            to_return += escaped;
+        }else{
+            to_return += character;
+        }// end of if else
+    }// end of for
+    return to_return;
+}
@@ -0,0 +1,125 @@
+/**   Copyright 2020 Benrick Smit
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ * 
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+*/
+
+/**
+ * @author: Benrick Smit
+ * @email: metatronicprogramming@hotmail.com
+ * @date: 13 June 2020
+ * @modified: 13 June 2020
+ * 
+ * @brief: This class reads a trace file written by ChronosTrace, by mapping it into memory, and exports it to the Chrome
+ *          Trace Event format, which chrome://tracing and Perfetto open. The export is streamed through a fixed-size buffer,
+ *          so traces of any length are converted without building the output in memory.
+ * 
+ */ 
+
+#pragma once
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "ChronosTrace.h"
+
+class ChronosTraceReader {
+	public:
+		//ctors and dtors
+		/**
+		 * @brief Construct a new Chronos Trace Reader object, which holds nothing until opened
+		 * 
+		 */
+		ChronosTraceReader();
+		/**
+		 * @brief Destroy the Chronos Trace Reader object, and unmap the file
+		 * 
+		 */
+		~ChronosTraceReader();
+
+		ChronosTraceReader(const ChronosTraceReader&) = delete;
+		ChronosTraceReader& operator=(const ChronosTraceReader&) = delete;
+
+		//Basic Operation
+		/**
+		 * @brief Maps a trace file, and reads its name table. A trace that was never closed has no names, and its sites are
+		 *          named by their handles.
+		 * 
+		 * @param path 
+		 * @return true if the file is a readable trace
+		 */
+		bool open(std::string path);
+		/**
+		 * @brief Unmaps the file
+		 * 
+		 */
+		void close();
+
+		//Getters
+		/**
+		 * @brief Get the record count object
+		 * 
+		 * @return long 
+		 */
+		long get_record_count();
+		/**
+		 * @brief Get an event of the trace
+		 * 
+		 * @param index below get_record_count()
+		 * @return const ChronosTraceRecord& 
+		 */
+		const ChronosTraceRecord& get_record(long index);
+		/**
+		 * @brief Get the name of a site
+		 * 
+		 * @param site 
+		 * @return std::string 
+		 */
+		std::string get_name(long site);
+		/**
+		 * @brief Get the seconds per tick object
+		 * 
+		 * @return double 
+		 */
+		double get_seconds_per_tick();
+		/**
+		 * @brief Get the number of events dropped while tracing
+		 * 
+		 * @return long 
+		 */
+		long get_dropped();
+
+		//Exporters
+		/**
+		 * @brief Writes the trace in the Chrome Trace Event JSON format, as one complete ("X") event per call, with the thread
+		 *          as its tid. Calls are paired per thread with a stack, so nesting survives; calls whose begin or end was
+		 *          dropped are left out.
+		 * 
+		 * @param json_path 
+		 * @return true if the file was written
+		 */
+		bool write_chrome_trace(std::string json_path);
+
+	private:
+		// Applies the JSON escapes to a name
+		static std::string escape_json(const std::string& value);
+
+		//Member variables
+		int m_file;																// Descriptor of the trace file, -1 when closed
+		const char* m_map;														// The mapped file
+		unsigned long m_size;													// Bytes mapped
+		const ChronosTraceHeader* m_header;										// Start of the file
+		const ChronosTraceRecord* m_records;									// Events following the header
+		long m_record_count;													// Events that fit in the file
+		std::vector<std::string> m_names;										// Name of every site handle
+};
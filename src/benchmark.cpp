@@ -0,0 +1,259 @@
+/**   Copyright 2020 Benrick Smit
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+*/
+/**
+ * @author: Benrick Smit
+ * @email: metatronicprogramming@hotmail.com
+ * @date: 13 June 2020
+ * @modified: 13 June 2020
+ *
+ * @brief: This program measures what the profiler costs per start and stop, over a number of scenarios: logging on and off,
+ *          the string and handle interfaces, 1 to 100k distinct sites, recursion depth, and 1 to N threads, as well as an
+ *          uncontended Chronos::mutex next to a std::mutex. Every scenario is
+ *          run in several rounds, of which the median is reported, as CSV or, with --json, as JSON, on the standard output.
+ *          For the threads, the time per call is the wall time over the calls of one thread, so it stays flat as long as the
+ *          threads scale.
+ *
+ *          Usage: Chronos_Benchmark [--json] [--calls N] [--threads N]
+ *
+ */
+
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "include/Chronos/Chronos.h"
+
+// The number of rounds every scenario runs, of which the median is reported
+const int k_rounds = 5;
+
+struct BenchmarkResult {
+    std::string scenario;
+    long parameter;
+    long calls;
+    double nanoseconds;
+};
+
+// Keeps the compiler from folding the empty loops away
+static inline void clobber() {
+    asm volatile("" ::: "memory");
+}
+
+// Runs a round several times, and returns the median of the nanoseconds per call
+template <typename Round>
+double median_round(long calls, Round round) {
+    std::vector<double> results;
+    for (int i = 0; i < k_rounds; i++){
+        auto begin = std::chrono::steady_clock::now();
+        round();
+        auto end = std::chrono::steady_clock::now();
+        results.push_back(std::chrono::duration<double, std::nano>(end - begin).count() / calls);
+    }//end of for loop
+    std::sort(results.begin(), results.end());
+    return results[results.size() / 2];
+}//end of median_round
+
+// Registers count sites, all with distinct names
+std::vector<long> register_sites(Chronos* profiler, std::string prefix, long count) {
+    std::vector<long> sites;
+    sites.reserve(count);
+    for (long i = 0; i < count; i++){
+        sites.push_back(profiler->register_site(prefix + " " + std::to_string(i)));
+    }//end of for loop
+    return sites;
+}//end of register_sites
+
+BenchmarkResult bench_logging(Chronos* profiler, long calls, bool log) {
+    long site = profiler->register_site(log ? "logging on" : "logging off");
+    double nanoseconds = median_round(calls, [&](){
+        for (long i = 0; i < calls; i++){
+            profiler->start(site, log);
+            clobber();
+            profiler->stop(site, log);
+        }//end of for loop
+    });
+    return {log ? "logging_on" : "logging_off", 1, calls, nanoseconds};
+}//end of bench_logging
+
+BenchmarkResult bench_strings(Chronos* profiler, long calls) {
+    std::string name = "string interface";
+    std::string id = profiler->get_id();
+    double nanoseconds = median_round(calls, [&](){
+        for (long i = 0; i < calls; i++){
+            profiler->start(name, id, true);
+            clobber();
+            profiler->stop(name, id, true);
+        }//end of for loop
+    });
+    return {"string_interface", 1, calls, nanoseconds};
+}//end of bench_strings
+
+BenchmarkResult bench_sites(Chronos* profiler, long calls, long count) {
+    std::vector<long> sites = register_sites(profiler, "site of " + std::to_string(count), count);
+    // Record every site once first, so their buffers are allocated before the timing starts
+    for (long site: sites){
+        profiler->start(site);
+        profiler->stop(site);
+    }//end of for loop
+    double nanoseconds = median_round(calls, [&](){
+        for (long i = 0; i < calls; i++){
+            long site = sites[i % count];
+            profiler->start(site);
+            clobber();
+            profiler->stop(site);
+        }//end of for loop
+    });
+    return {"sites", count, calls, nanoseconds};
+}//end of bench_sites
+
+void recurse(Chronos* profiler, long site, long depth) {
+    profiler->start(site);
+    if (depth > 1){
+        recurse(profiler, site, depth - 1);
+    }//end of if
+    clobber();
+    profiler->stop(site);
+}//end of recurse
+
+BenchmarkResult bench_recursion(Chronos* profiler, long calls, long depth) {
+    long site = profiler->register_site("recursion of " + std::to_string(depth));
+    long repeats = std::max(1l, calls / depth);
+    double nanoseconds = median_round(repeats * depth, [&](){
+        for (long i = 0; i < repeats; i++){
+            recurse(profiler, site, depth);
+        }//end of for loop
+    });
+    return {"recursion_depth", depth, repeats * depth, nanoseconds};
+}//end of bench_recursion
+
+BenchmarkResult bench_threads(Chronos* profiler, long calls, long count) {
+    long site = profiler->register_site("threads of " + std::to_string(count));
+    // The workers are started before the first round and joined after the last, so only their calls are timed. Every round
+    // releases them all at once, and ends when the last of them is done
+    std::atomic<long> released(0);
+    std::atomic<long> finished(0);
+    std::vector<std::thread> workers;
+    for (long t = 0; t < count; t++){
+        workers.push_back(std::thread([&](){
+            for (long round = 1; round <= k_rounds; round++){
+                while (released.load() < round){
+                    std::this_thread::yield();
+                }//end of while
+                for (long i = 0; i < calls; i++){
+                    profiler->start(site);
+                    clobber();
+                    profiler->stop(site);
+                }//end of for loop
+                finished++;
+            }//end of for loop
+        }));
+    }//end of for loop
+    // Every thread makes the same number of calls, so the cost per call stays flat as long as the threads do not interfere
+    double nanoseconds = median_round(calls, [&](){
+        long round = ++released;
+        while (finished.load() < round * count){
+            std::this_thread::yield();
+        }//end of while
+    });
+    for (std::thread& worker: workers){
+        worker.join();
+    }//end of for loop
+    return {"threads", count, calls * count, nanoseconds};
+}//end of bench_threads
+
+// Takes and releases an uncontended lock, so the cost of the contention statistics can be compared with a raw std::mutex
+template <typename Mutex>
+BenchmarkResult bench_mutex(std::string scenario, long calls) {
+    Mutex mutex;
+    long value = 0;
+    double nanoseconds = median_round(calls, [&](){
+        for (long i = 0; i < calls; i++){
+            std::lock_guard<Mutex> lock(mutex);
+            value++;
+            clobber();
+        }//end of for loop
+    });
+    return {scenario, 1, calls, nanoseconds};
+}//end of bench_mutex
+
+void print_csv(std::vector<BenchmarkResult>& results) {
+    std::cout << "Scenario,Parameter,Calls,Nanoseconds Per Call\n";
+    for (BenchmarkResult& result: results){
+        std::cout << result.scenario << ',' << result.parameter << ',' << result.calls << ',' << result.nanoseconds << '\n';
+    }//end of for loop
+}//end of print_csv
+
+void print_json(std::vector<BenchmarkResult>& results, Chronos* profiler) {
+    std::cout << "{\"clock\":\"" << ChronosClock::get_name() << "\",\"rounds\":" << k_rounds << ",\"results\":[";
+    for (unsigned long i = 0; i < results.size(); i++){
+        BenchmarkResult& result = results[i];
+        std::cout << (i > 0 ? "," : "") << "\n{\"scenario\":\"" << result.scenario << "\",\"parameter\":" << result.parameter
+                  << ",\"calls\":" << result.calls << ",\"ns_per_call\":" << result.nanoseconds << '}';
+    }//end of for loop
+    double nanoseconds = ChronosClock::get_seconds_per_tick() * 1e9;
+    ChronosOverhead& overhead = profiler->get_overhead();
+    std::cout << "\n],\"calibrated_ns\":{\"inner\":" << overhead.get_inner_cost() * nanoseconds << ",\"timed\":"
+              << overhead.get_timed_cost() * nanoseconds << ",\"untimed\":" << overhead.get_untimed_cost() * nanoseconds << "}}\n";
+}//end of print_json
+
+int main(int argc, char** argv){
+    bool json = false;
+    long calls = 1000000;
+    long max_threads = std::max(1l, static_cast<long>(std::thread::hardware_concurrency()));
+    for (int i = 1; i < argc; i++){
+        if (std::strcmp(argv[i], "--json") == 0){
+            json = true;
+        }else if (std::strcmp(argv[i], "--calls") == 0 && i + 1 < argc){
+            calls = std::max(1l, std::atol(argv[++i]));
+        }else if (std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc){
+            max_threads = std::max(1l, std::atol(argv[++i]));
+        }else{
+            std::cerr << "Usage: " << argv[0] << " [--json] [--calls N] [--threads N]" << std::endl;
+            return 2;
+        }//end of if else
+    }//end of for loop
+
+    Chronos* profiler = Chronos::get_instance();
+    std::vector<BenchmarkResult> results;
+    results.push_back(bench_logging(profiler, calls, false));
+    results.push_back(bench_logging(profiler, calls, true));
+    results.push_back(bench_strings(profiler, calls));
+    results.push_back(bench_mutex<std::mutex>("std_mutex", calls));
+    results.push_back(bench_mutex<Chronos::mutex>("chronos_mutex", calls));
+    for (long count = 1; count <= 100000; count *= 10){
+        results.push_back(bench_sites(profiler, calls, count));
+    }//end of for loop
+    for (long depth = 1; depth <= 4096; depth *= 8){
+        results.push_back(bench_recursion(profiler, calls, depth));
+    }//end of for loop
+    for (long count = 1; count < max_threads; count *= 2){
+        results.push_back(bench_threads(profiler, calls, count));
+    }//end of for loop
+    results.push_back(bench_threads(profiler, calls, max_threads));
+
+    if (json){
+        print_json(results, profiler);
+    }else{
+        print_csv(results);
+    }//end of if else
+    delete profiler;
+    return 0;
+}
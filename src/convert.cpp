@@ -0,0 +1,94 @@
+/**   Copyright 2020 Benrick Smit
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+*/
+/**
+ * @author: Benrick Smit
+ * @email: metatronicprogramming@hotmail.com
+ * @date: 13 June 2020
+ * @modified: 13 June 2020
+ *
+ * @brief: This program converts a binary profile, ChronosProfile.bin, to the text reports Chronos::friendly_stop writes:
+ *          ChronosProfile.csv, ChronosProfile.txt and ChronosHistograms.csv. Without options all three are written next to
+ *          the profile; with options only those asked for are written, to the paths given. It exits with 1 when the profile
+ *          can not be read or a report can not be written.
+ *
+ *          Usage: Chronos_Convert [--csv PATH] [--txt PATH] [--histograms PATH] PROFILE
+ *
+ */
+
+
+#include <filesystem>
+#include <iostream>
+#include <string>
+
+#include "include/Chronos/ChronosProfileReader.h"
+
+void print_usage(const char* program) {
+    std::cerr << "Usage: " << program << " [--csv PATH] [--txt PATH] [--histograms PATH] PROFILE" << std::endl;
+}//end of print_usage
+
+int main(int argc, char** argv){
+    std::string csv_path;
+    std::string txt_path;
+    std::string histogram_path;
+    std::string profile_path;
+    for (int i = 1; i < argc; i++){
+        std::string argument = argv[i];
+        std::string* path = nullptr;
+        if (argument == "--csv"){
+            path = &csv_path;
+        }else if (argument == "--txt"){
+            path = &txt_path;
+        }else if (argument == "--histograms"){
+            path = &histogram_path;
+        }else if (argument.compare(0, 2, "--") != 0 && profile_path.empty()){
+            profile_path = argument;
+            continue;
+        }//end of if else
+        if (path == nullptr || i + 1 >= argc){
+            print_usage(argv[0]);
+            return 2;
+        }//end of if
+        *path = argv[++i];
+    }//end of for loop
+    if (profile_path.empty()){
+        print_usage(argv[0]);
+        return 2;
+    }//end of if
+    // Without any paths, every report goes next to the profile
+    if (csv_path.empty() && txt_path.empty() && histogram_path.empty()){
+        std::filesystem::path directory = std::filesystem::path(profile_path).parent_path();
+        csv_path = (directory / "ChronosProfile.csv").string();
+        txt_path = (directory / "ChronosProfile.txt").string();
+        histogram_path = (directory / "ChronosHistograms.csv").string();
+    }//end of if
+
+    ChronosProfileReader reader;
+    if (!reader.open(profile_path)){
+        std::cerr << "Error reading file: \"" << profile_path << "\" is not a Chronos profile" << std::endl;
+        return 1;
+    }//end of if
+    bool written = true;
+    if (!csv_path.empty()){
+        written = reader.write_csv(csv_path) && written;
+    }//end of if
+    if (!txt_path.empty()){
+        written = reader.write_txt(txt_path) && written;
+    }//end of if
+    if (!histogram_path.empty()){
+        written = reader.write_histograms(histogram_path) && written;
+    }//end of if
+    std::cout << profile_path << ": " << reader.get_record_count() << " functions over " << reader.get_thread_count() << " threads" << std::endl;
+    return written ? 0 : 1;
+}
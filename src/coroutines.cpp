@@ -0,0 +1,218 @@
+/**   Copyright 2020 Benrick Smit
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ * 
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+*/
+/**
+ * @author: Benrick Smit
+ * @email: metatronicprogramming@hotmail.com
+ * @date: 13 June 2020
+ * @modified: 13 June 2020
+ *
+ * @brief: This program shows how ChronosSpan times coroutines. Every request hops onto a small pool of threads, waits on
+ *          timers standing in for I/O, and awaits a child coroutine, so it is suspended on one thread and resumed on another.
+ *          The spans keep the time the requests were running apart from their latency, and keep every child below its
+ *          request, in profiler/ChronosSpans.csv and at the end of profiler/ChronosProfile.txt. Needs C++20.
+ *
+ *          Usage: Chronos_Coroutines [--requests N]
+ *
+ */
+
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <coroutine>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "include/Chronos/Chronos.h"
+#include "include/Chronos/ChronosSpan.h"
+
+using Clock = std::chrono::steady_clock;
+
+// A few threads which resume the coroutines handed to them, each once it is due
+class Pool {
+    public:
+        explicit Pool(int threads) {
+            for (int i = 0; i < threads; i++){
+                m_workers.push_back(std::thread([this](){ run(); }));
+            }//end of for loop
+        }
+        ~Pool() {
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_running = false;
+            }
+            m_wake.notify_all();
+            for (std::thread& worker: m_workers){
+                worker.join();
+            }//end of for loop
+        }
+
+        void post(std::coroutine_handle<> handle, Clock::time_point due = Clock::now()) {
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_queue.emplace(due, handle);
+            }
+            m_wake.notify_one();
+        }
+
+        // Resumes the awaiting coroutine on one of the threads of the pool, after the delay
+        struct Resume {
+            Pool& pool;
+            std::chrono::microseconds delay;
+            bool await_ready() { return false; }
+            void await_suspend(std::coroutine_handle<> handle) { pool.post(handle, Clock::now() + delay); }
+            void await_resume() {}
+        };
+        Resume schedule() { return {*this, std::chrono::microseconds(0)}; }
+        Resume sleep(std::chrono::microseconds delay) { return {*this, delay}; }
+
+    private:
+        void run() {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            while (m_running){
+                if (m_queue.empty()){
+                    m_wake.wait(lock);
+                }else if (m_queue.begin()->first > Clock::now()){
+                    m_wake.wait_until(lock, m_queue.begin()->first);
+                }else{
+                    std::coroutine_handle<> handle = m_queue.begin()->second;
+                    m_queue.erase(m_queue.begin());
+                    lock.unlock();
+                    handle.resume();
+                    lock.lock();
+                }//end of if else
+            }//end of while
+        }
+
+        std::mutex m_mutex;
+        std::condition_variable m_wake;
+        std::multimap<Clock::time_point, std::coroutine_handle<>> m_queue;
+        std::vector<std::thread> m_workers;
+        bool m_running = true;
+};
+
+// A coroutine which starts when it is awaited, and resumes its caller when it is done
+struct Task {
+    struct promise_type {
+        std::coroutine_handle<> caller;
+
+        struct Finish {
+            bool await_ready() noexcept { return false; }
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<promise_type> handle) noexcept {
+                return handle.promise().caller ? handle.promise().caller : std::noop_coroutine();
+            }
+            void await_resume() noexcept {}
+        };
+
+        Task get_return_object() { return Task(std::coroutine_handle<promise_type>::from_promise(*this)); }
+        std::suspend_always initial_suspend() noexcept { return {}; }
+        Finish final_suspend() noexcept { return {}; }
+        void return_void() {}
+        void unhandled_exception() { std::terminate(); }
+    };
+
+    explicit Task(std::coroutine_handle<promise_type> handle) : handle(handle) {}
+    Task(Task&& other) noexcept : handle(other.handle) { other.handle = nullptr; }
+    ~Task() {
+        if (handle){
+            handle.destroy();
+        }//end of if
+    }
+
+    bool await_ready() { return false; }
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> caller) {
+        handle.promise().caller = caller;
+        return handle;
+    }
+    void await_resume() {}
+
+    std::coroutine_handle<promise_type> handle;
+};
+
+// A coroutine which runs on its own, for the requests
+struct Detached {
+    struct promise_type {
+        Detached get_return_object() { return {}; }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() {}
+        void unhandled_exception() { std::terminate(); }
+    };
+};
+
+// Keeps the thread busy, which is what the active time of the spans measures
+void work(std::chrono::microseconds duration) {
+    Clock::time_point end = Clock::now() + duration;
+    while (Clock::now() < end){
+    }//end of while
+}//end of work
+
+Task load_record(Pool& pool, ChronosSpan& request) {
+    static const long site = Chronos::get_instance()->register_site("load_record");
+    // The request is suspended while it awaits this coroutine, so it is given as the parent
+    ChronosSpan span(site, &request);
+    co_await chronos_await(span, pool.sleep(std::chrono::microseconds(2000)));
+    work(std::chrono::microseconds(300));
+}//end of load_record
+
+Task handle_request(Pool& pool) {
+    static const long site = Chronos::get_instance()->register_site("handle_request");
+    ChronosSpan span(site);
+    co_await chronos_await(span, pool.schedule());
+    work(std::chrono::microseconds(200));
+    co_await chronos_await(span, load_record(pool, span));
+    co_await chronos_await(span, pool.sleep(std::chrono::microseconds(1000)));
+    work(std::chrono::microseconds(100));
+}//end of handle_request
+
+Detached run_request(Pool& pool, std::atomic<long>& done) {
+    co_await handle_request(pool);
+    done++;
+}//end of run_request
+
+int main(int argc, char** argv){
+    long requests = 200;
+    for (int i = 1; i < argc; i++){
+        if (std::strcmp(argv[i], "--requests") == 0 && i + 1 < argc){
+            requests = std::max(1l, std::atol(argv[++i]));
+        }else{
+            std::cerr << "Usage: " << argv[0] << " [--requests N]" << std::endl;
+            return 2;
+        }//end of if else
+    }//end of for loop
+
+    Chronos* profiler = Chronos::get_instance();
+    std::atomic<long> done(0);
+    {
+        Pool pool(2);
+        for (long i = 0; i < requests; i++){
+            run_request(pool, done);
+        }//end of for loop
+        while (done.load() < requests){
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }//end of while
+    }
+
+    profiler->friendly_stop();
+    std::cout << requests << " requests written to profiler/ChronosSpans.csv and profiler/ChronosProfile.txt" << std::endl;
+    delete profiler;
+    return 0;
+}
@@ -0,0 +1,135 @@
+/**   Copyright 2020 Benrick Smit
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+*/
+/**
+ * @author: Benrick Smit
+ * @email: metatronicprogramming@hotmail.com
+ * @date: 13 June 2020
+ * @modified: 13 June 2020
+ *
+ * @brief: This program compares a candidate profile with a baseline, and exits with 1 when a function got slower than the
+ *          limits allow, so it can fail a build. The profiles may be .csv reports of any version of Chronos, binary profiles, or profiler
+ *          directories, whose histograms give a sharper significance test and nanosecond percentiles. The limits are the
+ *          largest increases, in percent, of the total, mean and percentile times; none are checked unless given.
+ *
+ *          Usage: Chronos_Diff [options] BASELINE CANDIDATE
+ *              --max-total PCT, --max-mean PCT, --max-p50 PCT, --max-p90 PCT, --max-p99 PCT
+ *              --alpha P           the largest p value of a change that counts, 0.05 by default
+ *              --min-calls N       skip the functions called less often in either profile
+ *              --min-time SECONDS  skip the functions with less total time in both profiles
+ *              --top N             the rows printed, 20 by default, 0 for all
+ *              --csv               print every row as .csv instead
+ *
+ */
+
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "include/Chronos/ChronosDiff.h"
+
+void print_usage(const char* program) {
+    std::cerr << "Usage: " << program << " [--max-total PCT] [--max-mean PCT] [--max-p50 PCT] [--max-p90 PCT] [--max-p99 PCT]"
+              << " [--alpha P] [--min-calls N] [--min-time SECONDS] [--top N] [--csv] BASELINE CANDIDATE" << std::endl;
+}//end of print_usage
+
+int main(int argc, char** argv){
+    ChronosDiffOptions options;
+    long top = 20;
+    bool csv = false;
+    std::vector<std::string> paths;
+    for (int i = 1; i < argc; i++){
+        std::string argument = argv[i];
+        double* limit = nullptr;
+        if (argument == "--max-total"){
+            limit = &options.max_total_increase;
+        }else if (argument == "--max-mean"){
+            limit = &options.max_mean_increase;
+        }else if (argument == "--max-p50"){
+            limit = &options.max_p50_increase;
+        }else if (argument == "--max-p90"){
+            limit = &options.max_p90_increase;
+        }else if (argument == "--max-p99"){
+            limit = &options.max_p99_increase;
+        }else if (argument == "--alpha"){
+            limit = &options.alpha;
+        }else if (argument == "--min-calls"){
+            limit = &options.min_calls;
+        }else if (argument == "--min-time"){
+            limit = &options.min_time;
+        }else if (argument == "--top" && i + 1 < argc){
+            top = std::max(0l, std::atol(argv[++i]));
+            continue;
+        }else if (argument == "--csv"){
+            csv = true;
+            continue;
+        }else if (argument.compare(0, 2, "--") != 0){
+            paths.push_back(argument);
+            continue;
+        }//end of if else
+        if (limit == nullptr || i + 1 >= argc){
+            print_usage(argv[0]);
+            return 2;
+        }//end of if
+        // A trailing % is allowed on the limits
+        *limit = std::strtod(argv[++i], nullptr);
+    }//end of for loop
+    if (paths.size() != 2){
+        print_usage(argv[0]);
+        return 2;
+    }//end of if
+
+    ChronosDiff diff;
+    if (!diff.load(paths[0], true) || !diff.load(paths[1], false)){
+        return 2;
+    }//end of if
+    // An empty profile would pass every limit, so it is an error rather than a clean comparison
+    for (int side = 0; side < 2; side++){
+        if (diff.get_site_count(side == 0) == 0){
+            std::cerr << "No functions found in: \"" << paths[side] << "\"" << std::endl;
+            return 2;
+        }//end of if
+    }//end of for loop
+    std::vector<ChronosDiffResult> results = diff.compare(options);
+
+    long regressed = 0;
+    long added = 0;
+    long removed = 0;
+    for (ChronosDiffResult& result: results){
+        regressed += result.status == "regressed" ? 1 : 0;
+        added += result.status == "added" ? 1 : 0;
+        removed += result.status == "removed" ? 1 : 0;
+    }//end of for loop
+    if (csv){
+        std::cout << ChronosDiff::get_header_csv() << '\n';
+        for (ChronosDiffResult& result: results){
+            std::cout << ChronosDiff::to_csv(result) << '\n';
+        }//end of for loop
+    }else{
+        std::cout << "Baseline: " << paths[0] << ", " << diff.get_site_count(true) << " functions\n"
+                  << "Candidate: " << paths[1] << ", " << diff.get_site_count(false) << " functions\n"
+                  << regressed << " regressed, " << added << " added, " << removed << " removed\n\n"
+                  << ChronosDiff::get_header() << '\n';
+        long rows = top > 0 ? std::min(top, static_cast<long>(results.size())) : static_cast<long>(results.size());
+        for (long i = 0; i < rows; i++){
+            std::cout << ChronosDiff::to_string(results[i]) << '\n';
+        }//end of for loop
+    }//end of if else
+    std::cout.flush();
+    return regressed > 0 ? 1 : 0;
+}
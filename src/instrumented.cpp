@@ -0,0 +1,95 @@
+/**   Copyright 2020 Benrick Smit
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ * 
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+*/
+/**
+ * @author: Benrick Smit
+ * @email: metatronicprogramming@hotmail.com
+ * @date: 13 June 2020
+ * @modified: 13 June 2020
+ *
+ * @brief: This program shows how a module is profiled through -finstrument-functions. None of its functions calls the
+ *          profiler; the compiler calls the hooks around every one of them, and the names are read from the symbols when
+ *          friendly_stop writes the reports. The functions to profile can be chosen through the environment, with the
+ *          demangled names or module paths to keep or leave out, separated by commas. Needs the CHRONOS_INSTRUMENT option.
+ *
+ *          Usage: CHRONOS_INCLUDE=PATTERNS CHRONOS_EXCLUDE=PATTERNS Chronos_Instrumented
+ *
+ */
+
+
+#include <algorithm>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "include/Chronos/Chronos.h"
+
+bool is_prime(long value){
+    if (value < 2){
+        return false;
+    }//end of if
+    for (long divisor = 2; divisor * divisor <= value; divisor++){
+        if (value % divisor == 0){
+            return false;
+        }//end of if
+    }//end of for loop
+    return true;
+}//end of is_prime
+
+long count_primes(long limit){
+    long count = 0;
+    for (long value = 0; value < limit; value++){
+        count += is_prime(value) ? 1 : 0;
+    }//end of for loop
+    return count;
+}//end of count_primes
+
+long fibb(long value){
+    if (value < 2){
+        return value;
+    }//end of if
+    return fibb(value - 1) + fibb(value - 2);
+}//end of fibb
+
+std::vector<long> shuffled(long count){
+    std::vector<long> values;
+    for (long i = 0; i < count; i++){
+        values.push_back((i * 7919) % count);
+    }//end of for loop
+    return values;
+}//end of shuffled
+
+long sort_values(long count){
+    std::vector<long> values = shuffled(count);
+    std::sort(values.begin(), values.end());
+    return values.back();
+}//end of sort_values
+
+int main(){
+    Chronos *profiler = Chronos::get_instance();
+    // Every function of this file is profiled from here on, within about 1% of its time
+    if (!profiler->enable_instrumentation()){
+        std::cerr << "The instrumentation hooks are not compiled in, configure with -DCHRONOS_INSTRUMENT=ON" << std::endl;
+    }//end of if
+
+    std::cout << "Primes below 20000: " << count_primes(20000) << std::endl;
+    std::cout << "Fibbonacci Sequence 20: " << fibb(20) << std::endl;
+    std::cout << "Largest of 100000 sorted: " << sort_values(100000) << std::endl;
+
+    profiler->enable_instrumentation(false);
+    profiler->friendly_stop();
+    std::cout << "The functions are in profiler/ChronosProfile.txt and profiler/ChronosCallGraph.txt" << std::endl;
+    delete profiler;
+    return 0;
+}
@@ -23,65 +23,141 @@
  */ 
 
 
+#include <chrono>
 #include <cstdio>
 #include <iostream>
+#include <thread>
+#include <vector>
 
 #include "include/Chronos/Chronos.h"
+#include "include/Chronos/ChronosScope.h"
 
 #define PROFILER_LOG true
 
 long fibb(long value){
-    Chronos *profiler = profiler->get_instance();
-    std::string id = profiler->get_id();
-    profiler->start(__PRETTY_FUNCTION__, id, PROFILER_LOG);
+    // The scope stops the timing on every return, so there is no need for a stop before each exit point
+    CHRONOS_FUNCTION();
 
     if (value < 2){
-        profiler->stop(__PRETTY_FUNCTION__, id, PROFILER_LOG);
         return value;
     }else {
-        profiler->stop(__PRETTY_FUNCTION__, id, PROFILER_LOG);
         return fibb(value - 1) + fibb(value - 2);
     }//end of if
 }//end of fibb
 
 long counter(long count){
     Chronos *profiler = profiler->get_instance();
-    std::string id = profiler->get_id();
-    profiler->start(__PRETTY_FUNCTION__, id, PROFILER_LOG);
+    static const long site = profiler->register_site(__PRETTY_FUNCTION__);
+    profiler->start(site, PROFILER_LOG);
     
     long value = 1;
     for (long i = 1; i < count; i++){
         value *= i;
     }//end of for loop
 
-    profiler->stop(__PRETTY_FUNCTION__, id, PROFILER_LOG);
+    profiler->stop(site, PROFILER_LOG);
     return value;
 }//end of counter
 
 long factorial(long val){
-    Chronos *profiler = profiler->get_instance();
-    std::string id = profiler->get_id();
-    profiler->start(__PRETTY_FUNCTION__, id, PROFILER_LOG);
+    CHRONOS_FUNCTION();
     if (val == 1){
-        profiler->stop(__PRETTY_FUNCTION__, id, PROFILER_LOG);
         return 1;
     }else{
-        profiler->stop(__PRETTY_FUNCTION__, id, PROFILER_LOG);
         return val * factorial(val-1);
     }//end of if else
 }//end of factorial
 
+long sleeper(long milliseconds){
+    Chronos *profiler = profiler->get_instance();
+    // Tell the time spent on the CPU apart from the time spent waiting; the sleep shows up as off-CPU time
+    static const long site = [profiler](const char* name){
+        long handle = profiler->register_site(name);
+        profiler->enable_cpu_time(handle);
+        return handle;
+    }(__PRETTY_FUNCTION__);
+    profiler->start(site, PROFILER_LOG);
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(milliseconds));
+    long value = counter(milliseconds);
+
+    profiler->stop(site, PROFILER_LOG);
+    return value;
+}//end of sleeper
+
+long squares(long count){
+    CHRONOS_FUNCTION();
+    // The vector's allocation is added to this function when the allocation hooks are on
+    std::vector<long> values;
+    for (long i = 0; i < count; i++){
+        values.push_back(i * i);
+    }//end of for loop
+    long sum = 0;
+    for (long value: values){
+        sum += value;
+    }//end of for loop
+    return sum;
+}//end of squares
+
 int main(){
     Chronos *profiler = Chronos::get_instance();
+    // Stream every call to profiler/ChronosTrace.bin as well, friendly_stop closes the trace
+    profiler->start_trace();
+    // Short functions called very often are timed only now and then, so the profiler costs at most about 1% of their time
+    profiler->set_adaptive_sampling(true);
+    // Append the calls of every 5 ms to profiler/ChronosWindows.csv while the program runs
+    profiler->start_monitor(0.005);
+    // Read the hardware counters as well, where perf_event_open is allowed
+    profiler->enable_counters();
+    // Count the allocations of every function, when built with -DCHRONOS_ALLOCATIONS=ON
+    profiler->enable_allocations();
     std::string id = profiler->get_id();
     profiler->start(__PRETTY_FUNCTION__, id, PROFILER_LOG);
     
     int num = 10;
     std::cout << std::endl << "Factorial " << num << ": " << factorial(num) << std::endl;
-    std::cout << "Fibbonacci Sequence " << num << ": " << fibb(num) << std::endl << std::endl;
+    std::cout << "Fibbonacci Sequence " << num << ": " << fibb(num) << std::endl;
+    std::cout << "Counter " << num << ": " << counter(num) << std::endl;
+    std::cout << "Squares " << num * 100 << ": " << squares(num * 100) << std::endl;
+    std::cout << "Sleeper " << num << ": " << sleeper(num) << std::endl << std::endl;
+
+    // Every thread records into its own buffer, and friendly_stop merges them. The lock's waits go to the contention section
+    Chronos::mutex total_mutex("total of the workers");
+    long total = 0;
+    std::vector<std::thread> workers;
+    for (int i = 0; i < 4; i++){
+        workers.push_back(std::thread([num, &total_mutex, &total](){
+            for (int j = 0; j < 1000; j++){
+                long value = counter(num);
+                Chronos::lock_guard<Chronos::mutex> lock(total_mutex);
+                total += value;
+            }//end of for loop
+        }));
+    }//end of for loop
+    for (std::thread& worker: workers){
+        worker.join();
+    }//end of for loop
+    std::cout << "Total of the workers: " << total << std::endl;
 
     profiler->stop(__PRETTY_FUNCTION__, id, PROFILER_LOG);
+
+    // Benchmark a function on its own; the results are added to the reports of friendly_stop
+    ChronosBenchmarkOptions options;
+    options.max_time = 0.5;
+    options.items_per_iteration = 100;
+    ChronosBenchmarkResult result = profiler->benchmark("sum of 100 squares", [](){
+        long sum = 0;
+        for (long i = 0; i < 100; i++){
+            ChronosBenchmark::do_not_optimize(i);
+            sum += i * i;
+        }//end of for loop
+        return sum;
+    }, options);
+    std::cout << ChronosBenchmark::to_string(result) << std::endl;
+
     profiler->friendly_stop();
+    // Open profiler/ChronosTrace.json in chrome://tracing or Perfetto to see the calls on a timeline
+    profiler->export_chrome_trace();
     delete profiler;
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,113 @@
+/**   Copyright 2020 Benrick Smit
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ * 
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+*/
+/**
+ * @author: Benrick Smit
+ * @email: metatronicprogramming@hotmail.com
+ * @date: 13 June 2020
+ * @modified: 13 June 2020
+ *
+ * @brief: This program writes the profile merged over all the processes which recorded into a shared memory segment, to
+ *          profiler/ChronosShared.csv and profiler/ChronosShared.txt. It can be run at any time, while the processes are still
+ *          recording or after they have gone. With --workers it first forks a number of worker processes which record into
+ *          the segment, the last of which is killed before it finishes, to show that its calls are kept.
+ *
+ *          Usage: Chronos_Shared [--name NAME] [--workers N] [--remove]
+ *
+ */
+
+
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "include/Chronos/Chronos.h"
+#include "include/Chronos/ChronosScope.h"
+
+long work(long count){
+    CHRONOS_FUNCTION();
+    long value = 0;
+    for (long i = 0; i < count; i++){
+        value += i * i;
+    }//end of for loop
+    return value;
+}//end of work
+
+// Records some calls into the segment, which the parent created before forking
+void run_worker(Chronos* profiler, long worker, bool crash){
+    for (long i = 0; i < 1000 * (worker + 1); i++){
+        work(100);
+    }//end of for loop
+    if (crash){
+        // Gone without friendly_stop, as a crash would be
+        raise(SIGKILL);
+    }//end of if
+    profiler->stop_sharing();
+}//end of run_worker
+
+int main(int argc, char** argv){
+    std::string name = "/chronos";
+    long workers = 0;
+    bool remove = false;
+    for (int i = 1; i < argc; i++){
+        if (std::strcmp(argv[i], "--name") == 0 && i + 1 < argc){
+            name = argv[++i];
+        }else if (std::strcmp(argv[i], "--workers") == 0 && i + 1 < argc){
+            workers = std::max(0l, std::atol(argv[++i]));
+        }else if (std::strcmp(argv[i], "--remove") == 0){
+            remove = true;
+        }else{
+            std::cerr << "Usage: " << argv[0] << " [--name NAME] [--workers N] [--remove]" << std::endl;
+            return 2;
+        }//end of if else
+    }//end of for loop
+
+    Chronos* profiler = Chronos::get_instance();
+    if (workers > 0){
+        // Start from an empty segment, which every forked worker records into with a slot of its own
+        Chronos::remove_shared(name);
+        if (!profiler->share(name)){
+            return 1;
+        }//end of if
+        std::vector<pid_t> children;
+        for (long worker = 0; worker < workers; worker++){
+            pid_t child = fork();
+            if (child == 0){
+                run_worker(profiler, worker, worker == workers - 1 && workers > 1);
+                _exit(0);
+            }//end of if
+            children.push_back(child);
+        }//end of for loop
+        for (pid_t child: children){
+            waitpid(child, nullptr, 0);
+        }//end of for loop
+        profiler->stop_sharing();
+    }//end of if
+
+    bool written = profiler->write_shared_profile(name);
+    if (written){
+        std::cout << "Wrote profiler/ChronosShared.csv and profiler/ChronosShared.txt" << std::endl;
+    }//end of if
+    if (remove){
+        Chronos::remove_shared(name);
+    }//end of if
+    delete profiler;
+    return written ? 0 : 1;
+}